@@ -0,0 +1,17 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thread>
+#include "GeodesicPacket.hpp"
+
+// Records the CPU configuration in the report context so JSON results from
+// different machines or builds can be told apart when diffing them.
+int main(int argc, char** argv) {
+    benchmark::AddCustomContext("simd_isa", GeodesicPacket::isaName(GeodesicPacket::detectIsa()));
+    benchmark::AddCustomContext("hardware_threads", std::to_string(std::thread::hardware_concurrency()));
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
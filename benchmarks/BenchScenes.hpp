@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+
+// Fixed scenes shared by the benchmarks so results stay comparable between builds
+namespace BenchScenes {
+
+// Up to four black holes; the first one is the default scene from main.cpp
+inline World makeWorld(int numBlackHoles) {
+    static const struct { glm::vec3 pos; float mass; } kBlackHoles[] = {
+        { glm::vec3(0.0f, -10.0f, -50.0f), 0.5f },
+        { glm::vec3(-25.0f, -5.0f, -80.0f), 0.8f },
+        { glm::vec3(30.0f, 5.0f, -70.0f), 0.4f },
+        { glm::vec3(10.0f, 15.0f, -120.0f), 1.5f },
+    };
+
+    World world;
+    for (int i = 0; i < numBlackHoles && i < 4; ++i) {
+        world.add(BlackHole(kBlackHoles[i].pos, kBlackHoles[i].mass));
+    }
+    return world;
+}
+
+inline std::vector<Geodesic::BlackHoleData> makeBlackHoles(int numBlackHoles) {
+    return Geodesic::gatherBlackHoles(makeWorld(numBlackHoles));
+}
+
+// Deterministic, normalized directions spread over the camera's default view
+inline std::vector<glm::vec3> makeDirections(int count) {
+    std::vector<glm::vec3> dirs;
+    dirs.reserve(count);
+    for (int k = 0; k < count; ++k) {
+        float u = Geodesic::hash(glm::vec3((float)k, 1.0f, 2.0f)) - 0.5f;
+        float v = Geodesic::hash(glm::vec3((float)k, 3.0f, 4.0f)) - 0.5f;
+        dirs.push_back(glm::normalize(glm::vec3(u * 0.8f, v * 0.8f - 0.2f, -1.0f)));
+    }
+    return dirs;
+}
+
+} // namespace BenchScenes
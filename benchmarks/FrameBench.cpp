@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+#include "BenchScenes.hpp"
+#include "Camera.hpp"
+#include "CpuRenderer.hpp"
+
+namespace {
+
+// Full CPU frames from the default camera: (width, height, black holes)
+void BM_RenderFrame(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    World world = BenchScenes::makeWorld(static_cast<int>(state.range(2)));
+    Camera camera;
+
+    static CpuRenderer renderer; // One pool for the whole run, like the app
+    uint64_t steps = 0;
+    uint64_t skipped = 0;
+    for (auto _ : state) {
+        renderer.render(camera, world, width, height);
+        steps += renderer.getLastFrameSteps();
+        skipped += renderer.getLastFrameSkippedRays();
+    }
+
+    double rays = static_cast<double>(width) * height * state.iterations();
+    state.counters["rays/s"] = benchmark::Counter(rays, benchmark::Counter::kIsRate);
+    state.counters["steps/s"] = benchmark::Counter(static_cast<double>(steps), benchmark::Counter::kIsRate);
+    state.counters["steps/ray"] = static_cast<double>(steps) / rays;
+    state.counters["skipped"] = static_cast<double>(skipped) / rays; // Share never marched
+}
+BENCHMARK(BM_RenderFrame)
+    ->ArgNames({ "w", "h", "bh" })
+    ->ArgsProduct({ { 1280 }, { 720 }, { 1, 2, 3, 4 } })
+    ->ArgsProduct({ { 1920 }, { 1080 }, { 1, 2, 3, 4 } })
+    ->ArgsProduct({ { 3840 }, { 2160 }, { 1, 2, 3, 4 } })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// The single black-hole scene shaded from a DeflectionTable. The table is
+// built (and cached) before timing starts.
+void BM_RenderFrameDeflectionLut(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    World world = BenchScenes::makeWorld(1);
+    Camera camera;
+
+    static CpuRenderer renderer;
+    renderer.setDeflectionLut(true);
+    renderer.render(camera, world, width, height);
+    uint64_t steps = 0;
+    uint64_t skipped = 0;
+    for (auto _ : state) {
+        renderer.render(camera, world, width, height);
+        steps += renderer.getLastFrameSteps();
+        skipped += renderer.getLastFrameSkippedRays();
+    }
+    renderer.setDeflectionLut(false);
+
+    double rays = static_cast<double>(width) * height * state.iterations();
+    state.counters["rays/s"] = benchmark::Counter(rays, benchmark::Counter::kIsRate);
+    state.counters["steps/ray"] = static_cast<double>(steps) / rays;
+    state.counters["skipped"] = static_cast<double>(skipped) / rays; // Share never marched
+}
+BENCHMARK(BM_RenderFrameDeflectionLut)
+    ->ArgNames({ "w", "h" })
+    ->Args({ 1280, 720 })
+    ->Args({ 1920, 1080 })
+    ->Args({ 3840, 2160 })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+#include "BenchScenes.hpp"
+#include "Geodesic.hpp"
+#include "SkyMap.hpp"
+
+namespace {
+
+const glm::vec3 kCameraPos(0.0f, 0.0f, 3.0f);
+
+// One adaptive integration step. Rays restart from the camera when they
+// terminate, so the mix of near-hole and open-space steps matches a frame.
+void BM_GeodesicStep(benchmark::State& state) {
+    auto blackHoles = BenchScenes::makeBlackHoles(static_cast<int>(state.range(0)));
+    auto dirs = BenchScenes::makeDirections(1024);
+
+    size_t next = 0;
+    Geodesic::RayState ray{ kCameraPos, dirs[0], glm::vec3(0.0f) };
+    for (auto _ : state) {
+        Geodesic::StepResult result = Geodesic::step(ray, blackHoles.data(), static_cast<int>(blackHoles.size()));
+        if (result != Geodesic::StepResult::Continue) {
+            next = (next + 1) % dirs.size();
+            ray = { kCameraPos, dirs[next], glm::vec3(0.0f) };
+        }
+        benchmark::DoNotOptimize(ray);
+    }
+    state.counters["steps/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                   benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GeodesicStep)->DenseRange(1, 4);
+
+// Whole rays through the scalar marcher; second argument 0 = Newtonian, 1 = Schwarzschild RK45
+void BM_TraceGeodesic(benchmark::State& state) {
+    auto blackHoles = BenchScenes::makeBlackHoles(static_cast<int>(state.range(0)));
+    auto dirs = BenchScenes::makeDirections(1024);
+    Geodesic::MarchParams params;
+    params.integrator = static_cast<Geodesic::Integrator>(state.range(1));
+
+    size_t next = 0;
+    uint64_t steps = 0;
+    for (auto _ : state) {
+        int raySteps = 0;
+        glm::vec3 color = Geodesic::traceGeodesic(kCameraPos, dirs[next], blackHoles.data(),
+                                                  static_cast<int>(blackHoles.size()), &raySteps, params);
+        benchmark::DoNotOptimize(color);
+        steps += raySteps;
+        next = (next + 1) % dirs.size();
+    }
+    state.counters["rays/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                  benchmark::Counter::kIsRate);
+    state.counters["steps/s"] = benchmark::Counter(static_cast<double>(steps), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_TraceGeodesic)->ArgsProduct({ { 1, 2, 3, 4 }, { 0, 1 } });
+
+// Sky lookups for escaped rays (GetStarfield includes GetNebula)
+void BM_Starfield(benchmark::State& state) {
+    auto dirs = BenchScenes::makeDirections(4096);
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Geodesic::getStarfield(dirs[next]));
+        next = (next + 1) % dirs.size();
+    }
+    state.counters["rays/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                  benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Starfield);
+
+void BM_Nebula(benchmark::State& state) {
+    auto dirs = BenchScenes::makeDirections(4096);
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Geodesic::getNebula(dirs[next]));
+        next = (next + 1) % dirs.size();
+    }
+    state.counters["rays/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                  benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Nebula);
+
+// The same lookup in the baked cubemap, at the mip level given as the argument
+void BM_SkyMap(benchmark::State& state) {
+    static const SkyMap map(Geodesic::SkyParams(), SkyMap::DEFAULT_FACE_SIZE);
+    Geodesic::Sky sky{ &map, static_cast<float>(state.range(0)), Geodesic::SkyParams() };
+    auto dirs = BenchScenes::makeDirections(4096);
+    size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sky.sample(dirs[next]));
+        next = (next + 1) % dirs.size();
+    }
+    state.counters["rays/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                  benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SkyMap)->Arg(0)->Arg(2);
+
+// Baking a cubemap of the given face size on one thread, paid once per sky setting
+void BM_BakeSky(benchmark::State& state) {
+    for (auto _ : state) {
+        SkyMap map(Geodesic::SkyParams(), static_cast<int>(state.range(0)));
+        benchmark::DoNotOptimize(map.getLevel(0));
+    }
+    state.SetItemsProcessed(state.iterations() * SkyMap::FACES * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_BakeSky)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+// Copying a scene of N black holes out of the World pools, done on every scene change
+void BM_GatherBlackHoles(benchmark::State& state) {
+    World world;
+    int count = static_cast<int>(state.range(0));
+    for (int i = 0; i < count; ++i) {
+        world.add(BlackHole(glm::vec3((float)i, 0.0f, -50.0f), 0.5f));
+    }
+
+    for (auto _ : state) {
+        auto blackHoles = Geodesic::gatherBlackHoles(world);
+        benchmark::DoNotOptimize(blackHoles.data());
+    }
+    state.counters["objects/s"] = benchmark::Counter(static_cast<double>(count) * state.iterations(),
+                                                     benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GatherBlackHoles)->RangeMultiplier(10)->Range(100, 100000);
+
+} // namespace
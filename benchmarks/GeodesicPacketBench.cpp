@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+#include "GeodesicPacket.hpp"
+#include <vector>
+
+using GeodesicPacket::Isa;
+
+namespace {
+
+// One 256x256 block of camera rays looking at the default black hole
+struct RayBlock {
+    static constexpr int kSize = 256;
+    glm::vec3 origin = glm::vec3(0.0f, 0.0f, 3.0f);
+    std::vector<float> x, y, z, rgb;
+
+    RayBlock() : rgb(kSize * kSize * 3) {
+        for (int j = 0; j < kSize; ++j) {
+            for (int i = 0; i < kSize; ++i) {
+                float u = (i + 0.5f) / kSize - 0.5f;
+                float v = (j + 0.5f) / kSize - 0.5f;
+                glm::vec3 d = glm::normalize(glm::vec3(u * 0.8f, v * 0.8f - 0.2f, -1.0f));
+                x.push_back(d.x);
+                y.push_back(d.y);
+                z.push_back(d.z);
+            }
+        }
+    }
+};
+
+const Geodesic::BlackHoleData kBlackHole{ glm::vec3(0.0f, -10.0f, -50.0f), 1.0f, 3.0f, 9.0f };
+
+void BM_TraceRays(benchmark::State& state, Isa isa) {
+    if (!GeodesicPacket::isSupported(isa)) {
+        state.SkipWithError("ISA not supported on this CPU");
+        return;
+    }
+
+    RayBlock block;
+    int count = static_cast<int>(block.x.size());
+    uint64_t steps = 0;
+    uint64_t skipped = 0;
+    for (auto _ : state) {
+        steps += GeodesicPacket::traceRays(isa, block.origin, block.x.data(), block.y.data(), block.z.data(), count,
+                                           &kBlackHole, 1, block.rgb.data(), Geodesic::MarchParams(),
+                                           Geodesic::Sky(), &skipped);
+        benchmark::DoNotOptimize(block.rgb.data());
+    }
+    state.counters["rays/s"] = benchmark::Counter(static_cast<double>(count) * state.iterations(),
+                                                  benchmark::Counter::kIsRate);
+    state.counters["steps/s"] = benchmark::Counter(static_cast<double>(steps), benchmark::Counter::kIsRate);
+    state.counters["skipped"] = static_cast<double>(skipped) / (static_cast<double>(count) * state.iterations());
+}
+
+} // namespace
+
+// Scalar vs. SIMD packet marching over the same rays
+BENCHMARK_CAPTURE(BM_TraceRays, scalar, Isa::Scalar)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraceRays, sse41, Isa::SSE41)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraceRays, avx2, Isa::AVX2)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraceRays, avx512, Isa::AVX512)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "SceneFile.hpp"
+#include "World.hpp"
+
+namespace {
+
+// The default black hole plus N background objects, saved in both forms once per size
+std::string sceneFile(int numObjects, bool binary) {
+    std::string path = (std::filesystem::temp_directory_path()
+                        / ("bench_scene_" + std::to_string(numObjects) + (binary ? ".bscene" : ".scene"))).string();
+    if (!std::filesystem::exists(path)) {
+        World world;
+        world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+        for (int i = 0; i < numObjects; ++i) {
+            world.add(Object(glm::vec3((float)(i % 1000), (float)(i / 1000), -4000.0f)));
+        }
+        binary ? SceneFile::saveBinary(path, world) : SceneFile::saveText(path, world);
+    }
+    return path;
+}
+
+void BM_LoadScene(benchmark::State& state, bool binary) {
+    int numObjects = static_cast<int>(state.range(0));
+    std::string path = sceneFile(numObjects, binary);
+    for (auto _ : state) {
+        World world;
+        if (!SceneFile::load(path, world)) {
+            state.SkipWithError("Could not load the scene");
+            return;
+        }
+        benchmark::DoNotOptimize(world.getObjects().positions());
+    }
+    state.counters["objects/s"] = benchmark::Counter(static_cast<double>(numObjects) * state.iterations(),
+                                                     benchmark::Counter::kIsRate);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_LoadScene, text, false)->RangeMultiplier(10)->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadScene, binary, true)->RangeMultiplier(10)->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
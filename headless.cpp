@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Accumulation.hpp"
+#include "Camera.hpp"
+#include "CameraPath.hpp"
+#include "CpuRenderer.hpp"
+#include "Distributed.hpp"
+#include "FrameEncoder.hpp"
+#include "ImageWriter.hpp"
+#include "SceneFile.hpp"
+#include "SkyMap.hpp"
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+
+// Offline renderer for machines without a display or GPU: no GLFW, no GL
+// context, just the CPU marcher writing frames to disk. With --coordinator
+// and --worker the frames are split into units traced by several processes,
+// possibly on other machines (see Distributed.hpp).
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Options {
+    int width = 1920;
+    int height = 1080;
+    int frames = 0;        // 0 = one, or the whole camera path
+    float fov = 45.0f;
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float yawStep = 0.0f;  // Degrees added to yaw after every frame
+    std::string cameraPath; // Keyframes replacing the camera options above
+    float fps = 30.0f;     // Camera path frames per second
+    int threads = 0;       // 0 = all hardware threads
+    int tileSize = 16;
+    int samples = 1;       // Jittered samples averaged per pixel
+    std::string isa;       // Empty = best supported
+    Geodesic::Integrator integrator = Geodesic::Integrator::Schwarzschild;
+    bool deflectionLut = false;
+    bool boundingSpheres = true;
+    std::string output = "frame_%04d.ppm";
+    int bitDepth = 8;      // PNG, YUV and raw RGB samples
+    std::string pipeCommand; // Non-empty: raw frames go to this command instead of output
+    ImageWriter::Format pipeFormat = ImageWriter::Format::RGB;
+    int encodeThreads = FrameEncoder::DEFAULT_THREADS;
+    int encodeQueue = FrameEncoder::DEFAULT_QUEUE_DEPTH;
+    std::string scene;     // Empty = the built-in scene
+    bool bakedSky = true;
+    int skySize = SkyMap::DEFAULT_FACE_SIZE;
+    std::string skyCache = "cache"; // Empty = don't keep baked skies on disk
+    Geodesic::SkyParams sky;
+    int coordinatorPort = -1;  // >= 0: hand the frames out to workers instead of tracing them
+    std::string workerHost;    // Non-empty: trace units for the coordinator at workerHost:workerPort
+    uint16_t workerPort = 0;
+    int unitSize = Distributed::DEFAULT_UNIT_SIZE;
+    int maxUnits = 0;          // Worker leaves after this many units; 0 = never
+};
+
+void printUsage(const char* exe) {
+    std::cout << "Usage: " << exe << " [options]\n"
+              << "  --width N          Image width (default 1920)\n"
+              << "  --height N         Image height (default 1080)\n"
+              << "  --frames N         Number of frames to render (default 1, or the whole camera path)\n"
+              << "  --fov DEG          Vertical field of view (default 45)\n"
+              << "  --position X,Y,Z   Camera position (default 0,0,3)\n"
+              << "  --yaw DEG          Camera yaw (default -90)\n"
+              << "  --pitch DEG        Camera pitch (default 0)\n"
+              << "  --yaw-step DEG     Yaw change per frame (default 0)\n"
+              << "  --camera-path PATH Keyframed camera path file, replaces the camera options above\n"
+              << "  --fps N            Frames per second of camera path time (default 30)\n"
+              << "  --threads N        Worker threads (default: all cores)\n"
+              << "  --tile-size N      Tile edge in pixels (default 16)\n"
+              << "  --samples N        Jittered samples per pixel for anti-aliasing (default 1)\n"
+              << "  --isa NAME         scalar, sse4.1, avx2 or avx512 (default: best supported)\n"
+              << "  --integrator NAME  schwarzschild (RK45) or newtonian (default schwarzschild)\n"
+              << "  --deflection-lut on|off  Shade from precomputed geodesics (default off)\n"
+              << "  --bounding-spheres on|off  Skip rays that miss every black hole's influence sphere (default on)\n"
+              << "  --output PATTERN   printf-style path of each frame, .ppm, .pfm, .png or .exr, or one .yuv or .rgb\n"
+              << "                     file of raw frames (default frame_%04d.ppm)\n"
+              << "  --bit-depth 8|16   Bits per sample of PNG, YUV and raw RGB output (default 8)\n"
+              << "  --pipe CMD         Send raw frames to CMD's standard input instead, e.g. an ffmpeg command\n"
+              << "  --pipe-format rgb|yuv  Raw frames for --pipe: rgb24/rgb48le or yuv420p/yuv420p16le (default rgb)\n"
+              << "  --encode-threads N Threads converting and compressing frames while the next ones trace (default 2)\n"
+              << "  --encode-queue N   Frames waiting to be written before tracing waits for them (default 4)\n"
+              << "  --scene PATH       Text or binary scene file (default: built-in scene)\n"
+              << "  --sky baked|procedural  Sample a precomputed cubemap or evaluate the starfield per ray (default baked)\n"
+              << "  --sky-size N       Cubemap face size in texels, a power of two (default 512)\n"
+              << "  --sky-cache DIR    Where baked skies are kept between runs, \"\" for nowhere (default cache)\n"
+              << "  --star-density X   Star threshold, higher is fewer stars (default 0.995)\n"
+              << "  --nebula-intensity X  Nebula brightness (default 1)\n"
+              << "  --coordinator PORT Serve the frames to workers on PORT instead of tracing them (0 = any free port)\n"
+              << "  --unit-size N      Work unit edge in pixels for workers (default 128)\n"
+              << "  --worker HOST:PORT Trace units for a coordinator; scene and render options come from it\n"
+              << "  --max-units N      As a worker, drop out after N units, e.g. to test reassignment (default 0 = never)\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            std::exit(0);
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--width") options.width = std::atoi(value);
+        else if (arg == "--height") options.height = std::atoi(value);
+        else if (arg == "--frames") options.frames = std::atoi(value);
+        else if (arg == "--fov") options.fov = (float)std::atof(value);
+        else if (arg == "--yaw") options.yaw = (float)std::atof(value);
+        else if (arg == "--pitch") options.pitch = (float)std::atof(value);
+        else if (arg == "--yaw-step") options.yawStep = (float)std::atof(value);
+        else if (arg == "--camera-path") options.cameraPath = value;
+        else if (arg == "--fps") options.fps = (float)std::atof(value);
+        else if (arg == "--threads") options.threads = std::atoi(value);
+        else if (arg == "--tile-size") options.tileSize = std::atoi(value);
+        else if (arg == "--samples") options.samples = std::atoi(value);
+        else if (arg == "--isa") options.isa = value;
+        else if (arg == "--output") options.output = value;
+        else if (arg == "--bit-depth") options.bitDepth = std::atoi(value);
+        else if (arg == "--pipe") options.pipeCommand = value;
+        else if (arg == "--encode-threads") options.encodeThreads = std::atoi(value);
+        else if (arg == "--encode-queue") options.encodeQueue = std::atoi(value);
+        else if (arg == "--scene") options.scene = value;
+        else if (arg == "--sky-size") options.skySize = std::atoi(value);
+        else if (arg == "--sky-cache") options.skyCache = value;
+        else if (arg == "--star-density") options.sky.starDensity = (float)std::atof(value);
+        else if (arg == "--nebula-intensity") options.sky.nebulaIntensity = (float)std::atof(value);
+        else if (arg == "--coordinator") options.coordinatorPort = std::atoi(value);
+        else if (arg == "--unit-size") options.unitSize = std::atoi(value);
+        else if (arg == "--max-units") options.maxUnits = std::atoi(value);
+        else if (arg == "--integrator") {
+            std::string name = value;
+            if (name == "schwarzschild") options.integrator = Geodesic::Integrator::Schwarzschild;
+            else if (name == "newtonian") options.integrator = Geodesic::Integrator::Newtonian;
+            else {
+                std::cerr << "Unknown integrator " << name << std::endl;
+                return false;
+            }
+        } else if (arg == "--deflection-lut") {
+            std::string mode = value;
+            if (mode != "on" && mode != "off") {
+                std::cerr << "Expected on or off for --deflection-lut" << std::endl;
+                return false;
+            }
+            options.deflectionLut = mode == "on";
+        } else if (arg == "--bounding-spheres") {
+            std::string mode = value;
+            if (mode != "on" && mode != "off") {
+                std::cerr << "Expected on or off for --bounding-spheres" << std::endl;
+                return false;
+            }
+            options.boundingSpheres = mode == "on";
+        } else if (arg == "--sky") {
+            std::string mode = value;
+            if (mode != "baked" && mode != "procedural") {
+                std::cerr << "Expected baked or procedural for --sky" << std::endl;
+                return false;
+            }
+            options.bakedSky = mode == "baked";
+        } else if (arg == "--pipe-format") {
+            std::string format = value;
+            if (format != "rgb" && format != "yuv") {
+                std::cerr << "Expected rgb or yuv for --pipe-format" << std::endl;
+                return false;
+            }
+            options.pipeFormat = format == "rgb" ? ImageWriter::Format::RGB : ImageWriter::Format::YUV;
+        } else if (arg == "--worker") {
+            std::string address = value;
+            size_t colon = address.rfind(':');
+            int port = colon == std::string::npos ? 0 : std::atoi(address.c_str() + colon + 1);
+            if (colon == std::string::npos || colon == 0 || port <= 0 || port > 65535) {
+                std::cerr << "Expected HOST:PORT for --worker" << std::endl;
+                return false;
+            }
+            options.workerHost = address.substr(0, colon);
+            options.workerPort = static_cast<uint16_t>(port);
+        } else if (arg == "--position") {
+            if (std::sscanf(value, "%f,%f,%f", &options.position.x, &options.position.y, &options.position.z) != 3) {
+                std::cerr << "Expected X,Y,Z for --position" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.width <= 0 || options.height <= 0 || options.frames < 0 || options.fps <= 0.0f ||
+        options.threads < 0 || options.tileSize <= 0 || options.samples <= 0 || options.skySize <= 0) {
+        std::cerr << "Width, height, frame count, frame rate, tile size, samples and sky size must be positive"
+                  << std::endl;
+        return false;
+    }
+    if (options.coordinatorPort > 65535 || options.unitSize <= 0 || options.maxUnits < 0) {
+        std::cerr << "Expected a port up to 65535, a positive unit size and a non-negative unit limit" << std::endl;
+        return false;
+    }
+    if ((options.bitDepth != 8 && options.bitDepth != 16) || options.encodeThreads <= 0 || options.encodeQueue <= 0) {
+        std::cerr << "Expected a bit depth of 8 or 16 and a positive encoder thread count and queue" << std::endl;
+        return false;
+    }
+    if (options.coordinatorPort >= 0 && !options.workerHost.empty()) {
+        std::cerr << "A process is either the coordinator or a worker" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Summarizes where the frame time went: slowest tile and how evenly the workers were loaded
+void printTileSummary(const CpuRenderer& renderer) {
+    const auto& tiles = renderer.getTileStats();
+    if (tiles.empty()) return;
+
+    std::vector<double> workerMs(renderer.getThreadCount(), 0.0);
+    const CpuRenderer::TileStats* slowest = &tiles[0];
+    double totalMs = 0.0;
+    for (const auto& tile : tiles) {
+        workerMs[tile.worker] += tile.ms;
+        totalMs += tile.ms;
+        if (tile.ms > slowest->ms) slowest = &tile;
+    }
+    auto [minWorker, maxWorker] = std::minmax_element(workerMs.begin(), workerMs.end());
+
+    std::cout << "  tiles: " << tiles.size() << ", mean " << totalMs / tiles.size()
+              << " ms, slowest " << slowest->ms << " ms at (" << slowest->x << "," << slowest->y
+              << "), worker busy " << *minWorker << "-" << *maxWorker << " ms" << std::endl;
+}
+
+bool selectIsa(const Options& options, CpuRenderer& renderer) {
+    if (options.isa.empty()) return true;
+    GeodesicPacket::Isa isa;
+    if (!GeodesicPacket::parseIsa(options.isa.c_str(), isa)) {
+        std::cerr << "Unknown ISA " << options.isa << std::endl;
+        return false;
+    }
+    renderer.setIsa(isa);
+    if (renderer.getIsa() != isa) {
+        std::cerr << options.isa << " is not supported on this CPU, using "
+                  << GeodesicPacket::isaName(renderer.getIsa()) << std::endl;
+    }
+    return true;
+}
+
+FrameEncoder::Settings encoderSettingsFor(const Options& options) {
+    FrameEncoder::Settings settings;
+    settings.output = options.output;
+    settings.pipeCommand = options.pipeCommand;
+    settings.pipeFormat = options.pipeFormat;
+    settings.bitDepth = options.bitDepth;
+    settings.threads = options.encodeThreads;
+    settings.queueDepth = options.encodeQueue;
+    return settings;
+}
+
+// Opens the output and says where the frames are going
+bool openEncoder(const Options& options, FrameEncoder& encoder) {
+    if (!encoder.open()) {
+        return false;
+    }
+    ImageWriter::Format format = encoder.getFormat();
+    std::cout << "Output: " << ImageWriter::formatName(format);
+    if (format == ImageWriter::Format::PNG || ImageWriter::isRawFormat(format)) {
+        std::cout << ", " << options.bitDepth << "-bit";
+    }
+    std::cout << (encoder.isStream() ? " stream to " : " files like ") << encoder.describeTarget(0) << ", "
+              << options.encodeThreads << " encoder thread(s), queue of " << encoder.getQueueDepth() << " frames"
+              << std::endl;
+    return true;
+}
+
+void printEncoderSummary(const FrameEncoder& encoder) {
+    const FrameEncoder::Stats& stats = encoder.getStats();
+    if (stats.framesWritten == 0) return;
+    std::cout << "  output: " << stats.framesWritten << " frame(s), " << stats.bytesWritten / (1024.0 * 1024.0)
+              << " MB, encode " << stats.encodeMs / stats.framesWritten << " ms/frame, write "
+              << stats.writeMs / stats.framesWritten << " ms/frame; tracing waited " << stats.waitMs
+              << " ms for the encoder" << std::endl;
+}
+
+Geodesic::MarchParams marchParamsFor(const Options& options) {
+    Geodesic::MarchParams params;
+    params.integrator = options.integrator;
+    params.boundingSpheres = options.boundingSpheres;
+    return params;
+}
+
+// Traces units for a coordinator until its job is done; everything but the
+// machine's own threads, tiles and ISA comes with the job
+int runWorker(const Options& options) {
+    CpuRenderer renderer(options.threads, options.tileSize);
+    if (!selectIsa(options, renderer)) {
+        return 1;
+    }
+    std::cout << "Worker for " << options.workerHost << ":" << options.workerPort << ", "
+              << renderer.getThreadCount() << " threads, " << GeodesicPacket::isaName(renderer.getIsa())
+              << " packets" << std::endl;
+
+    auto runBegin = Clock::now();
+    Distributed::Worker worker(renderer, options.skyCache);
+    worker.setUnitLimit(options.maxUnits);
+    bool finished = worker.run(options.workerHost, options.workerPort);
+    std::cout << "Traced " << worker.getUnitsRendered() << " unit(s) in " << elapsedMs(runBegin) << " ms"
+              << std::endl;
+    return finished ? 0 : 1;
+}
+
+// The camera of every frame: sampled from the camera path at the frame rate,
+// or the fixed camera turned by the yaw step after each frame
+bool cameraPoses(const Options& options, std::vector<CameraPose>& poses) {
+    if (options.cameraPath.empty()) {
+        CameraPose pose{ options.position, options.yaw, options.pitch, options.fov };
+        for (int frame = 0; frame < std::max(options.frames, 1); ++frame) {
+            poses.push_back(pose);
+            pose.yaw += options.yawStep;
+        }
+        return true;
+    }
+
+    CameraPath path;
+    if (!CameraPath::load(options.cameraPath, path)) {
+        return false;
+    }
+    if (path.empty()) {
+        std::cerr << options.cameraPath << ": no keyframes" << std::endl;
+        return false;
+    }
+    int frames = options.frames > 0 ? options.frames : path.frameCount(options.fps);
+    for (int frame = 0; frame < frames; ++frame) {
+        poses.push_back(path.evaluate(path.frameTime(frame, options.fps)));
+    }
+    std::cout << "Camera path: " << options.cameraPath << ", " << path.getKeyframes().size() << " keys over "
+              << path.getEndTime() - path.getStartTime() << " s, " << frames << " frames at " << options.fps
+              << " fps" << std::endl;
+    return true;
+}
+
+// Hands the frames out to workers and writes them as they come together
+int runCoordinator(const Options& options, const World& world, const std::vector<CameraPose>& poses) {
+    Distributed::Job job;
+    job.width = options.width;
+    job.height = options.height;
+    job.samples = options.samples;
+    job.unitSize = options.unitSize;
+    job.marchParams = marchParamsFor(options);
+    job.deflectionLut = options.deflectionLut;
+    job.skyParams = options.sky;
+    job.bakedSky = options.bakedSky;
+    job.skySize = options.skySize;
+    job.frames = poses;
+    job.scene = SceneFile::encodeBinary(world);
+
+    FrameEncoder encoder(options.width, options.height, encoderSettingsFor(options));
+    if (!openEncoder(options, encoder)) {
+        return 1;
+    }
+
+    Clock::time_point runBegin;
+    Distributed::Coordinator coordinator(std::move(job), [&](int frame, const std::vector<float>& pixels) {
+        if (!encoder.submit(frame, pixels)) {
+            return false;
+        }
+        std::cout << "Frame " << frame << ": done at " << elapsedMs(runBegin) << " ms -> "
+                  << encoder.describeTarget(frame) << std::endl;
+        return true;
+    });
+    // Frames can finish out of order, but no further ahead than the encoder
+    // can hold, so a stream's next frame always finds a free slot
+    coordinator.setFrameWindow(encoder.getQueueDepth());
+    if (!coordinator.listen(static_cast<uint16_t>(options.coordinatorPort))) {
+        return 1;
+    }
+    std::cout << "Coordinator on port " << coordinator.getPort() << ": " << poses.size() << " frame(s) in "
+              << coordinator.getUnitCount() << " units, waiting for workers" << std::endl;
+
+    runBegin = Clock::now();
+    bool written = coordinator.run();
+    written = encoder.finish() && written;
+    double totalMs = elapsedMs(runBegin);
+
+    const Distributed::Coordinator::Stats& stats = coordinator.getStats();
+    double rays = (double)options.width * options.height * options.samples * poses.size();
+    std::cout << "Rendered " << poses.size() << " frame(s) in " << totalMs << " ms ("
+              << totalMs / poses.size() << " ms/frame, " << rays / totalMs / 1000.0 << " Mrays/s)" << std::endl;
+    std::cout << "  workers: " << stats.workersConnected << " connected, " << stats.workersLost
+              << " lost; units: " << stats.unitsAssigned << " assigned, " << stats.unitsRequeued
+              << " requeued, " << stats.unitsDuplicated << " duplicated, " << stats.unitsDiscarded << " discarded; "
+              << (double)stats.steps / rays << " steps/ray" << std::endl;
+    printEncoderSummary(encoder);
+    return written ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto startupBegin = Clock::now();
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.workerHost.empty()) {
+        return runWorker(options);
+    }
+
+    // --- Scene Setup (same scene as the interactive app) ---
+    std::vector<CameraPose> poses;
+    if (!cameraPoses(options, poses)) {
+        return 1;
+    }
+
+    World world;
+    if (options.scene.empty()) {
+        world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f, 0.0f, 0.0f));
+    } else {
+        auto loadBegin = Clock::now();
+        if (!SceneFile::load(options.scene, world)) {
+            return 1;
+        }
+        std::cout << "Scene: " << options.scene << ", " << world.getBlackHoles().size() << " black holes, "
+                  << world.getObjects().size() << " objects, loaded in " << elapsedMs(loadBegin) << " ms"
+                  << std::endl;
+    }
+
+    if (options.coordinatorPort >= 0) {
+        return runCoordinator(options, world, poses);
+    }
+
+    CpuRenderer renderer(options.threads, options.tileSize);
+    if (!selectIsa(options, renderer)) {
+        return 1;
+    }
+    renderer.setMarchParams(marchParamsFor(options));
+    renderer.setDeflectionLut(options.deflectionLut);
+
+    std::shared_ptr<const SkyMap> skyMap;
+    if (options.bakedSky) {
+        auto skyBegin = Clock::now();
+        SkyCache skyCache(options.skyCache);
+        skyMap = skyCache.get(options.sky, options.skySize, &renderer.getPool());
+        std::cout << "Sky: " << skyMap->getFaceSize() << " px cubemap, ready in " << elapsedMs(skyBegin) << " ms"
+                  << std::endl;
+    } else {
+        std::cout << "Sky: procedural" << std::endl;
+    }
+    renderer.setSky(options.sky, skyMap);
+
+    std::cout << "CPU: " << renderer.getThreadCount() << " threads, "
+              << GeodesicPacket::isaName(renderer.getIsa()) << " packets" << std::endl;
+
+    FrameEncoder encoder(options.width, options.height, encoderSettingsFor(options));
+    if (!openEncoder(options, encoder)) {
+        return 1;
+    }
+
+    double startupMs = elapsedMs(startupBegin);
+    std::cout << "Startup: " << startupMs << " ms" << std::endl;
+
+    // --- Render Loop ---
+    // Everything above (pool, sky, scene) is set up once for the whole sequence
+    auto runBegin = Clock::now();
+    double traceMsTotal = 0.0;
+    double slowestTraceMs = 0.0;
+    double fastestTraceMs = 0.0;
+    for (int frame = 0; frame < (int)poses.size(); ++frame) {
+        Camera camera = poses[frame].toCamera();
+        auto traceBegin = Clock::now();
+        uint64_t frameSteps = 0;
+        uint64_t frameSkipped = 0;
+        for (int sample = 0; sample < options.samples; ++sample) {
+            renderer.render(camera, world, options.width, options.height,
+                            Accumulation::jitter(sample), 1.0f / (sample + 1));
+            frameSteps += renderer.getLastFrameSteps();
+            frameSkipped += renderer.getLastFrameSkippedRays();
+        }
+        double traceMs = elapsedMs(traceBegin);
+        traceMsTotal += traceMs;
+        slowestTraceMs = std::max(slowestTraceMs, traceMs);
+        fastestTraceMs = frame == 0 ? traceMs : std::min(fastestTraceMs, traceMs);
+
+        // Copied into the encoder's queue; waits only if it has fallen a whole queue behind
+        auto submitBegin = Clock::now();
+        if (!encoder.submit(frame, renderer.getPixelBuffer())) {
+            return 1;
+        }
+        double submitMs = elapsedMs(submitBegin);
+
+        double rays = (double)options.width * options.height * options.samples;
+        double steps = (double)frameSteps;
+        std::cout << "Frame " << frame << ": trace " << traceMs << " ms, queue " << submitMs
+                  << " ms -> " << encoder.describeTarget(frame) << std::endl;
+        std::cout << "  " << rays / traceMs / 1000.0 << " Mrays/s, " << steps / traceMs / 1000.0
+                  << " Msteps/s (" << steps / rays << " steps/ray, " << 100.0 * frameSkipped / rays
+                  << "% skipped)" << std::endl;
+        printTileSummary(renderer);
+    }
+
+    // The last frames are still being encoded
+    bool written = encoder.finish();
+    int frames = (int)poses.size();
+    double totalMs = elapsedMs(runBegin);
+    double rays = (double)options.width * options.height * options.samples * frames;
+    std::cout << "Rendered " << frames << " frame(s) in " << totalMs << " ms ("
+              << totalMs / frames << " ms/frame, " << 1000.0 * frames / totalMs << " frames/s)" << std::endl;
+    std::cout << "  trace " << traceMsTotal / frames << " ms/frame mean (" << fastestTraceMs << "-"
+              << slowestTraceMs << "), " << rays / traceMsTotal / 1000.0 << " Mrays/s; wall clock "
+              << (startupMs + totalMs) / 1000.0 << " s including startup" << std::endl;
+    printEncoderSummary(encoder);
+    return written ? 0 : 1;
+}
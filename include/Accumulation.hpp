@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+#include "Geodesic.hpp"
+#include "World.hpp"
+
+// Bookkeeping for progressive refinement, shared by the GPU and CPU tracers.
+// Each frame of an unchanged view adds one jittered sample to a running
+// average; any change to the camera, the scene, the resolution or the march
+// parameters restarts it. Once maxSamples have been averaged the view is
+// converged and the tracers stop rendering until something changes.
+class Accumulation {
+public:
+    explicit Accumulation(int maxSamples = 64);
+
+    // Compares the frame about to be rendered with the one being accumulated.
+    // Returns true (and restarts) if anything differs.
+    bool update(const Camera& camera, const World& world, int width, int height,
+                const Geodesic::MarchParams& params);
+    void reset() { sampleCount = 0; }
+
+    // Sub-pixel offset of the next sample, in pixels within [-0.5, 0.5)
+    glm::vec2 getJitter() const { return jitter(sampleCount); }
+    // Weight of the next sample in the running average; 1 replaces the old image
+    float getBlendWeight() const { return 1.0f / (float)(sampleCount + 1); }
+    void addSample() { ++sampleCount; }
+
+    int getSampleCount() const { return sampleCount; }
+    bool isConverged() const { return sampleCount >= maxSamples; }
+    void setMaxSamples(int samples) { maxSamples = samples > 0 ? samples : 1; }
+    int getMaxSamples() const { return maxSamples; }
+
+    // Sample 0 is the pixel centre, later ones follow a Halton (2, 3) sequence
+    static glm::vec2 jitter(int sampleIndex);
+
+private:
+    struct ViewKey {
+        glm::vec3 position;
+        float yaw, pitch, zoom;
+        int width, height;
+        const World* world;
+        uint64_t worldRevision;
+        Geodesic::MarchParams params;
+
+        bool operator==(const ViewKey&) const = default;
+    };
+
+    ViewKey key{};
+    bool hasKey = false;
+    int sampleCount = 0;
+    int maxSamples;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for long-lived, trivially copyable arrays such as the World
+// pools. Allocations are carved out of large blocks and only released all at
+// once by reset(), so growing an array leaves the old copy behind until then.
+// Memory never moves, also not when the arena itself is moved.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+    Arena(Arena&&) = default;
+    Arena& operator=(Arena&&) = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Uninitialized storage; alignment must be a power of two
+    void* allocate(size_t bytes, size_t alignment);
+
+    template <typename T>
+    T* allocate(size_t count, size_t alignment = alignof(T)) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                      "Arena memory is copied with memcpy and never destroyed");
+        return static_cast<T*>(allocate(count * sizeof(T), alignment < alignof(T) ? alignof(T) : alignment));
+    }
+
+    // Frees every allocation at once
+    void reset();
+
+    size_t bytesUsed() const;
+    size_t bytesReserved() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+
+// Where a camera is and how it looks, without the input-handling state
+struct CameraPose {
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+    float yaw = -90.0f;   // Degrees
+    float pitch = 0.0f;
+    float fov = 45.0f;    // Vertical, degrees; Camera::zoom
+
+    Camera toCamera() const;
+};
+
+// Keyframed camera motion for rendered sequences. Between keys every channel
+// (position, yaw, pitch and FOV) follows a Catmull-Rom spline through the
+// neighbouring keys, with tangents scaled by the key times so unevenly spaced
+// keys don't make the camera lurch. Before the first and after the last key
+// the camera holds still. Yaw is interpolated as given, so a path that turns
+// past 180 degrees should keep counting (170, 190, ...) rather than wrap.
+//
+// Path files are text, one key per line; '#' starts a comment:
+//     key TIME X Y Z YAW PITCH FOV
+class CameraPath {
+public:
+    struct Keyframe {
+        float time;  // Seconds
+        CameraPose pose;
+    };
+
+    // Keeps the keys ordered by time; a key at the time of another replaces it
+    void addKeyframe(const Keyframe& key);
+    const std::vector<Keyframe>& getKeyframes() const { return keys; }
+    bool empty() const { return keys.empty(); }
+
+    float getStartTime() const { return keys.empty() ? 0.0f : keys.front().time; }
+    float getEndTime() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    // The default pose for an empty path
+    CameraPose evaluate(float time) const;
+
+    // Frames needed to cover the path from its first key to its last at fps
+    int frameCount(float fps) const;
+    // Time of a frame of that sequence
+    float frameTime(int frame, float fps) const { return getStartTime() + frame / fps; }
+
+    // Appends the file's keys to path; returns false (after printing why) if it is unreadable or malformed
+    static bool load(const std::string& filePath, CameraPath& path);
+
+private:
+    std::vector<Keyframe> keys;
+};
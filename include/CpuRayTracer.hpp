@@ -1,30 +1,120 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "Accumulation.hpp"
 #include "Camera.hpp"
+#include "CpuRenderer.hpp"
+#include "FramePipeline.hpp"
+#include "World.hpp"
 
+// Viewport front-end for the CPU renderer: traces a frame with CpuRenderer and
+// uploads it to a texture so the UI can display it like the GPU output.
+//
+// With a pipeline depth of 0 frames are traced on the calling thread. Above
+// that a FramePipeline traces them on a render thread of its own and render()
+// only submits the view and uploads whatever frame has finished, so the UI
+// keeps its own rate however long a frame takes.
+//
+// Frames are tonemapped to 4 bytes per pixel and uploaded through a ring of
+// pixel buffer objects, persistently mapped where the context has GL 4.4
+// buffer storage and mapped per frame otherwise. The texture update is then a
+// copy the driver performs asynchronously, so it overlaps with tracing the
+// next frame; a fence per buffer keeps a frame from overwriting one still
+// being copied.
 class CpuRayTracer {
 public:
+    using DisplayFormat = CpuRenderer::DisplayFormat;
+    static constexpr int UPLOAD_RING_SIZE = 3;
+    static constexpr int DEFAULT_PIPELINE_DEPTH = FramePipeline::MAX_DEPTH;
+
     CpuRayTracer();
     ~CpuRayTracer();
 
     void init(int width, int height);
-    void render(const Camera& camera, int width, int height);
+    // Returns false if no new frame was displayed: a progressive image has
+    // converged, or the render thread hasn't finished one since the last call
+    bool render(const Camera& camera, const World& world, int width, int height);
+
+    unsigned int getTextureID() const { return textureID; }
+
+    // 0 traces on the calling thread, 1 and 2 on a render thread (see
+    // FramePipeline). Clamped to [0, FramePipeline::MAX_DEPTH].
+    void setPipelineDepth(int depth);
+    int getPipelineDepth() const { return pipeline ? pipeline->getDepth() : 0; }
+
+    // --- Settings, picked up at the start of the next frame ---
+    void setMarchParams(const Geodesic::MarchParams& params) { settings.marchParams = params; }
+    void setDeflectionLut(bool enabled) { settings.deflectionLut = enabled; }
+    void setSky(const Geodesic::SkyParams& params, std::shared_ptr<const SkyMap> map) {
+        settings.skyParams = params;
+        settings.skyMap = std::move(map);
+    }
+    // Progressive refinement: average jittered samples while the view is unchanged
+    void setProgressive(bool enabled) { settings.progressive = enabled; }
+    void setMaxSamples(int samples) { settings.maxSamples = samples; }
+    // Precision of the displayed texture; RGB10A2 bands less in dim gradients
+    void setDisplayFormat(DisplayFormat format) { settings.displayFormat = format; }
+    DisplayFormat getDisplayFormat() const { return settings.displayFormat; }
+
+    // The frame on display
+    const FramePipeline::Stats& getLastFrameStats() const { return lastStats; }
+    // Whether the upload buffers stay mapped (GL 4.4 / ARB_buffer_storage)
+    bool isPersistentlyMapped() const { return persistentMapping; }
+
+    // Only for lending the renderer's pool, e.g. to bake a SkyMap: the render
+    // thread owns everything else about it while a pipeline runs
+    CpuRenderer& getRenderer() { return renderer; }
+
+    // Wall time of the last displayed frame, tracing plus texture upload
+    float getLastRenderMs() const { return lastRenderMs; }
+    // The tracing part of it
+    float getLastTraceMs() const { return lastStats.traceMs; }
+    // The rest: waiting for a free upload buffer, tonemapping (on the calling
+    // thread without a pipeline) and queueing the copy to the texture, which
+    // itself completes in the background
+    float getLastUploadMs() const { return lastUploadMs; }
 
 private:
-    unsigned int quadVAO = 0;
-    unsigned int quadVBO = 0;
+    struct UploadBuffer {
+        GLuint pbo = 0;
+        void* mapped = nullptr; // Persistent mapping, if any
+        GLsync fence = nullptr; // Signalled once the copy out of pbo has finished
+    };
+
     unsigned int textureID = 0;
-    unsigned int shaderProgram = 0;
-    
-    std::vector<float> pixelBuffer;
-    int bufferWidth = 0;
-    int bufferHeight = 0;
-
-    void setupQuad();
-    void setupShader();
-    void updateTexture(int width, int height);
-    glm::vec3 traceRay(const glm::vec3& origin, const glm::vec3& direction);
+    int textureWidth = 0;
+    int textureHeight = 0;
+    DisplayFormat textureFormat = DisplayFormat::RGBA8;
+
+    std::array<UploadBuffer, UPLOAD_RING_SIZE> uploadRing;
+    int nextUpload = 0;
+    bool persistentMapping = false;
+
+    CpuRenderer renderer;
+    Accumulation accumulation;
+    FramePipeline::Settings settings;
+    FramePipeline::Stats lastStats;
+    float lastRenderMs = 0.0f;
+    float lastUploadMs = 0.0f;
+
+    // Declared after what its thread uses, so it stops first
+    std::unique_ptr<FramePipeline> pipeline;
+    // The scene as last handed to the pipeline
+    std::shared_ptr<const World> worldSnapshot;
+    const World* snapshotSource = nullptr;
+    uint64_t snapshotRevision = 0;
+
+    void updateTexture(int width, int height, DisplayFormat format);
+    void setupUploadRing(int width, int height);
+    void cleanupUploadRing();
+    // Copies texels to the texture, or tonemaps the renderer's frame if there
+    // are none. False, with the texture left as it was, if the buffer could
+    // not be mapped or lost its contents.
+    bool upload(int width, int height, const uint32_t* texels);
+    bool renderSynchronously(const Camera& camera, const World& world, int width, int height);
+    bool renderPipelined(const Camera& camera, const World& world, int width, int height);
 };
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+#include "DeflectionTable.hpp"
+#include "GeodesicPacket.hpp"
+#include "SkyMap.hpp"
+#include "ThreadPool.hpp"
+#include "World.hpp"
+
+// GL-free CPU frame renderer. Traces every pixel into a linear RGB float
+// buffer (row 0 is the bottom of the image, like GL textures). Used by
+// CpuRayTracer for the viewport and directly by the headless renderer.
+//
+// The image is split into square tiles that are scheduled on a persistent
+// work-stealing ThreadPool owned by the renderer. Within a tile, each row is
+// marched as SIMD ray packets (GeodesicPacket::traceRays) using the best
+// instruction set the CPU supports unless another one is selected; the
+// scalar ISA marches one ray at a time through Geodesic::traceGeodesic.
+// Single black-hole scenes can skip marching altogether and be shaded from a
+// DeflectionTable (see setDeflectionLut).
+class CpuRenderer {
+public:
+    // Packed 32-bit texel layouts tonemap() can write for display
+    enum class DisplayFormat {
+        RGBA8,   // R in the low byte, for GL_RGBA8 with GL_UNSIGNED_INT_8_8_8_8_REV
+        RGB10A2  // R in the low 10 bits, for GL_RGB10_A2 with GL_UNSIGNED_INT_2_10_10_10_REV
+    };
+
+    // Timing of one tile from the last frame
+    struct TileStats {
+        int x, y;           // Lower-left pixel of the tile
+        int width, height;
+        int worker;         // Pool worker that traced it
+        float ms;
+        uint64_t steps;     // Integration steps summed over the tile's rays
+        uint64_t skippedRays; // Rays that missed every influence sphere and were not marched
+    };
+
+    // A rectangle of the frame in pixels, from its lower-left corner
+    struct Region {
+        int x, y;
+        int width, height;
+    };
+
+    // threadCount == 0 uses every hardware thread
+    explicit CpuRenderer(unsigned int threadCount = 0, int tileSize = 16);
+
+    // jitter offsets every ray within its pixel (in pixels). blend is the weight
+    // of this frame when averaged into the previous buffer contents; 1 replaces them.
+    void render(const Camera& camera, const World& world, int width, int height,
+                const glm::vec2& jitter = glm::vec2(0.0f), float blend = 1.0f);
+    // Traces only region of a width x height frame, with exactly the rays a
+    // whole-frame render would. The pixel buffer then holds just the region,
+    // so frames can be split into pieces rendered apart and put back together.
+    void renderRegion(const Camera& camera, const World& world, int width, int height, const Region& region,
+                      const glm::vec2& jitter = glm::vec2(0.0f), float blend = 1.0f);
+
+    const std::vector<float>& getPixelBuffer() const { return pixelBuffer; }
+    // Clamps the last frame to [0, 1] and quantizes it into width * height
+    // texels at out (rows from the bottom, opaque alpha), in parallel on the pool
+    void tonemap(DisplayFormat format, uint32_t* out);
+    // Size of the last frame, or of its region
+    int getWidth() const { return bufferWidth; }
+    int getHeight() const { return bufferHeight; }
+
+    // --- Scheduling ---
+    void setTileSize(int size) { tileSize = size > 0 ? size : 1; }
+    int getTileSize() const { return tileSize; }
+    unsigned int getThreadCount() const { return pool.size(); }
+    // Also lent out for precomputation between frames, e.g. baking a SkyMap
+    ThreadPool& getPool() { return pool; }
+    const std::vector<TileStats>& getTileStats() const { return tileStats; }
+    uint64_t getLastFrameSteps() const;
+    uint64_t getLastFrameSkippedRays() const;
+
+    // --- Quality ---
+    void setMarchParams(const Geodesic::MarchParams& params) { marchParams = params; }
+    const Geodesic::MarchParams& getMarchParams() const { return marchParams; }
+
+    // Shade single black-hole scenes from a DeflectionTable (built on the
+    // pool, cached per hole size) instead of marching every ray
+    void setDeflectionLut(bool enabled) { deflectionLut = enabled; }
+    bool getDeflectionLut() const { return deflectionLut; }
+    // Whether the last frame actually used the table
+    bool isUsingDeflectionLut() const { return usingDeflectionLut; }
+
+    // Escaped rays sample the map if there is one and evaluate the procedural
+    // starfield with these settings otherwise
+    void setSky(const Geodesic::SkyParams& params, std::shared_ptr<const SkyMap> map) {
+        skyParams = params;
+        skyMap = std::move(map);
+    }
+    const Geodesic::SkyParams& getSkyParams() const { return skyParams; }
+    const std::shared_ptr<const SkyMap>& getSkyMap() const { return skyMap; }
+
+    // --- Vectorization ---
+    // Falls back to the detected ISA if the CPU cannot run the requested one
+    void setIsa(GeodesicPacket::Isa requested);
+    GeodesicPacket::Isa getIsa() const { return isa; }
+
+private:
+    ThreadPool pool;
+    int tileSize;
+    GeodesicPacket::Isa isa;
+    Geodesic::MarchParams marchParams;
+    bool deflectionLut = false;
+    bool usingDeflectionLut = false;
+    DeflectionCache deflectionCache;
+    Geodesic::SkyParams skyParams;
+    std::shared_ptr<const SkyMap> skyMap;
+
+    // The scene as the marcher reads it, for World revision sceneRevision
+    std::vector<Geodesic::BlackHoleData> blackHoles;
+    uint64_t sceneRevision = 0;
+
+    std::vector<float> pixelBuffer;
+    int bufferWidth = 0;
+    int bufferHeight = 0;
+
+    std::vector<TileStats> tileStats;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Just enough of zlib (RFC 1950/1951) to write PNG and EXR files without a
+// dependency: greedy LZ77 matching over the 32 KiB window through short hash
+// chains, coded with the fixed Huffman tables. Data that doesn't shrink that
+// way is stored instead, so the output is never much larger than the input.
+// Rendered frames are mostly smooth sky and filtered rows of zeros, where
+// this gets most of what a full encoder would.
+namespace Deflate {
+
+// Appends a complete zlib stream holding data to out
+void compress(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+
+// The zlib stream checksum; pass the previous result to continue one
+uint32_t adler32(const unsigned char* data, size_t size, uint32_t adler = 1);
+
+} // namespace Deflate
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+
+class ThreadPool;
+
+// Precomputed geodesics for scenes with a single black hole. Around one hole
+// a ray stays in the plane through the hole, so where it ends up depends only
+// on the observer's distance R to the hole, the ray's impact parameter b and
+// whether it starts out heading towards or away from the hole. The table
+// integrates that family of rays once (Geodesic::march past a bare hole of the
+// given radius) and stores, per sample, the total deflection angle within the
+// plane and the transmittance (0 = captured, 1 = escaped), so shading a pixel
+// becomes a bilinear lookup plus a starfield sample.
+//
+// Rays that can reach the accretion disk still have to be marched; shade()
+// reports those. GpuRayTracer uploads the same table as a texture, so the
+// layout below is mirrored by DeflectionLookup in raytracer.frag.
+class DeflectionTable {
+public:
+    // Columns: impact parameter, b = rs * ((1 + ESCAPE_RADIUS / rs)^u - 1) for u in [0, 1],
+    // dense near the photon sphere and sparse far out where the deflection is ~2 rs / b
+    static constexpr int IMPACT_SAMPLES = 1024;
+    // Rows: observer radius, log-spaced between rs and ESCAPE_RADIUS. Rows
+    // [0, RADIUS_SAMPLES) hold inbound rays, the next RADIUS_SAMPLES outbound ones.
+    static constexpr int RADIUS_SAMPLES = 64;
+
+    struct Sample {
+        float deflection;     // Radians, towards the hole within the orbital plane
+        float transmittance;
+    };
+
+    // Integrates the table. With a pool the rows are traced in parallel.
+    DeflectionTable(float rs, const Geodesic::MarchParams& params, ThreadPool* pool = nullptr);
+
+    float getRs() const { return rs; }
+    const Geodesic::MarchParams& getParams() const { return params; }
+
+    // Bilinear lookup, clamped to the table's range
+    Sample lookup(float observerRadius, float impactParameter, bool outbound) const;
+
+    // Shades a ray from the table, against `sky`. Returns false, leaving color
+    // untouched, if the ray can reach bh's disk and has to be marched instead.
+    bool shade(const glm::vec3& ro, const glm::vec3& rd, const Geodesic::BlackHoleData& bh, glm::vec3& color,
+               const Geodesic::Sky& sky = Geodesic::Sky()) const;
+
+    // (deflection, transmittance) pairs, row-major, 2 * RADIUS_SAMPLES rows
+    // of IMPACT_SAMPLES; the layout of the GPU texture
+    const std::vector<float>& getData() const { return data; }
+
+    // Fractional column/row of a sample, as used by lookup() and the shader
+    float impactCoord(float impactParameter) const;
+    float radiusCoord(float observerRadius) const;
+
+private:
+    float rs;
+    Geodesic::MarchParams params;
+    std::vector<float> data;
+
+    float impactAt(int column) const;
+    float radiusAt(int row) const;
+    Sample fetch(int column, int row) const;
+};
+
+// Keeps the tables of the last few hole sizes (i.e. masses) and march
+// parameters so that switching back and forth does not re-integrate them
+class DeflectionCache {
+public:
+    explicit DeflectionCache(size_t capacity = 4) : capacity(capacity > 0 ? capacity : 1) {}
+
+    // Returns the table for a hole of radius rs, building it on a miss
+    std::shared_ptr<const DeflectionTable> get(float rs, const Geodesic::MarchParams& params,
+                                               ThreadPool* pool = nullptr);
+    size_t size() const { return tables.size(); }
+
+private:
+    size_t capacity;
+    std::vector<std::shared_ptr<const DeflectionTable>> tables; // Most recently used last
+};
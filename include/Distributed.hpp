@@ -0,0 +1,185 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CameraPath.hpp"
+#include "CpuRenderer.hpp"
+#include "Geodesic.hpp"
+
+// Splits headless renders across machines. A Coordinator holds the job and
+// hands out work units, one (frame, rectangle) each; Workers connect to it
+// over TCP, trace their units with CpuRenderer::renderRegion and send back
+// the float pixels, which the coordinator puts together into whole frames.
+//
+// Workers pull: each one has a single unit in flight and asks for the next
+// when it returns a result, so faster machines simply get through more of
+// them. A unit whose worker disconnects goes back to the front of the queue.
+// Once there is nothing new to start (the queue is empty, or its next frame
+// is outside the frame window), idle workers also take a second copy of any
+// unit that has been out for much longer than units usually take, and
+// whichever copy comes back first is used; a stuck or overloaded machine then
+// can't hold up the end of the job, or the frames behind its unit.
+//
+// The job (scene, cameras and render settings) is serialized once and sent to
+// each worker when it connects. Messages are raw little-endian structs, like
+// the binary scene files, so every machine has to be little-endian too.
+namespace Distributed {
+
+constexpr uint32_t PROTOCOL_VERSION = 1;
+constexpr int DEFAULT_UNIT_SIZE = 128;
+
+// A unit out this many times longer than the mean completed one gets a second copy
+constexpr double SLOW_UNIT_FACTOR = 4.0;
+// Never duplicate units sooner than this, however fast they usually are
+constexpr double MIN_SLOW_UNIT_MS = 250.0;
+
+// Everything a worker needs to trace any unit of the job
+struct Job {
+    int width = 0;
+    int height = 0;
+    int samples = 1;                    // Jittered samples averaged per pixel
+    int unitSize = DEFAULT_UNIT_SIZE;   // Edge of a work unit in pixels
+    Geodesic::MarchParams marchParams;
+    bool deflectionLut = false;
+    Geodesic::SkyParams skyParams;
+    bool bakedSky = true;
+    int skySize = 0;
+    std::vector<CameraPose> frames;     // One per frame
+    std::vector<unsigned char> scene;   // SceneFile::encodeBinary
+
+    std::vector<unsigned char> encode() const;
+    // False if data is not a complete job
+    static bool decode(const std::vector<unsigned char>& data, Job& job);
+};
+
+class Coordinator {
+public:
+    // Receives each frame (width * height RGB floats, rows from the bottom)
+    // once all its units are in. Frames can finish out of order; calls never
+    // overlap. Returning false abandons the job.
+    using FrameSink = std::function<bool(int frame, const std::vector<float>& pixels)>;
+
+    struct Stats {
+        int workersConnected = 0;
+        int workersLost = 0;        // Dropped the connection mid-job
+        uint64_t unitsAssigned = 0; // Including repeats
+        uint64_t unitsRequeued = 0; // Taken back from lost workers
+        uint64_t unitsDuplicated = 0; // Second copies of slow units
+        uint64_t unitsDiscarded = 0;  // Copies beaten by another, returned late or cut off at the end
+        uint64_t steps = 0;         // Integration steps over the units used
+        uint64_t skippedRays = 0;
+    };
+
+    Coordinator(Job job, FrameSink sink);
+    ~Coordinator();
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    // Binds to port on every interface; 0 picks a free one (see getPort)
+    bool listen(uint16_t port);
+    uint16_t getPort() const { return port; }
+
+    // Serves workers until every frame has been handed to the sink. Returns
+    // false if the sink failed. Waits for workers indefinitely.
+    bool run();
+
+    // Only hands out units of frames fewer than this many past the oldest one
+    // not yet given to the sink, which caps the frames being put together at
+    // once and how far ahead of it the sink can get frames; 0 = no limit
+    void setFrameWindow(int frames) { frameWindow = frames; }
+
+    // When a unit counts as slow enough to get a second copy: out factor
+    // times longer than the mean completed unit, and at least minMs
+    void setSlowUnitThreshold(double factor, double minMs) {
+        slowUnitFactor = factor;
+        minSlowUnitMs = minMs;
+    }
+
+    int getUnitCount() const { return static_cast<int>(units.size()); }
+    // Only stable once run() has returned
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Unit {
+        int frame;
+        CpuRenderer::Region region;
+        bool done = false;
+        int copies = 0;    // Workers tracing it right now
+        std::chrono::steady_clock::time_point assigned;
+    };
+    struct Connection;
+
+    Job job;
+    FrameSink sink;
+    std::vector<unsigned char> jobMessage;
+    std::vector<Unit> units;
+    int frameWindow = 0;
+    double slowUnitFactor = SLOW_UNIT_FACTOR;
+    double minSlowUnitMs = MIN_SLOW_UNIT_MS;
+
+    struct Listener;
+    std::unique_ptr<Listener> listener;
+    uint16_t port = 0;
+
+    std::mutex mutex;  // Guards everything below
+    std::condition_variable changed;
+    std::deque<int> pending;
+    std::vector<std::vector<float>> framePixels; // Empty until a frame's first unit arrives
+    std::vector<int> unitsLeft;                  // Per frame
+    std::vector<bool> frameSunk;
+    int framesFinished = 0;
+    int oldestOpenFrame = 0;                     // First frame not yet given to the sink
+    bool finished = false;
+    bool failed = false;
+    double unitMsTotal = 0.0;
+    int unitsTimed = 0;
+    Stats stats;
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    std::mutex sinkMutex;
+
+    void serve(Connection& connection);
+    // The next unit for connection, or -1 once the job is finished
+    int nextUnit(Connection& connection);
+    // False if result doesn't fit the unit
+    bool completeUnit(Connection& connection, int id, const std::vector<unsigned char>& result);
+    void abandonUnit(Connection& connection, int id);
+};
+
+class Worker {
+public:
+    // Traces units on renderer; its threads, tile size and ISA are this
+    // machine's own. Baked skies are kept in skyCacheDir like the headless
+    // renderer's.
+    Worker(CpuRenderer& renderer, std::string skyCacheDir);
+
+    // Connects (retrying for a while, so workers can start before the
+    // coordinator) and traces units until the coordinator says the job is
+    // finished. Returns false if the connection fails or is lost first.
+    bool run(const std::string& host, uint16_t port);
+
+    // Disconnects on the unit after this many as if the machine had died (run()
+    // then returns true); 0 never does
+    void setUnitLimit(int limit) { unitLimit = limit; }
+    // Waits this long before returning each unit, like an overloaded machine
+    void setUnitDelay(std::chrono::milliseconds delay) { unitDelay = delay; }
+
+    int getUnitsRendered() const { return unitsRendered; }
+
+private:
+    CpuRenderer& renderer;
+    std::string skyCacheDir;
+    int unitLimit = 0;
+    std::chrono::milliseconds unitDelay{ 0 };
+    int unitsRendered = 0;
+};
+
+} // namespace Distributed
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageWriter.hpp"
+
+// The output stage of the headless renderer: takes finished frames and
+// converts, compresses and writes them on threads of its own, so the next
+// frame is already being traced while the last one is encoded.
+//
+// Frames are copied into a fixed pool of queueDepth slots, each keeping its
+// float pixels and encoded bytes allocated from frame to frame. submit()
+// waits for a free slot when the encoder falls behind, so memory use is set
+// by the queue depth and frame size, however long the sequence runs.
+//
+// The output is either one file per frame (a printf-style pattern with a
+// PPM, PFM, PNG or EXR extension) or a single stream of raw frames in frame
+// order: a .yuv or .rgb file, or the standard input of an external encoder
+// such as ffmpeg. Frames of a stream can be encoded out of order but are
+// written in order, so a stream's frames have to be numbered from 0 up
+// without gaps.
+class FrameEncoder {
+public:
+    static constexpr int DEFAULT_THREADS = 2;
+    static constexpr int DEFAULT_QUEUE_DEPTH = 4;
+
+    struct Settings {
+        std::string output = "frame_%04d.ppm";
+        // Non-empty: raw frames go to this shell command's standard input instead of output
+        std::string pipeCommand;
+        ImageWriter::Format pipeFormat = ImageWriter::Format::RGB;
+        int bitDepth = 8;       // 8 or 16, for PNG, YUV and raw RGB
+        int threads = DEFAULT_THREADS;
+        int queueDepth = DEFAULT_QUEUE_DEPTH; // Frames taken but not yet written
+    };
+
+    struct Stats {
+        int framesWritten = 0;
+        uint64_t bytesWritten = 0;
+        double encodeMs = 0.0;  // Summed over the threads
+        double writeMs = 0.0;
+        double waitMs = 0.0;    // Spent in submit() waiting for a free slot
+    };
+
+    FrameEncoder(int width, int height, Settings settings);
+    // Finishes whatever was submitted
+    ~FrameEncoder();
+
+    FrameEncoder(const FrameEncoder&) = delete;
+    FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+    // Opens the stream file or starts the pipe command, then the threads.
+    // Returns false (after printing why) if the settings or output are unusable.
+    bool open();
+
+    // Copies pixels (width * height RGB floats, rows from the bottom) into a
+    // free slot, waiting for one if every slot is taken. Returns false once
+    // any frame has failed to write, or if finish() is called meanwhile.
+    bool submit(int frame, const std::vector<float>& pixels);
+
+    // Waits for every submitted frame to be written and closes the output.
+    // Returns false if any write (or the pipe command) failed.
+    bool finish();
+
+    ImageWriter::Format getFormat() const { return format; }
+    bool isStream() const { return stream != nullptr; }
+    int getQueueDepth() const { return static_cast<int>(slots.size()); }
+    // Where a frame goes: its file, the stream file or the pipe command
+    std::string describeTarget(int frame) const;
+    // Only stable once finish() has returned
+    const Stats& getStats() const { return stats; }
+
+    // pattern formatted with the frame number
+    static std::string framePath(const std::string& pattern, int frame);
+
+private:
+    enum class SlotState { Free, Filling, Queued, Encoding, Encoded };
+    struct Slot {
+        SlotState state = SlotState::Free;
+        int frame = 0;
+        std::vector<float> pixels;
+        std::vector<unsigned char> bytes;
+    };
+
+    int width;
+    int height;
+    Settings settings;
+    ImageWriter::Format format = ImageWriter::Format::PPM;
+    std::FILE* stream = nullptr;
+    bool piped = false;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;  // Guards everything below
+    std::condition_variable changed;
+    std::vector<Slot> slots;
+    int nextStreamFrame = 0;   // The stream frame to write next
+    bool streamWriting = false; // A thread is writing stream frames
+    bool stopping = false;
+    bool failed = false;
+    bool finished = false;
+    Stats stats;
+
+    void run();
+    // Writes the encoded stream frames that are next in order; called and returns with lock held
+    void writeStream(std::unique_lock<std::mutex>& lock);
+    bool closeStream();
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Accumulation.hpp"
+#include "Camera.hpp"
+#include "CpuRenderer.hpp"
+#include "TripleBuffer.hpp"
+#include "World.hpp"
+
+// Runs CpuRenderer on a thread of its own, so a slow CPU frame never holds up
+// the UI thread's input, camera and ImGui. The UI thread submits a Request
+// (camera, scene snapshot and settings) every time it draws; at the start of
+// each frame the render thread takes the newest one, traces it and publishes
+// the tonemapped texels. Both directions go through a lock-free TripleBuffer.
+//
+// The depth is how far the render thread may run ahead of the display:
+//   1: a frame is only started once the previous one has been taken, so
+//      every finished frame is shown and none is older than one trace
+//   2: the render thread never waits; the display takes the newest finished
+//      frame and frames it missed are dropped
+class FramePipeline {
+public:
+    static constexpr int MAX_DEPTH = 2;
+
+    // What the CPU viewport renders with, applied to the renderer at the start of a frame
+    struct Settings {
+        Geodesic::MarchParams marchParams;
+        bool deflectionLut = false;
+        Geodesic::SkyParams skyParams;
+        std::shared_ptr<const SkyMap> skyMap;
+        bool progressive = false;
+        int maxSamples = 64;
+        CpuRenderer::DisplayFormat displayFormat = CpuRenderer::DisplayFormat::RGBA8;
+    };
+
+    // Everything one frame depends on, copied when it is submitted
+    struct Request {
+        Camera camera;
+        std::shared_ptr<const World> world;
+        int width = 0;
+        int height = 0;
+        Settings settings;
+    };
+
+    // How a frame was made, for the renderer info and dynamic resolution
+    struct Stats {
+        int width = 0;
+        int height = 0;
+        float traceMs = 0.0f;
+        int sampleCount = 0;         // Progressive samples averaged into it
+        bool usingDeflectionLut = false;
+        uint64_t skippedRays = 0;
+    };
+
+    struct Frame {
+        std::vector<uint32_t> texels; // width * height, rows from the bottom
+        CpuRenderer::DisplayFormat format = CpuRenderer::DisplayFormat::RGBA8;
+        Stats stats;
+    };
+
+    // Starts the render thread, which uses renderer and accumulation until
+    // the pipeline is destroyed
+    FramePipeline(CpuRenderer& renderer, Accumulation& accumulation, int depth = MAX_DEPTH);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Clamped to [1, MAX_DEPTH]
+    void setDepth(int depth);
+    int getDepth() const { return depth.load(std::memory_order_relaxed); }
+
+    // UI thread only
+    void submit(const Request& request);
+    // The newest frame finished since the last call, or nullptr. Stays valid
+    // until the next call.
+    const Frame* acquire();
+
+    // Applies the request's settings to the renderer, restarting the
+    // accumulation where they changed, and traces one frame (one more sample
+    // if progressive). Returns false without tracing once the view has converged.
+    // Shared with CpuRayTracer's synchronous path.
+    static bool trace(CpuRenderer& renderer, Accumulation& accumulation, const Request& request, Stats& stats);
+
+private:
+    CpuRenderer& renderer;
+    Accumulation& accumulation;
+    std::atomic<int> depth;
+
+    TripleBuffer<Request> requests;
+    TripleBuffer<Frame> frames;
+
+    // Bumped by the UI thread whenever the render thread may have something to do
+    std::atomic<uint32_t> wakeups{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+
+    void wake();
+    void run();
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+class SkyMap;
+class World;
+
+// CPU port of TraceGeodesic and the sky functions in shaders/raytracer.frag.
+// The two implementations must stay in sync: any change to the physics,
+// the disk model or the background has to be made in both places.
+namespace Geodesic {
+
+// Mirrors BlackHoleData in raytracer.frag
+struct BlackHoleData {
+    glm::vec3 pos;
+    float rs;
+    float diskInner;
+    float diskOuter;
+};
+
+constexpr int MAX_STEPS = 200;
+constexpr float MAX_DIST = 1e10f;
+constexpr float ESCAPE_RADIUS = 5000.0f;
+constexpr float BENDING_STRENGTH = 1.5f;
+constexpr float STEP_FACTOR = 0.08f;
+constexpr float MIN_STEP = 0.05f;
+constexpr float DISK_HALF_THICKNESS = 0.1f;  // Disk density falls off linearly from 2 at the midplane to 0 here
+constexpr float DISK_FLAT_EPSILON = 1e-4f;   // Steps rising less than this across a disk slab count as parallel to it
+
+// Schwarzschild integrator
+constexpr float RK_TOLERANCE = 1e-3f;       // Allowed local error per step, relative
+constexpr float RK_MAX_STEP_FACTOR = 0.5f;  // Longest step as a fraction of the distance to the nearest hole
+constexpr float RK_DISK_STEP = 0.5f;        // Longest step within this distance of a disk slab; further out steps reach at most the slab
+
+// Influence spheres: beyond max(INFLUENCE_RS_FACTOR * rs, DISK_REACH * diskOuter)
+// a hole's pull is applied as an analytic weak-field deflection instead of being marched
+constexpr float INFLUENCE_RS_FACTOR = 20.0f;
+constexpr float DISK_REACH = 2.0f;
+
+enum class Integrator {
+    // Newtonian-style bending, dir += normalize(toBH) * bendingStrength * rs / r^2,
+    // with Euler steps of a fixed fraction of the distance to the nearest hole
+    Newtonian,
+    // Null geodesic of the Schwarzschild metric in Cartesian form,
+    // x'' = -bendingStrength * rs * h^2 * x / r^5 (h = |cross(x, x')|, 1.5 is exact),
+    // integrated with embedded Dormand-Prince RK45 and error-controlled steps
+    Schwarzschild
+};
+
+// Quality/speed trade-offs exposed as the "Ray Tracing" settings in the UI.
+// Mirrors the uMaxSteps/uMaxDistance/uStepFactor/uBendingStrength/uIntegrator/
+// uTolerance/uBoundingSpheres uniforms.
+struct MarchParams {
+    int maxSteps = MAX_STEPS;
+    float maxDistance = MAX_DIST;
+    float stepFactor = STEP_FACTOR;
+    float bendingStrength = BENDING_STRENGTH;
+    Integrator integrator = Integrator::Schwarzschild;
+    float tolerance = RK_TOLERANCE;
+    bool boundingSpheres = true; // Skip the empty space outside every influence sphere
+
+    bool operator==(const MarchParams&) const = default;
+};
+
+// --- Starfield & Nebula ---
+// The Starfield settings in the UI; the defaults give the original sky.
+// Mirrors the uStarDensity/uNebulaIntensity uniforms.
+struct SkyParams {
+    float starDensity = 0.995f;   // Hash threshold a grid cell has to reach to hold a star
+    float nebulaIntensity = 1.0f;
+
+    bool operator==(const SkyParams&) const = default;
+};
+
+float hash(glm::vec3 p);
+float noise(const glm::vec3& x);
+glm::vec3 getNebula(const glm::vec3& dir, float intensity = 1.0f);
+glm::vec3 getStarfield(const glm::vec3& dir, const SkyParams& sky = SkyParams());
+
+// What escaped rays see: a lookup in the baked SkyMap if there is one, the
+// procedural starfield otherwise. Mirrors GetSky in raytracer.frag.
+struct Sky {
+    const SkyMap* map = nullptr;
+    float lod = 0.0f;   // Mip level the map is sampled at
+    SkyParams params;   // Of the procedural starfield
+
+    glm::vec3 sample(const glm::vec3& dir) const;
+};
+
+// --- General Relativity ---
+// State of a ray between two integration steps
+struct RayState {
+    glm::vec3 p;
+    glm::vec3 dir;
+    glm::vec3 accumColor; // Volumetric color accumulation
+};
+
+enum class StepResult {
+    Continue,
+    Captured,   // Crossed an event horizon
+    Escaped     // Left every black hole's neighbourhood
+};
+
+// Advances the ray by one adaptive step: bends it, accumulates disk glow and
+// reports whether it terminated. One iteration of the Newtonian TraceGeodesic loop.
+StepResult step(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                const MarchParams& params = MarchParams());
+
+// Radius of the sphere around bh that rays have to be marched in
+float influenceRadius(const BlackHoleData& bh);
+
+// Moves the ray along a straight line to the first influence sphere it
+// enters, bending ray.dir by the weak-field deflection (first order, for the
+// integrator in params) the holes cause on the way, and returns the distance
+// skipped: 0 if it starts inside a sphere. If the ray misses every sphere it
+// returns -1 and ray.dir is its final direction.
+float skipToInfluence(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                      const MarchParams& params = MarchParams());
+
+// Integrates the ray with the integrator selected in params until it is
+// captured, escapes or runs out of steps/distance (Continue). Leaves the final
+// position, unit direction and disk glow in ray.
+StepResult march(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                 const MarchParams& params = MarchParams(), int* stepsTaken = nullptr);
+
+// Traces a ray through curved spacetime with the integrator selected in params
+// and returns its accumulated color, with sky behind it if it escaped. If
+// stepsTaken is given it receives the number of integration steps used (for
+// RK45, rejected attempts included); 0 for a ray skipped by the bounding spheres.
+// If skippedRay is given it receives whether the bounding spheres skipped the
+// ray without marching it.
+glm::vec3 traceGeodesic(const glm::vec3& ro, const glm::vec3& rd,
+                        const BlackHoleData* blackHoles, int numBlackHoles,
+                        int* stepsTaken = nullptr, const MarchParams& params = MarchParams(),
+                        const Sky& sky = Sky(), bool* skippedRay = nullptr);
+
+// Collects every BlackHole in the world into a flat array for the marcher
+std::vector<BlackHoleData> gatherBlackHoles(const World& world);
+
+} // namespace Geodesic
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+
+// Packetized CPU geodesic integrator. Marches SIMD-width packets of rays in
+// lock step with the ray state stored as structure-of-arrays; lanes that hit
+// a horizon, escape or run out of steps are masked off until the whole packet
+// has finished. Produces the same image as Geodesic::traceGeodesic up to
+// floating point rounding.
+//
+// The instruction set is picked at runtime, so one binary uses AVX-512 where
+// available and falls back to AVX2, SSE4.1 or the scalar marcher otherwise.
+namespace GeodesicPacket {
+
+enum class Isa {
+    Scalar,
+    SSE41,
+    AVX2,
+    AVX512
+};
+
+// Best instruction set supported by both this build and the running CPU
+Isa detectIsa();
+bool isSupported(Isa isa);
+const char* isaName(Isa isa);
+bool parseIsa(const char* name, Isa& isa);
+
+// Rays per packet for the given instruction set
+int laneCount(Isa isa);
+
+// Traces `count` rays sharing one origin. Directions are given as SoA and
+// must be normalized; colors, with `sky` behind escaped rays, are written
+// interleaved RGB to outRGB.
+// Returns the total number of integration steps taken by the rays. If
+// skippedRays is given, the number of rays that missed every influence
+// sphere (and so were never marched) is added to it.
+uint64_t traceRays(Isa isa, const glm::vec3& origin,
+                   const float* dirX, const float* dirY, const float* dirZ, int count,
+                   const Geodesic::BlackHoleData* blackHoles, int numBlackHoles,
+                   float* outRGB, const Geodesic::MarchParams& params = Geodesic::MarchParams(),
+                   const Geodesic::Sky& sky = Geodesic::Sky(), uint64_t* skippedRays = nullptr);
+
+} // namespace GeodesicPacket
@@ -2,31 +2,108 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+#include "Accumulation.hpp"
 #include "Camera.hpp"
+#include "DeflectionTable.hpp"
+#include "Geodesic.hpp"
+#include "PostProcess.hpp"
+#include "SkyMap.hpp"
 #include "World.hpp"
 
 class GpuRayTracer {
 public:
+    static constexpr int DEFAULT_TEMPORAL_MAX_AGE = 8;
+
+    // What marches the rays. The fragment backend traces each pixel in a
+    // fragment of a full-screen quad. The compute backend (GL 4.3) marches
+    // them in batches on persistent work groups, compacting the live rays
+    // between batches so no lane waits on another's long ray; it traces every
+    // pixel at full resolution, so march scale and temporal reuse only apply
+    // to the fragment backend.
+    enum class Backend { Fragment, Compute };
+
     GpuRayTracer();
     ~GpuRayTracer();
 
     void init(const std::string& fragmentShaderPath);
-    void render(const Camera& camera, const World& world, int width, int height, float time);
+    // Returns false if no rays were marched because a progressive image has
+    // converged; the post-processing still re-runs if its settings changed
+    bool render(const Camera& camera, const World& world, int width, int height, float time);
     
     // Framebuffer management
     void initFramebuffer(int width, int height);
     void resizeFramebuffer(int width, int height);
-    unsigned int getTextureID() const { return fboTexture; }
+    // The tonemapped RGBA8 image
+    unsigned int getTextureID() const { return postProcess.getTextureID(); }
+    // The RGBA16F image the rays are marched into, before post-processing
+    unsigned int getHdrTextureID() const { return fboTexture; }
     
-    // Shader parameter updates
+    // Shader parameter updates, applied on the next render
     void setMaxSteps(int steps);
     void setMaxDistance(float distance);
+    void setStepFactor(float factor);
     void setBendingStrength(float strength);
+    void setMarchParams(const Geodesic::MarchParams& params) { marchParams = params; }
+    const Geodesic::MarchParams& getMarchParams() const { return marchParams; }
+
+    // Precompiles a shader with these parameters baked in as constants. It is
+    // used instead of the uniform-driven shader whenever the parameters match
+    // exactly, letting the driver unroll and fold the march loop.
+    void addVariant(const Geodesic::MarchParams& params);
+    bool isUsingVariant() const { return usingVariant; }
+
+    // Shade single black-hole scenes from a DeflectionTable texture; rays near
+    // the disk are still marched. Tables are cached per hole size.
+    void setDeflectionLut(bool enabled);
+    bool getDeflectionLut() const { return deflectionLut; }
+    // Whether the last frame actually used the table
+    bool isUsingDeflectionLut() const { return usingDeflectionLut; }
+
+    // Escaped rays sample the map (uploaded as a cubemap when it changes) if
+    // there is one and evaluate the procedural starfield otherwise
+    void setSky(const Geodesic::SkyParams& params, std::shared_ptr<const SkyMap> map);
+
+    // March one ray per scale x scale block of pixels (1, 2 or 4) and upsample,
+    // re-tracing at full resolution only where neighbouring rays disagree
+    void setMarchScale(int scale);
+    int getMarchScale() const { return marchScale; }
+
+    // Reuse the previous frame's ray results where they reproject cleanly
+    // under the new camera pose and trace only the rest. A result is reused
+    // for at most maxAge frames, so the image is re-traced over that many.
+    // Progressive samples after the first are always traced.
+    void setTemporalReuse(bool enabled, int maxAge = DEFAULT_TEMPORAL_MAX_AGE);
+    bool getTemporalReuse() const { return temporalReuse; }
+
+    // Falls back to the fragment backend while compute is unsupported
+    void setBackend(Backend backend);
+    Backend getBackend() const { return backend; }
+    bool isComputeSupported() const { return computeProgram.id != 0; }
+    // Whether the last frame was marched by the compute backend
+    bool isUsingCompute() const { return usingCompute; }
+
+    // Progressive refinement: average jittered samples while the view is unchanged
+    void setProgressive(bool enabled) { progressive = enabled; }
+    Accumulation& getAccumulation() { return accumulation; }
+
+    // Exposure, tonemapping and bloom, applied without re-marching
+    void setPostProcess(const PostProcess::Settings& settings) { postProcess.setSettings(settings); }
+    const PostProcess& getPostProcess() const { return postProcess; }
+
+    // GPU time of the ray-march pass, from a timer query a couple of frames
+    // old so reading it never stalls. 0 until the first result arrives.
+    float getLastRenderMs() const { return lastRenderMs; }
+
+    // Largest number of black holes the scene buffer can hold on this driver
+    int getMaxBlackHoles() const { return maxBlackHoles; }
 
 private:
     unsigned int quadVAO, quadVBO;
-    unsigned int shaderProgram;
     
     // Framebuffer for rendering to texture
     unsigned int fbo = 0;
@@ -35,7 +112,127 @@ private:
     int fboWidth = 0;
     int fboHeight = 0;
 
+    // Uniform locations, resolved once after linking
+    struct UniformLocations {
+        int cameraPos = -1;
+        int view = -1;
+        int projection = -1;
+        int time = -1;
+        int resolution = -1;
+        int jitter = -1;
+        int maxSteps = -1;
+        int maxDistance = -1;
+        int stepFactor = -1;
+        int bendingStrength = -1;
+        int integrator = -1;
+        int tolerance = -1;
+        int boundingSpheres = -1;
+        int useDeflectionTable = -1;
+        int deflectionLogRange = -1;
+        int starDensity = -1;
+        int nebulaIntensity = -1;
+        int useSkyMap = -1;
+        int skyLod = -1;
+        int pass = -1;
+        int upsampleMinCos = -1;
+        int temporal = -1;
+        int prevViewProjection = -1;
+        int prevCameraPos = -1;
+        int maxAge = -1;
+        int reprojectMinCos = -1;
+        int reprojectMaxError = -1;
+        int blendWeight = -1;
+    };
+
+    struct ShaderProgram {
+        unsigned int id = 0;
+        UniformLocations uniforms;
+    };
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    ShaderProgram genericProgram;
+    using VariantList = std::vector<std::pair<Geodesic::MarchParams, ShaderProgram>>;
+    VariantList variants;
+    Geodesic::MarchParams marchParams;
+    bool usingVariant = false;
+
+    // Compute backend, built only on GL 4.3, with a variant for each fragment one
+    Backend backend = Backend::Fragment;
+    bool usingCompute = false;
+    std::string computeSource;
+    ShaderProgram computeProgram;
+    VariantList computeVariants;
+    unsigned int workQueueBuffer = 0; // WorkQueue in raytracer.comp
+
+    Accumulation accumulation;
+    bool progressive = false;
+
+    PostProcess postProcess;
+
+    // Double-buffered GL_TIME_ELAPSED queries
+    unsigned int timerQueries[2] = { 0, 0 };
+    bool queryPending[2] = { false, false };
+    int queryIndex = 0;
+    float lastRenderMs = 0.0f;
+
+    // Scene uniform block (BlackHoleBlock in raytracer.frag), re-sent only
+    // when the World's revision changes
+    unsigned int sceneUBO = 0;
+    int maxBlackHoles = 0;
+    const World* uploadedWorld = nullptr;
+    uint64_t uploadedRevision = 0;
+    std::vector<Geodesic::BlackHoleData> sceneBlackHoles; // What the block holds
+
+    // Deflection lookup table, an RG32F texture re-sent when the table changes
+    bool deflectionLut = false;
+    bool usingDeflectionLut = false;
+    DeflectionCache deflectionCache;
+    std::shared_ptr<const DeflectionTable> uploadedTable;
+    unsigned int deflectionTexture = 0;
+
+    // Sky, an RGB16F cubemap re-sent when the map changes
+    Geodesic::SkyParams skyParams;
+    std::shared_ptr<const SkyMap> skyMap;
+    std::shared_ptr<const SkyMap> uploadedSkyMap;
+    unsigned int skyTexture = 0;
+
+    // Reduced-resolution march targets, RayResults laid out as EmissionOut
+    // and SkyOut in raytracer.frag
+    int marchScale = 1;
+    unsigned int lowResFbo = 0;
+    unsigned int lowResTextures[2] = { 0, 0 };
+    int lowResWidth = 0;
+    int lowResHeight = 0;
+
+    // Temporal history: the RayResult of every pixel of the last unjittered
+    // frame, written as extra attachments of fbo. Two slots, one read while
+    // the other is written.
+    bool temporalReuse = false;
+    int temporalMaxAge = DEFAULT_TEMPORAL_MAX_AGE;
+    unsigned int historyTextures[2][2] = { { 0, 0 }, { 0, 0 } }; // [slot][emission, sky]
+    int historySlot = 0;     // Written next
+    bool historyValid = false;
+    int historyWidth = 0;
+    int historyHeight = 0;
+    glm::mat4 historyViewProjection{ 1.0f };
+    glm::vec3 historyCameraPos{ 0.0f };
+    Geodesic::MarchParams historyParams;
+
     void setupQuad();
     void setupShaders(const std::string& fragmentShaderPath);
+    ShaderProgram buildProgram(const std::string& defines);
+    ShaderProgram buildComputeProgram(const std::string& defines);
+    void resolveUniforms(ShaderProgram& program);
+    static const ShaderProgram* findVariant(const VariantList& list, const Geodesic::MarchParams& params);
+    void dispatchCompute(const UniformLocations& uniforms, int width, int height, float blendWeight);
+    void setupSceneBuffer();
+    void uploadScene(const World& world);
+    void uploadDeflectionTable(const std::shared_ptr<const DeflectionTable>& table);
+    void uploadSkyMap();
     void cleanupFramebuffer();
+    void setupLowResTargets(int width, int height);
+    void cleanupLowResTargets();
+    void setupHistory(int width, int height);
+    void cleanupHistory();
 };
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Dependency-free image output for the headless renderer. Input is the linear
+// RGB float buffer produced by CpuRenderer (row 0 = bottom of the image).
+// Integer formats clamp it to [0, 1]; PFM and EXR keep the HDR values.
+namespace ImageWriter {
+
+enum class Format {
+    PPM,  // 8-bit binary P6
+    PFM,  // 32-bit float
+    PNG,  // 8 or 16-bit RGB, deflated (see Deflate.hpp)
+    EXR,  // Half-float RGB, ZIP compressed in blocks of 16 rows
+    YUV,  // Raw planar 4:2:0, BT.709 video range: yuv420p, or yuv420p16le at 16 bits
+    RGB,  // Raw interleaved rgb24, or rgb48le at 16 bits
+};
+
+// By extension: .pfm, .png, .exr, .yuv and .rgb; anything else is PPM
+Format formatFor(const std::string& path);
+const char* formatName(Format format);
+
+// Raw frames have no header, so a sequence of them is just one after another
+inline bool isRawFormat(Format format) { return format == Format::YUV || format == Format::RGB; }
+
+// Encodes one image into out, replacing its contents (its capacity is kept,
+// so a reused buffer stops allocating). bitDepth (8 or 16) applies to PNG,
+// YUV and RGB; rows are written top to bottom except in PFM.
+void encode(Format format, const std::vector<float>& pixels, int width, int height, int bitDepth,
+            std::vector<unsigned char>& out);
+
+bool writeFile(const std::string& path, const std::vector<unsigned char>& bytes);
+
+// 8-bit binary PPM (P6), values clamped to [0, 1]
+bool writePPM(const std::string& path, const std::vector<float>& pixels, int width, int height);
+
+// 32-bit float PFM, keeps the unclamped HDR values
+bool writePFM(const std::string& path, const std::vector<float>& pixels, int width, int height);
+
+// Picks the format from the file extension
+bool write(const std::string& path, const std::vector<float>& pixels, int width, int height, int bitDepth = 8);
+
+} // namespace ImageWriter
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+
+// Turns the HDR image GpuRayTracer marches into the 8-bit image on screen:
+// an optional bloom built from a chain of half-size levels, then exposure
+// and a tonemapping curve. It is a handful of cheap full-screen passes over
+// the finished image, so changing any of its settings only re-runs them and
+// never re-marches a ray; a converged progressive image is simply tonemapped
+// again.
+class PostProcess {
+public:
+    static constexpr int MAX_BLOOM_LEVELS = 8;
+
+    enum class Tonemap {
+        Clamp,    // Values above 1 clip, as the unprocessed image did
+        Reinhard, // x / (1 + x)
+        Aces,     // Filmic, with a toe and a soft shoulder
+    };
+
+    struct Settings {
+        float exposure = 0.0f;        // In stops; +1 doubles the brightness
+        Tonemap tonemap = Tonemap::Clamp;
+        float bloomStrength = 0.0f;   // 0 turns bloom off
+        float bloomThreshold = 1.0f;  // Brightness where glow starts, before exposure
+        float bloomKnee = 0.5f;       // Half-width of the soft transition around the threshold
+        int bloomLevels = 6;          // Each level doubles the glow's radius
+
+        bool operator==(const Settings&) const = default;
+    };
+
+    PostProcess() = default;
+    ~PostProcess();
+
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    // Sources of the full-screen quad shader the ray tracer draws with and of postprocess.frag
+    void init(const std::string& vertexSource, const std::string& fragmentSource);
+
+    void setSettings(const Settings& settings);
+    const Settings& getSettings() const { return settings; }
+    // Whether the output is out of date with the settings
+    bool isStale() const { return stale; }
+
+    // Runs the passes over hdrTexture (width x height) into the output
+    // texture, drawing with quadVAO. Leaves the default framebuffer bound.
+    void apply(unsigned int quadVAO, unsigned int hdrTexture, int width, int height);
+
+    // RGBA8, width x height as of the last apply()
+    unsigned int getTextureID() const { return outputTexture; }
+
+    // GPU time of the passes, from a timer query a couple of applies old.
+    // 0 until the first result arrives.
+    float getLastMs() const { return lastMs; }
+
+private:
+    Settings settings;
+    bool stale = true;
+
+    unsigned int program = 0;
+    struct UniformLocations {
+        int pass = -1;
+        int bloomThreshold = -1;
+        int bloomKnee = -1;
+        int bloomStrength = -1;
+        int exposure = -1;
+        int tonemap = -1;
+        int bloom = -1;
+    } uniforms;
+
+    unsigned int outputFbo = 0;
+    unsigned int outputTexture = 0;
+    int width = 0;
+    int height = 0;
+
+    // Level i is (width >> (i + 1)) x (height >> (i + 1)), stopping before a
+    // side would drop below MIN_BLOOM_SIZE texels
+    unsigned int bloomFbos[MAX_BLOOM_LEVELS] = {};
+    unsigned int bloomTextures[MAX_BLOOM_LEVELS] = {};
+    int bloomWidths[MAX_BLOOM_LEVELS] = {};
+    int bloomHeights[MAX_BLOOM_LEVELS] = {};
+    int bloomLevelCount = 0;
+
+    // Double-buffered GL_TIME_ELAPSED queries
+    unsigned int timerQueries[2] = { 0, 0 };
+    bool queryPending[2] = { false, false };
+    int queryIndex = 0;
+    float lastMs = 0.0f;
+
+    void setupTargets(int width, int height);
+    void cleanupTargets();
+    void bloom(unsigned int hdrTexture);
+};
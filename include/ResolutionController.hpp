@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Dynamic resolution scaling. Fed the measured render time of each frame, it
+// adjusts a scale factor applied to the output resolution so rendering stays
+// within the frame-time budget; the scaled image is stretched back to the
+// viewport. Render cost is treated as proportional to pixel count (scale^2).
+// Under load it drops straight to the scale that fits, but recovers one step
+// at a time and only with clear headroom, so it does not oscillate.
+class ResolutionController {
+public:
+    enum class Decision {
+        Hold,
+        ScaleUp,
+        ScaleDown
+    };
+
+    static constexpr float SCALE_STEP = 0.05f;
+
+    void setTargetFrameMs(float ms) { targetMs = ms > 0.0f ? ms : targetMs; }
+    float getTargetFrameMs() const { return targetMs; }
+    void setScaleRange(float minScale, float maxScale);
+
+    // Feeds the render time of the last frame and returns the scale for the next one
+    float update(float renderMs);
+    // Back to full resolution, forgetting past measurements
+    void reset();
+
+    float getScale() const { return scale; }
+    float getSmoothedMs() const { return smoothedMs; }
+    Decision getLastDecision() const { return lastDecision; }
+    float getLastDecisionMs() const { return lastDecisionMs; } // Smoothed time that triggered it
+
+    // Output size scaled by the current factor, at least 1x1
+    glm::ivec2 apply(int width, int height) const;
+
+private:
+    float targetMs = 1000.0f / 60.0f;
+    float minScale = 0.25f;
+    float maxScale = 1.0f;
+    float scale = 1.0f;
+
+    float smoothedMs = 0.0f;
+    bool hasSample = false;
+    int cooldown = 0;            // Frames to wait after a change before measuring again
+
+    Decision lastDecision = Decision::Hold;
+    float lastDecisionMs = 0.0f;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+class World;
+
+// Scene files, in two interchangeable forms.
+//
+// Text, one object per line; '#' starts a comment:
+//     blackhole X Y Z MASS [DISK_INNER DISK_OUTER]
+//     object X Y Z
+// Without disk radii a black hole gets the BlackHole defaults (3 rs, 9 rs).
+//
+// Binary: a fixed header followed by the World pool columns as raw,
+// 64-byte aligned little-endian arrays. Loading maps the file and copies
+// each column into the pools with one memcpy, so no object is parsed.
+//
+// Loaders append to the given world and return false (after printing why)
+// if the file is unreadable or malformed; the world may then hold the
+// objects read before the error.
+namespace SceneFile {
+
+bool loadText(const std::string& path, World& world);
+bool saveText(const std::string& path, const World& world);
+
+bool loadBinary(const std::string& path, World& world);
+bool saveBinary(const std::string& path, const World& world);
+
+// The binary form in memory, e.g. for sending a scene over a socket
+std::vector<unsigned char> encodeBinary(const World& world);
+bool decodeBinary(const unsigned char* data, size_t size, World& world);
+
+// Whether the file starts with the binary scene header
+bool isBinary(const std::string& path);
+
+// Loads either form, told apart by the header
+bool load(const std::string& path, World& world);
+
+// One entry of a line-based text format (text scenes, camera paths): a
+// keyword followed by whitespace-separated numbers, '#' starting a comment
+struct TextLine {
+    int number = 0;           // Line in the file, counting from 1
+    std::string keyword;
+    std::vector<float> values;
+    bool numeric = true;      // Every field after the keyword is a number
+};
+
+// Reads the next entry of in, skipping blank and comment-only lines. Keep
+// one TextLine per stream so number keeps counting. False at the end.
+bool readTextLine(std::istream& in, TextLine& line);
+
+} // namespace SceneFile
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+
+class ThreadPool;
+
+// The procedural starfield and nebula (Geodesic::getStarfield) baked into a
+// mip-mapped HDR cubemap, so an escaped ray costs one filtered lookup instead
+// of the 25 hash evaluations of the procedural sky. Each texel averages 2x2
+// samples of the procedural sky and each mip level 2x2 texels of the level
+// above, so stars shrinking below a pixel fade out instead of flickering.
+//
+// Faces are stored in the OpenGL cubemap order and orientation (+X, -X, +Y,
+// -Y, +Z, -Z; rows from t = 0) and texels are rounded to half precision, so
+// GpuRayTracer uploads the levels as they are to an RGB16F texture and both
+// renderers see the same sky.
+class SkyMap {
+public:
+    static constexpr int FACES = 6;
+    static constexpr int DEFAULT_FACE_SIZE = 512;
+
+    // Bakes the map. faceSize is rounded up to a power of two; with a pool
+    // the rows are baked in parallel.
+    explicit SkyMap(const Geodesic::SkyParams& params, int faceSize = DEFAULT_FACE_SIZE, ThreadPool* pool = nullptr);
+
+    // Reads a map written by save(). Returns nullptr if the file is missing,
+    // unreadable or holds a map baked for other settings or by another version.
+    static std::shared_ptr<const SkyMap> load(const std::string& path, const Geodesic::SkyParams& params,
+                                              int faceSize = DEFAULT_FACE_SIZE);
+    bool save(const std::string& path) const;
+
+    const Geodesic::SkyParams& getParams() const { return params; }
+    int getFaceSize() const { return faceSize; }
+    int getLevelCount() const { return static_cast<int>(levelOffsets.size()); }
+    int getLevelSize(int level) const { return faceSize >> level; }
+    // RGB texels of one level, face after face, row by row
+    const float* getLevel(int level) const { return data.data() + levelOffsets[level]; }
+
+    // Trilinear lookup at a fractional mip level, clamped at the face edges
+    // like the GPU texture
+    glm::vec3 sample(const glm::vec3& dir, float lod = 0.0f) const;
+
+    // Mip level at which a texel is as wide as a pixel covering pixelAngle radians
+    float lodForPixel(float pixelAngle) const;
+
+private:
+    Geodesic::SkyParams params;
+    int faceSize = 0;
+    std::vector<size_t> levelOffsets; // Start of each level in data
+    std::vector<float> data;
+
+    SkyMap() = default; // Filled in by load()
+    void allocateLevels();
+    glm::vec3 sampleLevel(int face, float s, float t, int level) const;
+};
+
+// Hands out the map for the current sky settings, baking it only if neither
+// the last map nor one saved to the cache directory by an earlier run matches.
+class SkyCache {
+public:
+    // An empty directory keeps maps in memory only
+    explicit SkyCache(std::string directory = "cache") : directory(std::move(directory)) {}
+
+    std::shared_ptr<const SkyMap> get(const Geodesic::SkyParams& params, int faceSize = SkyMap::DEFAULT_FACE_SIZE,
+                                      ThreadPool* pool = nullptr);
+
+    // Where the map for these settings is saved
+    std::string pathFor(const Geodesic::SkyParams& params, int faceSize) const;
+
+private:
+    std::string directory;
+    std::shared_ptr<const SkyMap> current;
+};
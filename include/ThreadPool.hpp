@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool with per-worker queues and work stealing.
+// Threads are created once and reused for every job, so a renderer can keep
+// one pool for its whole lifetime instead of spawning threads per frame.
+class ThreadPool {
+public:
+    // threadCount == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Runs task(index, workerIndex) for every index in [0, count) and blocks
+    // until all of them have finished. Indices are dealt out round-robin to
+    // the worker queues; a worker that drains its own queue steals from the
+    // back of the others'. Not reentrant: one job runs at a time.
+    void parallelFor(int count, const std::function<void(int, int)>& task);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<int> items;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::mutex jobMutex;        // Serializes parallelFor callers
+    std::mutex stateMutex;      // Guards generation/stopping for the condition variables
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const std::function<void(int, int)>* currentTask = nullptr;
+    uint64_t generation = 0;
+    std::atomic<int> remaining{ 0 };
+    bool stopping = false;
+
+    void workerLoop(unsigned int workerIndex);
+    bool popOrSteal(unsigned int workerIndex, int& item);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer, single-consumer handoff of the newest value.
+// The producer fills write() and publish()es it; the consumer calls update()
+// and reads read(). Three slots mean neither side ever waits for the other:
+// one slot is being written, one read, and the third holds the newest
+// published value. A value published before the consumer took the previous
+// one replaces it, so the consumer always sees the latest and may skip some.
+template <typename T>
+class TripleBuffer {
+public:
+    // --- Producer ---
+    T& write() { return slots[writeIndex]; }
+    // Hands the write slot over and starts writing into the one it replaces
+    void publish() {
+        uint8_t previous = state.exchange(static_cast<uint8_t>(writeIndex | FRESH), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+    // Whether the last published value has not been taken by update() yet
+    bool hasPending() const { return (state.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    // --- Consumer ---
+    // Takes the newest published value, if there is one the consumer hasn't seen
+    bool update() {
+        if (!hasPending()) return false;
+        uint8_t previous = state.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+    const T& read() const { return slots[readIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    std::array<T, 3> slots{};
+    uint8_t writeIndex = 0;             // Producer only
+    uint8_t readIndex = 1;              // Consumer only
+    std::atomic<uint8_t> state{ 2 };    // Index of the shared slot, plus FRESH once published into
+};
@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <array>
+#include "ResolutionController.hpp"
 
 // Forward declarations
 class Camera;
@@ -23,8 +24,36 @@ public:
         float maxDistance = 10000.0f;
         float adaptiveStepSize = 0.08f;
         float bendingStrength = 1.5f;
+        bool schwarzschild = true;  // RK45 Schwarzschild geodesics instead of Newtonian bending
+        float tolerance = 1e-3f;    // RK45 local error tolerance
+        bool deflectionLut = false; // Shade single black-hole scenes from precomputed geodesics
+        bool boundingSpheres = true; // Only march rays within a black hole's influence sphere
+        bool bakedSky = true;       // Escaped rays sample the starfield baked into a cubemap
+        int marchScale = 1;         // GPU marches one ray per marchScale x marchScale pixels and upsamples
+        bool temporalReuse = false; // GPU reuses the previous frame's rays where they reproject cleanly
+        bool computeBackend = false; // GPU marches with the persistent-thread compute shader (GL 4.3)
+        bool cpuTenBitDisplay = false; // CPU frames are displayed as RGB10A2 instead of RGBA8
+        int cpuPipelineDepth = 2;   // 0 traces CPU frames on the UI thread, 1-2 on a render thread that far ahead
+        bool progressive = true;   // Accumulate jittered samples while the view is still
+        int maxSamples = 64;
+        // GPU post-processing, re-applied without re-marching
+        float exposure = 0.0f;      // Stops
+        int tonemap = 0;            // PostProcess::Tonemap
+        float bloomStrength = 0.0f; // 0 = off
+        float bloomThreshold = 1.0f;
+        int bloomLevels = 6;
     };
 
+    // Ray Tracing slider values with a precompiled GPU shader behind them
+    struct QualityPreset {
+        const char* name;
+        int maxRaySteps;
+        float maxDistance;
+        float adaptiveStepSize;
+        float bendingStrength;
+    };
+    static const std::array<QualityPreset, 3>& getQualityPresets();
+
     struct CameraSettings {
         glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
         float yaw = -90.0f;
@@ -47,6 +76,50 @@ public:
         float targetFps = 60.0f;
         std::array<float, 100> frameTimeHistory = {};
         int frameTimeIndex = 0;
+        bool dynamicResolution = true;   // Scale the render resolution to hold targetFps
+        float minResolutionScale = 0.5f;
+        std::array<float, 100> resolutionScaleHistory = {};
+        int resolutionScaleIndex = 0;
+    };
+
+    // What the Performance panel reports about the renderer in use, gathered
+    // from the tracers every frame. Fields of the other renderer are ignored.
+    struct RendererStats {
+        bool gpu = true;
+        bool usingDeflectionLut = false;
+        int skyFaceSize = 0;              // Of the baked sky cubemap; 0 = none
+
+        // GPU
+        bool specializedShader = false;   // A precompiled preset rather than the generic shader
+        bool computeSelected = false;     // Compute backend asked for...
+        bool usingCompute = false;        // ...and available
+        int marchScale = 1;               // Fragment backend only, like temporal reuse
+        bool temporalReuse = false;
+        int temporalMaxAge = 0;           // Frames
+        float postProcessMs = 0.0f;
+
+        // CPU
+        bool countSkippedRays = false;    // Bounding spheres on and a frame traced
+        float skippedRayPercent = 0.0f;
+        float traceMs = 0.0f;
+        float uploadMs = 0.0f;
+        bool persistentPbos = false;
+        int pipelineDepth = 0;            // Frames the render thread runs ahead; 0 = UI thread
+
+        // Progressive refinement
+        bool progressive = false;
+        int samples = 0;
+        int maxSamples = 0;
+
+        // Dynamic resolution
+        bool dynamicResolution = false;
+        int renderWidth = 0;
+        int renderHeight = 0;
+        float resolutionScale = 1.0f;
+        float smoothedMs = 0.0f;
+        float budgetMs = 0.0f;
+        ResolutionController::Decision lastDecision = ResolutionController::Decision::Hold;
+        float lastDecisionMs = 0.0f;
     };
 
     // --- Constructor & Destructor ---
@@ -75,6 +148,9 @@ public:
 
     // --- Performance Tracking ---
     void updateFrameTime(float deltaTime);
+    void recordResolutionScale(float scale);
+    // Renderer status shown in the Performance panel
+    void setRendererStats(const RendererStats& stats) { rendererStats = stats; }
 
 private:
     // --- Settings ---
@@ -86,6 +162,7 @@ private:
     // --- UI State ---
     bool uiMode = false;  // false = Viewport mode, true = UI mode
     bool firstFrame = true;
+    RendererStats rendererStats;
 
     // --- Panel Rendering Methods ---
     void renderDockspace();
@@ -94,6 +171,7 @@ private:
     void renderCameraSettingsPanel();
     void renderSceneSettingsPanel();
     void renderPerformancePanel(float fps);
+    void renderRendererStats();
     void renderInfoBar();
 
     // --- Helper Methods ---
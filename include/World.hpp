@@ -1,23 +1,233 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
+#include <tuple>
 #include <vector>
-#include <memory>
+#include <glm/glm.hpp>
+#include "Arena.hpp"
+#include "objects/BlackHole.hpp"
 #include "objects/Object.hpp"
 
-class World {
+// Stable reference to an object in one of the World's pools. It survives
+// other objects being added or removed; once its own object is removed the
+// slot's generation moves on and the handle no longer resolves.
+template <typename T>
+struct Handle {
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+    uint32_t slot = NONE;
+    uint32_t generation = 0;
+
+    bool operator==(const Handle&) const = default;
+};
+
+using BlackHoleHandle = Handle<BlackHole>;
+using ObjectHandle = Handle<Object>;
+
+// Structure-of-arrays storage for one object type. Every column is a
+// contiguous, 64-byte aligned arena array indexed [0, size()), so renderers
+// can copy or vectorize over them without touching individual objects.
+// Removing an object moves the last one into the gap; handles go through a
+// slot table and are not affected by that.
+template <typename T, typename... Columns>
+class Pool {
 public:
-    std::vector<std::shared_ptr<Object>> objects;
+    using HandleType = Handle<T>;
 
-    void add(std::shared_ptr<Object> obj);
-    void clear();
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    template <size_t I>
+    const auto* column() const { return std::get<I>(columns); }
+
+    bool contains(HandleType handle) const {
+        return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
+    }
+    // Position in the columns, or size() for a stale handle
+    size_t indexOf(HandleType handle) const { return contains(handle) ? slots[handle.slot].index : count; }
+    HandleType handleAt(size_t index) const {
+        uint32_t slot = indexSlots[index];
+        return { slot, slots[slot].generation };
+    }
+
+protected:
+    HandleType insert(Arena& arena, const Columns&... values) {
+        if (count == capacity) grow(arena, count + 1);
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back({ 0, 0 });
+        }
+        size_t index = count++;
+        slots[slot].index = static_cast<uint32_t>(index);
+        indexSlots.push_back(slot);
+        write(index, values...);
+        return { slot, slots[slot].generation };
+    }
 
-    // Helper to find the first object of a specific type (e.g., BlackHole)
-    template <typename T>
-    std::shared_ptr<T> getFirst() const {
-        for (const auto& obj : objects) {
-            if (auto casted = std::dynamic_pointer_cast<T>(obj)) {
-                return casted;
+    bool erase(HandleType handle) {
+        if (!contains(handle)) return false;
+        size_t index = slots[handle.slot].index;
+        size_t last = count - 1;
+        if (index != last) {
+            std::apply([&](auto*... column) { ((column[index] = column[last]), ...); }, columns);
+            indexSlots[index] = indexSlots[last];
+            slots[indexSlots[index]].index = static_cast<uint32_t>(index);
+        }
+        indexSlots.pop_back();
+        --count;
+        ++slots[handle.slot].generation;
+        freeSlots.push_back(handle.slot);
+        return true;
+    }
+
+    // Appends n objects column by column, one memcpy per column
+    void append(Arena& arena, size_t n, const Columns*... values) {
+        if (n == 0) return;
+        if (count + n > capacity) grow(arena, count + n);
+        std::apply([&](auto*... column) {
+            (std::memcpy(column + count, values, n * sizeof(*values)), ...);
+        }, columns);
+        indexSlots.reserve(count + n);
+        for (size_t index = count; index < count + n; ++index) {
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = static_cast<uint32_t>(slots.size());
+                slots.push_back({ 0, 0 });
             }
+            slots[slot].index = static_cast<uint32_t>(index);
+            indexSlots.push_back(slot);
         }
-        return nullptr;
+        count += n;
     }
+
+    void write(size_t index, const Columns&... values) {
+        std::apply([&](auto*... column) { ((column[index] = values), ...); }, columns);
+    }
+
+    // Drops every object and invalidates all handles. The columns' memory
+    // belongs to the arena, which the caller resets.
+    void clear() {
+        count = 0;
+        capacity = 0;
+        columns = {};
+        indexSlots.clear();
+        freeSlots.clear();
+        for (uint32_t slot = 0; slot < slots.size(); ++slot) {
+            ++slots[slot].generation;
+            freeSlots.push_back(slot);
+        }
+    }
+
+private:
+    struct Slot {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    std::tuple<Columns*...> columns{};
+    size_t count = 0;
+    size_t capacity = 0;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> indexSlots; // Column index -> slot
+    std::vector<uint32_t> freeSlots;
+
+    // At least doubles the columns; the old arrays stay in the arena until it is reset
+    void grow(Arena& arena, size_t minCapacity) {
+        size_t newCapacity = capacity > 0 ? capacity * 2 : 16;
+        if (newCapacity < minCapacity) newCapacity = minCapacity;
+        std::apply([&](auto*&... column) {
+            ((column = relocate(arena, column, newCapacity)), ...);
+        }, columns);
+        capacity = newCapacity;
+    }
+
+    template <typename C>
+    C* relocate(Arena& arena, C* old, size_t newCapacity) {
+        C* fresh = arena.allocate<C>(newCapacity, 64);
+        if (count > 0) std::memcpy(fresh, old, count * sizeof(C));
+        return fresh;
+    }
+};
+
+// Columns: position, mass, Schwarzschild radius, disk inner and outer radius
+class BlackHolePool : public Pool<BlackHole, glm::vec3, float, float, float, float> {
+public:
+    const glm::vec3* positions() const { return column<0>(); }
+    const float* masses() const { return column<1>(); }
+    const float* schwarzschildRadii() const { return column<2>(); }
+    const float* diskInner() const { return column<3>(); }
+    const float* diskOuter() const { return column<4>(); }
+
+    BlackHole get(size_t index) const;
+
+private:
+    friend class World;
+};
+
+// Columns: position
+class ObjectPool : public Pool<Object, glm::vec3> {
+public:
+    const glm::vec3* positions() const { return column<0>(); }
+
+    Object get(size_t index) const { return Object(positions()[index]); }
+
+private:
+    friend class World;
+};
+
+// Scene storage: one pool per object type, all allocated from one arena.
+class World {
+public:
+    World() = default;
+    World(World&&) = default;
+    World& operator=(World&&) = default;
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    BlackHoleHandle add(const BlackHole& blackHole);
+    ObjectHandle add(const Object& object);
+
+    // Bulk appends given as columns, e.g. straight from a mapped scene file
+    void addBlackHoles(size_t count, const glm::vec3* positions, const float* masses, const float* rs,
+                       const float* diskInner, const float* diskOuter);
+    void addObjects(size_t count, const glm::vec3* positions);
+
+    // Return false for stale handles
+    bool remove(BlackHoleHandle handle);
+    bool remove(ObjectHandle handle);
+    bool update(BlackHoleHandle handle, const BlackHole& blackHole);
+    bool update(ObjectHandle handle, const Object& object);
+
+    void clear();
+
+    // Compact copy of every object's columns, in pool order, for a renderer
+    // running on another thread. Handles of this world do not resolve in it;
+    // the revision is the same, as it holds the same scene.
+    World snapshot() const;
+
+    const BlackHolePool& getBlackHoles() const { return blackHoles; }
+    const ObjectPool& getObjects() const { return objects; }
+    size_t size() const { return blackHoles.size() + objects.size(); }
+    const Arena& getArena() const { return arena; }
+
+    // Bumped on every change so renderers can skip re-uploading an unchanged scene.
+    // Taken from a process-wide counter, so only a world and its snapshots ever
+    // share one: a revision identifies a scene even across worlds that reuse
+    // each other's memory.
+    uint64_t getRevision() const { return revision; }
+    void markChanged() { revision = nextRevision(); }
+
+private:
+    Arena arena;
+    BlackHolePool blackHoles;
+    ObjectPool objects;
+    uint64_t revision = nextRevision();
+
+    static uint64_t nextRevision();
 };
@@ -1,10 +1,11 @@
 #pragma once
 #include <glm/glm.hpp>
 
+// Description of a scene object. World copies it into its pools; the
+// object itself is not kept.
 class Object {
 public:
     glm::vec3 position;
 
     Object(glm::vec3 pos = glm::vec3(0.0f)) : position(pos) {}
-    virtual ~Object() = default;
 };
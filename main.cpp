@@ -12,11 +12,30 @@
 #include "EventHandler.hpp"
 #include "GpuRayTracer.hpp"
 #include "CpuRayTracer.hpp"
+#include "ResolutionController.hpp"
+#include "SceneFile.hpp"
+#include "SkyMap.hpp"
 #include "World.hpp"
 #include "objects/BlackHole.hpp"
 #include "UIManager.hpp"
-int main()
+int main(int argc, char** argv)
 {
+    // Command line: --scene PATH loads a text or binary scene file instead of the built-in scene,
+    // --gpu-backend picks the GPU marcher the session starts with
+    std::string scenePath;
+    bool computeBackend = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scene" && i + 1 < argc) {
+            scenePath = argv[++i];
+        } else if (arg == "--gpu-backend" && i + 1 < argc &&
+                   (std::string(argv[i + 1]) == "fragment" || std::string(argv[i + 1]) == "compute")) {
+            computeBackend = std::string(argv[++i]) == "compute";
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--scene PATH] [--gpu-backend fragment|compute]" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
     // 1. Initialize GLFW
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -52,6 +71,7 @@ int main()
     // --- UI Manager Setup ---
     UIManager uiManager;
     uiManager.init();
+    uiManager.getRenderSettings().computeBackend = computeBackend;
     // --- Scene Setup ---
     // Camera - initialize with UI settings
     Camera camera(uiManager.getCameraSettings().position);
@@ -62,8 +82,11 @@ int main()
     camera.zoom = uiManager.getRenderSettings().fov;
     // World
     World world;
-    auto blackHole = std::make_shared<BlackHole>(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f, 0.0f, 0.0f);
-    world.add(blackHole);
+    if (scenePath.empty()) {
+        world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f, 0.0f, 0.0f));
+    } else if (!SceneFile::load(scenePath, world)) {
+        return -1;
+    }
     // Event Handler
     EventHandler eventHandler(camera, 1920.0f, 1080.0f);
     // Register callbacks - DON'T override ImGui's cursor callback
@@ -74,11 +97,21 @@ int main()
     // --- Initialize Ray Tracers ---
     GpuRayTracer gpuTracer;
     gpuTracer.init("shaders/raytracer.frag");
+    // Keep a specialized shader for each quality preset
+    for (const auto& preset : UIManager::getQualityPresets()) {
+        gpuTracer.addVariant({ preset.maxRaySteps, preset.maxDistance, preset.adaptiveStepSize, preset.bendingStrength });
+    }
     gpuTracer.initFramebuffer(uiManager.getRenderSettings().width, 
                              uiManager.getRenderSettings().height);
     CpuRayTracer cpuTracer;
     cpuTracer.init(uiManager.getRenderSettings().width, 
                    uiManager.getRenderSettings().height);
+    // Sky cubemap, shared by both renderers and kept on disk between runs
+    SkyCache skyCache;
+    Geodesic::SkyParams skyParams;
+    // Dynamic resolution; GPU and CPU frame times aren't comparable, so it restarts on a mode switch
+    ResolutionController resolutionController;
+    bool previousGpuMode = eventHandler.isGpuMode();
     // Timing
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
@@ -146,15 +179,107 @@ int main()
         ImGui::NewFrame();
         // Render scene to framebuffer texture
         auto& renderSettings = uiManager.getRenderSettings();
+        Geodesic::MarchParams marchParams{ renderSettings.maxRaySteps, renderSettings.maxDistance,
+                                           renderSettings.adaptiveStepSize, renderSettings.bendingStrength,
+                                           renderSettings.schwarzschild ? Geodesic::Integrator::Schwarzschild
+                                                                        : Geodesic::Integrator::Newtonian,
+                                           renderSettings.tolerance, renderSettings.boundingSpheres };
+        gpuTracer.setMarchParams(marchParams);
+        cpuTracer.setMarchParams(marchParams);
+        gpuTracer.setProgressive(renderSettings.progressive);
+        gpuTracer.getAccumulation().setMaxSamples(renderSettings.maxSamples);
+        cpuTracer.setProgressive(renderSettings.progressive);
+        cpuTracer.setMaxSamples(renderSettings.maxSamples);
+        gpuTracer.setDeflectionLut(renderSettings.deflectionLut);
+        gpuTracer.setMarchScale(renderSettings.marchScale);
+        gpuTracer.setTemporalReuse(renderSettings.temporalReuse);
+        gpuTracer.setBackend(renderSettings.computeBackend ? GpuRayTracer::Backend::Compute
+                                                           : GpuRayTracer::Backend::Fragment);
+        PostProcess::Settings postSettings;
+        postSettings.exposure = renderSettings.exposure;
+        postSettings.tonemap = static_cast<PostProcess::Tonemap>(renderSettings.tonemap);
+        postSettings.bloomStrength = renderSettings.bloomStrength;
+        postSettings.bloomThreshold = renderSettings.bloomThreshold;
+        postSettings.bloomLevels = renderSettings.bloomLevels;
+        gpuTracer.setPostProcess(postSettings);
+        cpuTracer.setDisplayFormat(renderSettings.cpuTenBitDisplay ? CpuRayTracer::DisplayFormat::RGB10A2
+                                                                   : CpuRayTracer::DisplayFormat::RGBA8);
+        cpuTracer.setDeflectionLut(renderSettings.deflectionLut);
+        cpuTracer.setPipelineDepth(renderSettings.cpuPipelineDepth);
+        // Wait for a Starfield slider to be released rather than baking a sky for every value it passes.
+        // Baking borrows the CPU renderer's pool, waiting for a frame on the render thread to finish first.
+        auto& sceneSettings = uiManager.getSceneSettings();
+        if (!ImGui::IsAnyItemActive()) {
+            skyParams = { sceneSettings.starfieldDensity, sceneSettings.nebulaIntensity };
+        }
+        std::shared_ptr<const SkyMap> skyMap;
+        if (renderSettings.bakedSky) {
+            skyMap = skyCache.get(skyParams, SkyMap::DEFAULT_FACE_SIZE, &cpuTracer.getRenderer().getPool());
+        }
+        gpuTracer.setSky(skyParams, skyMap);
+        cpuTracer.setSky(skyParams, skyMap);
+        auto& perfSettings = uiManager.getPerformanceSettings();
+        if (!perfSettings.dynamicResolution || eventHandler.isGpuMode() != previousGpuMode) {
+            resolutionController.reset();
+            previousGpuMode = eventHandler.isGpuMode();
+        }
+        resolutionController.setTargetFrameMs(1000.0f / perfSettings.targetFps);
+        resolutionController.setScaleRange(perfSettings.minResolutionScale, 1.0f);
+        // The scaled frame is stretched over the viewport by the UI
+        glm::ivec2 renderSize = resolutionController.apply(renderSettings.width, renderSettings.height);
+        bool rendered;
+        float renderMs;
         if (eventHandler.isGpuMode()) {
-            gpuTracer.render(camera, world, renderSettings.width, renderSettings.height, currentFrame);
+            rendered = gpuTracer.render(camera, world, renderSize.x, renderSize.y, currentFrame);
+            renderMs = gpuTracer.getLastRenderMs();
         } else {
-            cpuTracer.render(camera, renderSettings.width, renderSettings.height);
+            rendered = cpuTracer.render(camera, world, renderSize.x, renderSize.y);
+            renderMs = cpuTracer.getLastRenderMs();
+        }
+        // A converged progressive frame costs nothing and says nothing about the load
+        if (perfSettings.dynamicResolution && rendered && renderMs > 0.0f) {
+            resolutionController.update(renderMs);
         }
         // Render UI with viewport texture
         unsigned int viewportTexture = eventHandler.isGpuMode() ? 
-                                       gpuTracer.getTextureID() : 0; // CPU mode doesn't have texture yet
+                                       gpuTracer.getTextureID() : cpuTracer.getTextureID();
         
+        UIManager::RendererStats rendererStats;
+        rendererStats.gpu = eventHandler.isGpuMode();
+        const FramePipeline::Stats& cpuStats = cpuTracer.getLastFrameStats();
+        rendererStats.usingDeflectionLut = rendererStats.gpu ? gpuTracer.isUsingDeflectionLut() : cpuStats.usingDeflectionLut;
+        rendererStats.skyFaceSize = skyMap ? skyMap->getFaceSize() : 0;
+        rendererStats.specializedShader = gpuTracer.isUsingVariant();
+        rendererStats.computeSelected = gpuTracer.getBackend() == GpuRayTracer::Backend::Compute;
+        rendererStats.usingCompute = gpuTracer.isUsingCompute();
+        rendererStats.marchScale = gpuTracer.getMarchScale();
+        rendererStats.temporalReuse = gpuTracer.getTemporalReuse();
+        rendererStats.temporalMaxAge = GpuRayTracer::DEFAULT_TEMPORAL_MAX_AGE;
+        rendererStats.postProcessMs = gpuTracer.getPostProcess().getLastMs();
+        rendererStats.countSkippedRays = renderSettings.boundingSpheres && cpuStats.width > 0;
+        if (rendererStats.countSkippedRays) {
+            double rays = static_cast<double>(cpuStats.width) * cpuStats.height;
+            rendererStats.skippedRayPercent = static_cast<float>(100.0 * cpuStats.skippedRays / rays);
+        }
+        rendererStats.traceMs = cpuTracer.getLastTraceMs();
+        rendererStats.uploadMs = cpuTracer.getLastUploadMs();
+        rendererStats.persistentPbos = cpuTracer.isPersistentlyMapped();
+        rendererStats.pipelineDepth = cpuTracer.getPipelineDepth();
+        rendererStats.progressive = renderSettings.progressive;
+        rendererStats.samples = rendererStats.gpu ? gpuTracer.getAccumulation().getSampleCount() : cpuStats.sampleCount;
+        rendererStats.maxSamples = renderSettings.maxSamples;
+        rendererStats.dynamicResolution = perfSettings.dynamicResolution;
+        if (perfSettings.dynamicResolution) {
+            rendererStats.renderWidth = renderSize.x;
+            rendererStats.renderHeight = renderSize.y;
+            rendererStats.resolutionScale = resolutionController.getScale();
+            rendererStats.smoothedMs = resolutionController.getSmoothedMs();
+            rendererStats.budgetMs = resolutionController.getTargetFrameMs();
+            rendererStats.lastDecision = resolutionController.getLastDecision();
+            rendererStats.lastDecisionMs = resolutionController.getLastDecisionMs();
+            uiManager.recordResolutionScale(resolutionController.getScale());
+        }
+        uiManager.setRendererStats(rendererStats);
         uiManager.render(deltaTime, currentFps, viewportTexture, 
                         renderSettings.width, renderSettings.height);
         // Final rendering
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "SceneFile.hpp"
+#include "World.hpp"
+
+// Converts scene files between the text and the binary form (see
+// SceneFile.hpp): text input is written as binary and binary as text.
+// --add-objects pads the scene with random background objects, which is
+// handy for producing large scenes to test loading with.
+
+namespace {
+
+void printUsage(const char* exe) {
+    std::cout << "Usage: " << exe << " INPUT OUTPUT [options]\n"
+              << "  Text scenes are written as binary, binary scenes as text.\n"
+              << "  --add-objects N    Append N random background objects (default 0)\n"
+              << "  --seed N           Seed for --add-objects (default 1)\n";
+}
+
+// Uniformly spread over a shell far outside any black hole in the default scenes
+void addBackgroundObjects(World& world, size_t count, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> gaussian;
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<glm::vec3> positions(count);
+    for (auto& position : positions) {
+        glm::vec3 dir(gaussian(rng), gaussian(rng), gaussian(rng));
+        float radius = 500.0f + 3500.0f * std::cbrt(uniform(rng));
+        position = glm::normalize(dir) * radius;
+    }
+    world.addObjects(positions.size(), positions.data());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string input;
+    std::string output;
+    size_t addObjects = 0;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--add-objects" || arg == "--seed") {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return 1;
+            }
+            const char* value = argv[++i];
+            if (arg == "--add-objects") addObjects = std::strtoull(value, nullptr, 10);
+            else seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+        } else if (input.empty()) {
+            input = arg;
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            std::cerr << "Unexpected argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (input.empty() || output.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    World world;
+    bool binaryInput = SceneFile::isBinary(input);
+    auto loadBegin = std::chrono::steady_clock::now();
+    if (!SceneFile::load(input, world)) {
+        return 1;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadBegin).count();
+    addBackgroundObjects(world, addObjects, seed);
+
+    bool saved = binaryInput ? SceneFile::saveText(output, world) : SceneFile::saveBinary(output, world);
+    if (!saved) {
+        return 1;
+    }
+    std::cout << input << " (" << (binaryInput ? "binary" : "text") << ", loaded in " << loadMs << " ms) -> "
+              << output << " (" << (binaryInput ? "text" : "binary") << "): " << world.getBlackHoles().size()
+              << " black holes, " << world.getObjects().size() << " objects" << std::endl;
+    return 0;
+}
@@ -0,0 +1,544 @@
+// Everything a primary ray needs from the camera to its RayResult, shared by
+// the fragment (raytracer.frag) and compute (raytracer.comp) backends of
+// GpuRayTracer, which paste it in where they #include it.
+
+uniform vec3 cameraPos;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float time;
+uniform vec2 uResolution;
+uniform vec2 uJitter; // Sub-pixel sample offset in pixels, for progressive refinement
+
+// --- Starfield & Nebula ---
+uniform float uStarDensity;     // Hash threshold a grid cell has to reach to hold a star
+uniform float uNebulaIntensity;
+
+// Pseudo-random number generator
+float hash(vec3 p) {
+    p = fract(p * 0.3183099 + .1);
+    p *= 17.0;
+    return fract(p.x * p.y * p.z * (p.x + p.y + p.z));
+}
+
+float noise(vec3 x) {
+    vec3 i = floor(x);
+    vec3 f = fract(x);
+    f = f*f*(3.0-2.0*f);
+	
+    return mix(mix(mix( hash(i+vec3(0,0,0)), 
+                        hash(i+vec3(1,0,0)),f.x),
+                   mix( hash(i+vec3(0,1,0)), 
+                        hash(i+vec3(1,1,0)),f.x),f.y),
+               mix(mix( hash(i+vec3(0,0,1)), 
+                        hash(i+vec3(1,0,1)),f.x),
+                   mix( hash(i+vec3(0,1,1)), 
+                        hash(i+vec3(1,1,1)),f.x),f.y),f.z);
+}
+
+vec3 GetNebula(vec3 dir) {
+    // Multi-layered noise for nebula clouds
+    float n = noise(dir * 3.0);
+    n += 0.5 * noise(dir * 6.0);
+    n += 0.25 * noise(dir * 12.0);
+    n /= 1.75;
+    
+    // Color mapping: Dark Blue/Purple -> Bright Blue
+    vec3 color = mix(vec3(0.05, 0.0, 0.1), vec3(0.1, 0.4, 0.8), pow(n, 3.0));
+    return color * uNebulaIntensity;
+}
+
+vec3 GetStarfield(vec3 dir) {
+    // Map direction to a grid
+    vec3 p = dir * 150.0; 
+    vec3 id = floor(p);
+    
+    // Hash the grid cell ID to get a random value
+    float rnd = hash(id);
+    
+    // Threshold to decide if a star exists in this cell
+    float star = step(uStarDensity, rnd);
+    
+    return vec3(star) + GetNebula(dir); // Combine Stars + Nebula
+}
+
+// --- Sky ---
+// GetStarfield baked into a mip-mapped cubemap by SkyMap, sampled at the mip
+// level of the pixel footprint at the centre of the view
+uniform bool uUseSkyMap;
+uniform samplerCube uSkyMap;
+uniform float uSkyLod;
+
+// What escaped rays see
+vec3 GetSky(vec3 dir) {
+    if(uUseSkyMap) {
+        return textureLod(uSkyMap, dir, uSkyLod).rgb;
+    }
+    return GetStarfield(dir);
+}
+
+// --- General Relativity ---
+// What a ray brings back: the disk glow picked up on the way plus the sky in
+// skyDir, weighted by skyWeight (0 for rays that fell into a hole).
+// inverseDepth says how the result moves with the camera, see RayInverseDepth.
+struct RayResult {
+    vec3 emission;
+    vec3 skyDir;
+    float skyWeight;
+    float inverseDepth;
+};
+
+RayResult Escaped(vec3 accumColor, vec3 dir) {
+    return RayResult(accumColor, dir, 1.0, 0.0);
+}
+
+RayResult Captured(vec3 accumColor) {
+    return RayResult(accumColor, vec3(0.0), 0.0, 0.0);
+}
+
+vec3 Shade(RayResult r) {
+    if(r.skyWeight > 0.0) {
+        return r.emission + r.skyWeight * GetSky(r.skyDir);
+    }
+    return r.emission;
+}
+
+struct BlackHoleData {
+    vec3 pos;
+    float rs;
+    float diskInner;
+    float diskOuter;
+};
+
+// MAX_BLACK_HOLES is defined by GpuRayTracer from the driver's uniform block size limit
+#ifndef MAX_BLACK_HOLES
+#define MAX_BLACK_HOLES 256
+#endif
+
+// Scene data, uploaded by GpuRayTracer only when the World changes
+layout(std140) uniform BlackHoleBlock {
+    int uNumBlackHoles;
+    BlackHoleData uBlackHoles[MAX_BLACK_HOLES];
+};
+
+// --- Ray Parameters ---
+// Uniforms by default. GpuRayTracer also builds specialized variants that
+// define these as constants so the loop bound and step math are compile-time.
+#ifndef MAX_STEPS
+uniform int uMaxSteps;
+#define MAX_STEPS uMaxSteps
+#endif
+#ifndef MAX_DIST
+uniform float uMaxDistance;
+#define MAX_DIST uMaxDistance
+#endif
+#ifndef STEP_FACTOR
+uniform float uStepFactor;
+#define STEP_FACTOR uStepFactor
+#endif
+#ifndef BENDING_STRENGTH
+uniform float uBendingStrength;
+#define BENDING_STRENGTH uBendingStrength
+#endif
+#ifndef INTEGRATOR
+uniform int uIntegrator; // Geodesic::Integrator: 0 = Newtonian, 1 = Schwarzschild RK45
+#define INTEGRATOR uIntegrator
+#endif
+#ifndef TOLERANCE
+uniform float uTolerance;
+#define TOLERANCE uTolerance
+#endif
+#ifndef BOUNDING_SPHERES
+uniform bool uBoundingSpheres;
+#define BOUNDING_SPHERES uBoundingSpheres
+#endif
+
+// Disk density 2 * (1 - |y| / 0.1) integrated over the height above the midplane from 0 to y
+float DiskDensityIntegral(float y) {
+    float u = clamp(y, -0.1, 0.1);
+    return 2.0 * u - u * abs(u) / 0.1;
+}
+
+// Adds the glow of every accretion disk along the straight segment a -> b,
+// integrated exactly across the slab so long steps neither skip nor alias it
+void AccumulateDisks(vec3 a, vec3 b, inout vec3 accumColor) {
+    vec3 ab = b - a;
+    float segment = length(ab);
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 bhPos = uBlackHoles[j].pos;
+        float ya = a.y - bhPos.y;
+        float yb = b.y - bhPos.y;
+        if(min(ya, yb) >= 0.1 || max(ya, yb) <= -0.1) continue;
+        
+        // Colour and radii are taken where the segment comes closest to the midplane
+        float dy = yb - ya;
+        float density, t;
+        if(abs(dy) > 1e-4) {
+            density = (DiskDensityIntegral(yb) - DiskDensityIntegral(ya)) / dy;
+            t = clamp(-ya / dy, 0.0, 1.0);
+        } else {
+            density = 2.0 * (1.0 - abs(0.5 * (ya + yb)) / 0.1);
+            t = 0.5;
+        }
+        float r = length(bhPos - (a + ab * t));
+        
+        float dInner = uBlackHoles[j].diskInner;
+        float dOuter = uBlackHoles[j].diskOuter;
+        
+        if(r > dInner && r < dOuter) {
+            float temp = (r - dInner) / (dOuter - dInner);
+            vec3 diskColor = mix(vec3(1.0, 0.8, 0.5), vec3(0.8, 0.2, 0.1), temp);
+            accumColor += diskColor * density * segment;
+        }
+    }
+}
+
+// --- Marching ---
+// A ray part way along its geodesic. The integrators advance it one step at
+// a time, so raytracer.frag can march a ray to the end in one loop while
+// raytracer.comp marches it a batch of steps at a time, parking it between.
+struct MarchState {
+    vec3 ro;         // Where marching started
+    vec3 rd;
+    vec3 p;
+    vec3 v;          // Direction (Newtonian) or velocity (Schwarzschild)
+    vec3 a;          // Acceleration at p (Schwarzschild)
+    vec3 accumColor; // Volumetric color accumulation
+    float h;         // Step size carried to the next RK45 step, 0 before the first
+    float maxDist;   // From ro
+};
+
+// One Euler step of Newtonian-style bending. Returns true, with the result, once the ray is done.
+bool NewtonianStep(inout MarchState s, out RayResult result) {
+    // Find closest black hole for step size and gravity
+    float minR = 1e10; // Farther than anything in the scene
+    vec3 totalForce = vec3(0.0);
+    
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 toBH = uBlackHoles[j].pos - s.p;
+        float r = length(toBH);
+        
+        // Keep track of closest distance for adaptive stepping
+        minR = min(minR, r);
+        
+        // Gravity Bending (Sum of forces)
+        // Newtonian approximation: F ~ Rs / r^2
+        float force = BENDING_STRENGTH * uBlackHoles[j].rs / (r * r);
+        totalForce += normalize(toBH) * force;
+    }
+    
+    // Adaptive Step Size
+    float h = max(0.05, minR * STEP_FACTOR);
+    
+    // Check Event Horizons
+    for(int j=0; j<uNumBlackHoles; j++) {
+        if(length(uBlackHoles[j].pos - s.p) < uBlackHoles[j].rs) {
+            result = Captured(s.accumColor); // Black
+            return true;
+        }
+    }
+    
+    // Escape Check
+    if(minR > 5000.0) {
+        result = Escaped(s.accumColor, s.v);
+        return true;
+    }
+    
+    // Apply Gravity
+    s.v = normalize(s.v + totalForce * h);
+    
+    // Move Position, collecting the accretion disk glow along the way
+    vec3 start = s.p;
+    s.p += s.v * h;
+    AccumulateDisks(start, s.p, s.accumColor);
+    
+    // Max Distance Check
+    if(length(s.p - s.ro) > s.maxDist) {
+        result = Escaped(s.accumColor, s.v);
+        return true;
+    }
+    return false;
+}
+
+// Dormand-Prince 5(4) tableau, see src/DormandPrince.hpp
+const float A21 = 1.0/5.0;
+const float A31 = 3.0/40.0, A32 = 9.0/40.0;
+const float A41 = 44.0/45.0, A42 = -56.0/15.0, A43 = 32.0/9.0;
+const float A51 = 19372.0/6561.0, A52 = -25360.0/2187.0, A53 = 64448.0/6561.0, A54 = -212.0/729.0;
+const float A61 = 9017.0/3168.0, A62 = -355.0/33.0, A63 = 46732.0/5247.0, A64 = 49.0/176.0, A65 = -5103.0/18656.0;
+const float B1 = 35.0/384.0, B3 = 500.0/1113.0, B4 = 125.0/192.0, B5 = -2187.0/6784.0, B6 = 11.0/84.0;
+const float E1 = 71.0/57600.0, E3 = -71.0/16695.0, E4 = 71.0/1920.0, E5 = -17253.0/339200.0, E6 = 22.0/525.0,
+            E7 = -1.0/40.0;
+
+// Schwarzschild photon orbit in Cartesian form, x'' = -BENDING_STRENGTH * rs * h^2 * x / r^5,
+// summed over the holes with each hole's h = |cross(x, x')| taken from the ray's start
+vec3 SchwarzschildAccel(vec3 p, vec3 ro, vec3 rd) {
+    vec3 accel = vec3(0.0);
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 h = cross(ro - uBlackHoles[j].pos, rd);
+        vec3 x = p - uBlackHoles[j].pos;
+        float r2 = dot(x, x);
+        accel -= x * (BENDING_STRENGTH * uBlackHoles[j].rs * dot(h, h) / (r2 * r2 * sqrt(r2)));
+    }
+    return accel;
+}
+
+// One attempted step along the Schwarzschild null geodesic, embedded RK45
+// with error-controlled steps. Every attempt, accepted or not, counts against
+// MAX_STEPS. Returns true, with the result, once the ray is done.
+bool SchwarzschildStep(inout MarchState s, out RayResult result) {
+    // Closest hole, horizons and how far the nearest disk is
+    float minR = 1e10;
+    float minDisk = 1e10;
+    for(int j=0; j<uNumBlackHoles; j++) {
+        float r = length(uBlackHoles[j].pos - s.p);
+        minR = min(minR, r);
+        if(r < uBlackHoles[j].rs) {
+            result = Captured(s.accumColor); // Black
+            return true;
+        }
+        float slab = abs(s.p.y - uBlackHoles[j].pos.y) - 0.1;
+        minDisk = min(minDisk, max(slab, max(uBlackHoles[j].diskInner - r, r - uBlackHoles[j].diskOuter)));
+    }
+    
+    // Escape Check
+    if(minR > 5000.0) {
+        result = Escaped(s.accumColor, normalize(s.v));
+        return true;
+    }
+    
+    // The disk glow is integrated along each step, so steps only stay short (0.5)
+    // where they could cut through a disk; further out they may reach its slab
+    float firstStep = max(0.05, minR * STEP_FACTOR);
+    float maxStep = min(max(0.05, minR * 0.5), max(0.5, minDisk));
+    float h = min(s.h > 0.0 ? s.h : firstStep, maxStep);
+    
+    // Dormand-Prince stages for y = (p, v), y' = (v, a(p))
+    vec3 p = s.p, v = s.v;
+    vec3 v1 = v, a1 = s.a;
+    vec3 v2 = v + h * (A21 * a1);
+    vec3 a2 = SchwarzschildAccel(p + h * (A21 * v1), s.ro, s.rd);
+    vec3 v3 = v + h * (A31 * a1 + A32 * a2);
+    vec3 a3 = SchwarzschildAccel(p + h * (A31 * v1 + A32 * v2), s.ro, s.rd);
+    vec3 v4 = v + h * (A41 * a1 + A42 * a2 + A43 * a3);
+    vec3 a4 = SchwarzschildAccel(p + h * (A41 * v1 + A42 * v2 + A43 * v3), s.ro, s.rd);
+    vec3 v5 = v + h * (A51 * a1 + A52 * a2 + A53 * a3 + A54 * a4);
+    vec3 a5 = SchwarzschildAccel(p + h * (A51 * v1 + A52 * v2 + A53 * v3 + A54 * v4), s.ro, s.rd);
+    vec3 v6 = v + h * (A61 * a1 + A62 * a2 + A63 * a3 + A64 * a4 + A65 * a5);
+    vec3 a6 = SchwarzschildAccel(p + h * (A61 * v1 + A62 * v2 + A63 * v3 + A64 * v4 + A65 * v5), s.ro, s.rd);
+    
+    vec3 pNext = p + h * (B1 * v1 + B3 * v3 + B4 * v4 + B5 * v5 + B6 * v6);
+    vec3 vNext = v + h * (B1 * a1 + B3 * a3 + B4 * a4 + B5 * a5 + B6 * a6);
+    vec3 aNext = SchwarzschildAccel(pNext, s.ro, s.rd);
+    
+    // Local error, position relative to the distance to the nearest hole
+    vec3 errP = h * (E1 * v1 + E3 * v3 + E4 * v4 + E5 * v5 + E6 * v6 + E7 * vNext);
+    vec3 errV = h * (E1 * a1 + E3 * a3 + E4 * a4 + E5 * a5 + E6 * a6 + E7 * aNext);
+    float err = max(length(errP) / (TOLERANCE * minR), length(errV) / TOLERANCE);
+    
+    // Accept when within tolerance or already at the smallest step
+    if(err < 1.0 || h <= 0.05) {
+        AccumulateDisks(p, pNext, s.accumColor);
+        s.p = pNext;
+        s.v = vNext;
+        s.a = aNext;
+        
+        // Max Distance Check
+        if(length(s.p - s.ro) > s.maxDist) {
+            result = Escaped(s.accumColor, normalize(s.v));
+            return true;
+        }
+    }
+    
+    float scale = err > 0.0 ? 0.9 / sqrt(sqrt(err)) : 5.0;
+    s.h = max(0.05, h * clamp(scale, 0.2, 5.0));
+    return false;
+}
+
+// Ready to march from ro along rd for at most maxDist
+MarchState StartMarch(vec3 ro, vec3 rd, float maxDist) {
+    vec3 a = INTEGRATOR == 1 ? SchwarzschildAccel(ro, ro, rd) : vec3(0.0);
+    return MarchState(ro, rd, ro, rd, a, vec3(0.0), 0.0, maxDist);
+}
+
+// What a ray still going after MAX_STEPS is taken to see
+RayResult MarchTimedOut(MarchState s) {
+    return Escaped(s.accumColor, INTEGRATOR == 1 ? normalize(s.v) : s.v);
+}
+
+// --- Bounding Spheres ---
+// Only the space within a hole's influence sphere is marched, see
+// Geodesic::skipToInfluence. Outside, its pull is applied analytically.
+float InfluenceRadius(int j) {
+    return max(20.0 * uBlackHoles[j].rs, 2.0 * uBlackHoles[j].diskOuter);
+}
+
+// Moves p along dir to the first influence sphere it enters, bending dir by
+// the weak-field deflection on the way. Returns the distance skipped, 0 when
+// starting inside a sphere and -1 (with the final dir) when missing them all.
+float SkipToInfluence(inout vec3 p, inout vec3 dir) {
+    vec3 ro = p;
+    vec3 rd = dir;
+    
+    float entry = 1e10;
+    bool enters = false;
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 toBH = uBlackHoles[j].pos - ro;
+        float radius = InfluenceRadius(j);
+        if(dot(toBH, toBH) <= radius * radius) {
+            return 0.0;
+        }
+        float along = dot(toBH, rd);
+        vec3 perpendicular = toBH - along * rd;
+        float perp2 = dot(perpendicular, perpendicular);
+        if(along > 0.0 && perp2 < radius * radius) {
+            entry = min(entry, along - sqrt(radius * radius - perp2));
+            enters = true;
+        }
+    }
+    
+    // Perpendicular pull integrated along the line, s measured from the closest approach
+    vec3 bend = vec3(0.0);
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 toBH = uBlackHoles[j].pos - ro;
+        float along = dot(toBH, rd);
+        vec3 perpendicular = toBH - along * rd;
+        float b = length(perpendicular);
+        if(b <= 0.0) continue;
+        
+        float s0 = -along;
+        float r0 = sqrt(s0 * s0 + b * b);
+        float s1 = entry - along;
+        float r1 = sqrt(s1 * s1 + b * b);
+        float g0, g1;
+        if(INTEGRATOR == 1) {
+            g0 = s0 * (2.0 * s0 * s0 + 3.0 * b * b) / (3.0 * r0 * r0 * r0);
+            g1 = enters ? s1 * (2.0 * s1 * s1 + 3.0 * b * b) / (3.0 * r1 * r1 * r1) : 2.0 / 3.0;
+        } else {
+            g0 = s0 / r0;
+            g1 = enters ? s1 / r1 : 1.0;
+        }
+        bend += perpendicular / b * (BENDING_STRENGTH * uBlackHoles[j].rs / b * (g1 - g0));
+    }
+    if(uNumBlackHoles > 0) {
+        dir = normalize(rd + bend);
+    }
+    
+    if(!enters) {
+        return -1.0;
+    }
+    p = ro + rd * entry;
+    return entry;
+}
+
+// Sets up the march of a ray through curved spacetime. Returns true, with
+// the result, if it needs none: it misses every influence sphere or only
+// reaches one beyond MAX_DIST.
+bool BeginGeodesic(vec3 ro, vec3 rd, out MarchState s, out RayResult result) {
+    vec3 p = ro;
+    vec3 dir = rd;
+    float skipped = BOUNDING_SPHERES ? SkipToInfluence(p, dir) : 0.0;
+    if(skipped < 0.0 || skipped >= MAX_DIST) {
+        result = Escaped(vec3(0.0), dir);
+        return true;
+    }
+    
+    // The distance limit still counts from the camera
+    s = StartMarch(p, dir, MAX_DIST - skipped);
+    return false;
+}
+
+// Traces a ray through curved spacetime
+RayResult TraceGeodesic(vec3 ro, vec3 rd) {
+    MarchState s;
+    RayResult result;
+    if(BeginGeodesic(ro, rd, s, result)) {
+        return result;
+    }
+    // One loop per integrator, so neither carries the other's registers
+    if(INTEGRATOR == 1) {
+        for(int i=0; i<MAX_STEPS; i++) {
+            if(SchwarzschildStep(s, result)) {
+                return result;
+            }
+        }
+    } else {
+        for(int i=0; i<MAX_STEPS; i++) {
+            if(NewtonianStep(s, result)) {
+                return result;
+            }
+        }
+    }
+    return MarchTimedOut(s);
+}
+
+// --- Deflection Table ---
+// Single black-hole scenes can be shaded from precomputed geodesics, see
+// DeflectionTable. RG = (deflection, transmittance); columns are impact
+// parameters, rows observer radii with inbound rays in the lower half.
+uniform bool uUseDeflectionTable;
+uniform sampler2D uDeflectionTable;
+uniform vec2 uDeflectionLogRange; // log(1 + ESCAPE_RADIUS / rs), log(ESCAPE_RADIUS / rs)
+
+// Mirrors DeflectionTable::shade. Returns false if the ray can reach the disk and has to be marched.
+bool ShadeFromTable(vec3 ro, vec3 rd, out RayResult result) {
+    result = Captured(vec3(0.0));
+    BlackHoleData bh = uBlackHoles[0];
+    vec3 toHole = bh.pos - ro;
+    float radius = length(toHole);
+    float along = dot(toHole, rd);
+    vec3 perpendicular = toHole - along * rd;
+    float impact = length(perpendicular);
+    bool outbound = along < 0.0;
+    
+    float diskReach = bh.diskOuter + bh.rs;
+    if(bh.diskOuter > 0.0 && impact < diskReach && (!outbound || radius < diskReach)) {
+        return false;
+    }
+    
+    ivec2 size = textureSize(uDeflectionTable, 0);
+    float radiusRows = float(size.y / 2);
+    float x = clamp(log(1.0 + impact / bh.rs) / uDeflectionLogRange.x, 0.0, 1.0) * float(size.x - 1);
+    float y = clamp(log(max(radius, bh.rs) / bh.rs) / uDeflectionLogRange.y, 0.0, 1.0) * (radiusRows - 1.0);
+    if(outbound) y += radiusRows;
+    vec2 entry = texture(uDeflectionTable, (vec2(x, y) + 0.5) / vec2(size)).rg;
+    
+    vec3 towards = impact > 0.0 ? perpendicular / impact : rd;
+    vec3 dir = rd * cos(entry.x) + towards * sin(entry.x);
+    result = RayResult(vec3(0.0), dir, entry.y, 0.0);
+    return true;
+}
+
+// Primary ray through uv (0-1 across the image)
+vec3 RayDirection(vec2 uv) {
+    vec2 ndc = uv * 2.0 - 1.0;
+    vec4 clipCoords = vec4(ndc.x, ndc.y, -1.0, 1.0);
+    vec4 eyeCoords = inverse(projection) * clipCoords;
+    eyeCoords = vec4(eyeCoords.xy, -1.0, 0.0);
+    return normalize(vec3(inverse(view) * eyeCoords));
+}
+
+// What a ray sees moves with the camera like a point at the nearest black
+// hole whose influence sphere the ray passes through, or like the sky (0)
+// if it misses them all
+float RayInverseDepth(vec3 ro, vec3 rd) {
+    float inverseDepth = 0.0;
+    for(int j=0; j<uNumBlackHoles; j++) {
+        vec3 toBH = uBlackHoles[j].pos - ro;
+        float radius = InfluenceRadius(j);
+        float dist2 = dot(toBH, toBH);
+        float along = dot(toBH, rd);
+        if(dist2 - along * along < radius * radius && (along > 0.0 || dist2 < radius * radius)) {
+            inverseDepth = max(inverseDepth, inversesqrt(dist2));
+        }
+    }
+    return inverseDepth;
+}
+
+RayResult TraceRay(vec3 ro, vec3 rd) {
+    RayResult result;
+    if(!(uUseDeflectionTable && uNumBlackHoles == 1 && ShadeFromTable(ro, rd, result))) {
+        result = TraceGeodesic(ro, rd);
+    }
+    result.inverseDepth = RayInverseDepth(ro, rd);
+    return result;
+}
@@ -0,0 +1,106 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// The HDR image GpuRayTracer marched, or the bloom level a pass reads from
+uniform sampler2D uSource;
+uniform sampler2D uBloomTexture;
+
+// --- Bloom ---
+// A chain of half-size levels: pass 0 filters the HDR image down into level
+// 0 keeping only what is brighter than uBloomThreshold, pass 1 halves each
+// level into the next, and pass 2 walks back up, adding each level's tent-
+// filtered upsample onto the one above it. Level 0 then holds the glow of
+// every level at once, the widest coming from the smallest.
+uniform int uPass; // 0 = threshold, 1 = downsample, 2 = upsample, 3 = composite
+uniform float uBloomThreshold;
+uniform float uBloomKnee;  // Width of the soft transition below the threshold
+uniform float uBloomStrength;
+
+float Luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Average of the 4x4 source texels under a destination texel, as four
+// bilinear taps. The threshold pass weights them by 1 / (1 + luminance) so a
+// single star or disk texel far brighter than its neighbours cannot flicker
+// through the whole chain as the jitter moves it.
+vec3 Downsample(bool fireflyWeights) {
+    vec2 texel = 1.0 / vec2(textureSize(uSource, 0));
+    vec3 taps[4];
+    taps[0] = texture(uSource, TexCoords + vec2(-1.0, -1.0) * texel).rgb;
+    taps[1] = texture(uSource, TexCoords + vec2( 1.0, -1.0) * texel).rgb;
+    taps[2] = texture(uSource, TexCoords + vec2(-1.0,  1.0) * texel).rgb;
+    taps[3] = texture(uSource, TexCoords + vec2( 1.0,  1.0) * texel).rgb;
+    vec3 sum = vec3(0.0);
+    float weightSum = 0.0;
+    for(int i=0; i<4; i++) {
+        float weight = fireflyWeights ? 1.0 / (1.0 + Luminance(taps[i])) : 1.0;
+        sum += taps[i] * weight;
+        weightSum += weight;
+    }
+    return sum / weightSum;
+}
+
+// Quadratic soft threshold: nothing below threshold - knee, everything above
+// threshold + knee, the excess over the threshold in between
+vec3 Threshold(vec3 color) {
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - uBloomThreshold + uBloomKnee, 0.0, 2.0 * uBloomKnee);
+    soft = soft * soft / (4.0 * uBloomKnee + 1e-5);
+    float contribution = max(soft, brightness - uBloomThreshold) / max(brightness, 1e-5);
+    return color * contribution;
+}
+
+// 3x3 tent filter over the smaller level, so the upsample has no blocky edges
+vec3 Upsample(sampler2D level) {
+    vec2 texel = 1.0 / vec2(textureSize(level, 0));
+    vec3 sum = texture(level, TexCoords).rgb * 4.0;
+    sum += texture(level, TexCoords + vec2(-texel.x, 0.0)).rgb * 2.0;
+    sum += texture(level, TexCoords + vec2( texel.x, 0.0)).rgb * 2.0;
+    sum += texture(level, TexCoords + vec2(0.0, -texel.y)).rgb * 2.0;
+    sum += texture(level, TexCoords + vec2(0.0,  texel.y)).rgb * 2.0;
+    sum += texture(level, TexCoords + vec2(-texel.x, -texel.y)).rgb;
+    sum += texture(level, TexCoords + vec2( texel.x, -texel.y)).rgb;
+    sum += texture(level, TexCoords + vec2(-texel.x,  texel.y)).rgb;
+    sum += texture(level, TexCoords + vec2( texel.x,  texel.y)).rgb;
+    return sum / 16.0;
+}
+
+// --- Tonemapping ---
+uniform float uExposure; // Linear scale, 2^EV
+uniform int uTonemap;    // PostProcess::Tonemap: 0 = clamp, 1 = Reinhard, 2 = ACES
+uniform bool uBloom;
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 Aces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 Tonemap(vec3 color) {
+    if(uTonemap == 1) {
+        return color / (1.0 + color);
+    }
+    if(uTonemap == 2) {
+        return Aces(color);
+    }
+    return clamp(color, 0.0, 1.0);
+}
+
+void main()
+{
+    if(uPass == 0) {
+        FragColor = vec4(Threshold(Downsample(true)), 1.0);
+    } else if(uPass == 1) {
+        FragColor = vec4(Downsample(false), 1.0);
+    } else if(uPass == 2) {
+        FragColor = vec4(Upsample(uSource), 1.0); // Added onto the level by blending
+    } else {
+        vec3 color = texture(uSource, TexCoords).rgb;
+        if(uBloom) {
+            color += Upsample(uBloomTexture) * uBloomStrength;
+        }
+        FragColor = vec4(Tonemap(color * uExposure), 1.0);
+    }
+}
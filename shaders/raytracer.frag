@@ -1,164 +1,170 @@
 #version 330 core
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
+// The RayResult behind FragColor, for the reduced-resolution trace and the
+// temporal history; only bound when one of them is being written
+layout(location = 1) out vec4 EmissionOut; // emission, age in frames
+layout(location = 2) out vec4 SkyOut;      // skyDir * skyWeight, inverseDepth
 
 in vec2 TexCoords;
 
-uniform vec3 cameraPos;
-uniform mat4 view;
-uniform mat4 projection;
-uniform float time;
+#include "geodesic.glsl"
 
-// --- Starfield & Nebula ---
-// Pseudo-random number generator
-float hash(vec3 p) {
-    p = fract(p * 0.3183099 + .1);
-    p *= 17.0;
-    return fract(p.x * p.y * p.z * (p.x + p.y + p.z));
+vec4 PackSky(RayResult result) {
+    return vec4(result.skyDir * result.skyWeight, result.inverseDepth);
 }
 
-float noise(vec3 x) {
-    vec3 i = floor(x);
-    vec3 f = fract(x);
-    f = f*f*(3.0-2.0*f);
-	
-    return mix(mix(mix( hash(i+vec3(0,0,0)), 
-                        hash(i+vec3(1,0,0)),f.x),
-                   mix( hash(i+vec3(0,1,0)), 
-                        hash(i+vec3(1,1,0)),f.x),f.y),
-               mix(mix( hash(i+vec3(0,0,1)), 
-                        hash(i+vec3(1,0,1)),f.x),
-                   mix( hash(i+vec3(0,1,1)), 
-                        hash(i+vec3(1,1,1)),f.x),f.y),f.z);
-}
-
-vec3 GetNebula(vec3 dir) {
-    // Multi-layered noise for nebula clouds
-    float n = noise(dir * 3.0);
-    n += 0.5 * noise(dir * 6.0);
-    n += 0.25 * noise(dir * 12.0);
-    n /= 1.75;
-    
-    // Color mapping: Dark Blue/Purple -> Bright Blue
-    vec3 color = mix(vec3(0.05, 0.0, 0.1), vec3(0.1, 0.4, 0.8), pow(n, 3.0));
-    return color;
-}
+const float INTERPOLATE_WEIGHT_EPSILON = 0.01;
+const float INTERPOLATE_EMISSION_RELATIVE = 0.1;
+const float INTERPOLATE_EMISSION_ABSOLUTE = 0.02;
 
-vec3 GetStarfield(vec3 dir) {
-    // Map direction to a grid
-    vec3 p = dir * 150.0; 
-    vec3 id = floor(p);
+// Bilinear interpolation of the RayResults stored in EmissionOut/SkyOut
+// layout around pos (in texels). Returns false if they disagree too much to
+// be interpolated: some rays captured and some not, emission differing (disk
+// edges) or sky directions further apart than acos(minCos). age is the
+// oldest of the four.
+bool Interpolate(sampler2D emissionTexture, sampler2D skyTexture, vec2 pos, float minCos,
+                 out RayResult result, out float age) {
+    result = Captured(vec3(0.0));
+    age = 0.0;
+    ivec2 size = textureSize(skyTexture, 0);
+    vec2 f = fract(pos);
+    ivec2 base = ivec2(floor(pos));
     
-    // Hash the grid cell ID to get a random value
-    float rnd = hash(id);
+    vec4 emission[4];
+    vec4 sky[4];
+    float weight[4];
+    for(int i=0; i<4; i++) {
+        ivec2 texel = clamp(base + ivec2(i & 1, i >> 1), ivec2(0), size - 1);
+        emission[i] = texelFetch(emissionTexture, texel, 0);
+        sky[i] = texelFetch(skyTexture, texel, 0);
+        weight[i] = length(sky[i].xyz);
+    }
     
-    // Threshold to decide if a star exists in this cell
-    float star = step(0.995, rnd); 
+    vec3 minEmission = min(min(emission[0].rgb, emission[1].rgb), min(emission[2].rgb, emission[3].rgb));
+    vec3 maxEmission = max(max(emission[0].rgb, emission[1].rgb), max(emission[2].rgb, emission[3].rgb));
+    if(any(greaterThan(maxEmission - minEmission, maxEmission * INTERPOLATE_EMISSION_RELATIVE + INTERPOLATE_EMISSION_ABSOLUTE))) {
+        return false;
+    }
+    float minWeight = min(min(weight[0], weight[1]), min(weight[2], weight[3]));
+    float maxWeight = max(max(weight[0], weight[1]), max(weight[2], weight[3]));
+    if(maxWeight - minWeight > INTERPOLATE_WEIGHT_EPSILON) {
+        return false;
+    }
+    if(minWeight > 0.0) {
+        for(int i=1; i<4; i++) {
+            if(dot(sky[0].xyz, sky[i].xyz) < minCos * weight[0] * weight[i]) {
+                return false;
+            }
+        }
+    }
     
-    return vec3(star) + GetNebula(dir); // Combine Stars + Nebula
+    vec4 e = mix(mix(emission[0], emission[1], f.x), mix(emission[2], emission[3], f.x), f.y);
+    vec4 s = mix(mix(sky[0], sky[1], f.x), mix(sky[2], sky[3], f.x), f.y);
+    result.emission = e.rgb;
+    if(minWeight > 0.0) {
+        result.skyDir = normalize(s.xyz);
+        result.skyWeight = mix(mix(weight[0], weight[1], f.x), mix(weight[2], weight[3], f.x), f.y);
+    }
+    result.inverseDepth = s.w;
+    age = max(max(emission[0].a, emission[1].a), max(emission[2].a, emission[3].a));
+    return true;
 }
 
-// --- General Relativity ---
-struct BlackHoleData {
-    vec3 pos;
-    float rs;
-    float diskInner;
-    float diskOuter;
-};
+// --- Reduced Resolution ---
+// The lensed sky varies smoothly almost everywhere, so GpuRayTracer can march
+// at 1/2 or 1/4 resolution (pass 1, keeping each RayResult) and fill in the
+// full-resolution image from it (pass 2): the four nearest results are
+// interpolated and the sky is sampled per pixel in the interpolated direction,
+// keeping stars sharp. Where the four disagree (horizon, disk and photon-ring
+// edges) the pixel is traced again at full resolution.
+uniform int uPass; // 0 = trace every pixel, 1 = reduced-resolution trace, 2 = upsample
+uniform sampler2D uLowResEmission;
+uniform sampler2D uLowResSky;
+uniform float uUpsampleMinCos; // Neighbouring sky directions further apart than this are an edge
 
-uniform BlackHoleData uBlackHoles[4];
-uniform int uNumBlackHoles;
+bool Upsample(out RayResult result) {
+    float age;
+    return Interpolate(uLowResEmission, uLowResSky, TexCoords * vec2(textureSize(uLowResSky, 0)) - 0.5,
+                       uUpsampleMinCos, result, age);
+}
 
-#define MAX_STEPS 200
-#define MAX_DIST 1e10
+// --- Temporal Reuse ---
+// The previous frame's RayResults (uHistory*) are reprojected under the new
+// camera pose with each result's inverse depth. A pixel reuses them if they
+// interpolate cleanly, the depth they were reprojected with matches theirs
+// to within uReprojectMaxError of parallax and they are younger than uMaxAge
+// frames; otherwise it is traced. Fresh results start at staggered ages so
+// the expired ones are spread evenly over the frames.
+uniform bool uTemporal;
+uniform sampler2D uHistoryEmission;
+uniform sampler2D uHistorySky;
+uniform mat4 uPrevViewProjection;
+uniform vec3 uPrevCameraPos;
+uniform int uMaxAge;
+uniform float uReprojectMinCos;
+uniform float uReprojectMaxError; // Radians
 
-// Traces a ray through curved spacetime
-vec3 TraceGeodesic(vec3 ro, vec3 rd) {
-    vec3 p = ro;
-    vec3 dir = rd;
-    vec3 accumColor = vec3(0.0); // Volumetric color accumulation
-    
-    float h = 0.1; // Adaptive step size
+float FreshAge() {
+    vec2 pixel = floor(gl_FragCoord.xy);
+    return mod(pixel.x + 3.0 * pixel.y, float(uMaxAge));
+}
+
+bool Reproject(vec3 ro, vec3 rd, out RayResult result, out float age) {
+    result = Captured(vec3(0.0));
+    age = 0.0;
+    ivec2 size = textureSize(uHistorySky, 0);
     
-    for(int i=0; i<MAX_STEPS; i++) {
-        // Find closest black hole for step size and gravity
-        float minR = MAX_DIST;
-        vec3 totalForce = vec3(0.0);
-        int closestBH = -1;
-        
-        for(int j=0; j<uNumBlackHoles; j++) {
-            vec3 toBH = uBlackHoles[j].pos - p;
-            float r = length(toBH);
-            
-            // Keep track of closest distance for adaptive stepping
-            if (r < minR) {
-                minR = r;
-                closestBH = j;
-            }
-            
-            // Gravity Bending (Sum of forces)
-            // Newtonian approximation: F ~ Rs / r^2
-            float bendingStrength = 1.5;
-            float force = bendingStrength * uBlackHoles[j].rs / (r * r);
-            totalForce += normalize(toBH) * force;
+    // Start from the sky's reprojection, then refine with the depth found there
+    float inverseDepth = 0.0;
+    vec2 pos;
+    for(int i=0; i<2; i++) {
+        vec4 target = inverseDepth > 0.0 ? vec4(ro + rd / inverseDepth, 1.0) : vec4(rd, 0.0);
+        vec4 clip = uPrevViewProjection * target;
+        if(clip.w <= 0.0) {
+            return false;
         }
-        
-        // Adaptive Step Size
-        h = max(0.05, minR * 0.08);
-        
-        // Check Event Horizons
-        for(int j=0; j<uNumBlackHoles; j++) {
-            if(length(uBlackHoles[j].pos - p) < uBlackHoles[j].rs) {
-                return accumColor; // Black
-            }
-        }
-        
-        // Check Accretion Disks
-        for(int j=0; j<uNumBlackHoles; j++) {
-            vec3 bhPos = uBlackHoles[j].pos;
-            float distToPlane = abs(p.y - bhPos.y);
-            float r = length(bhPos - p);
-            
-            float dInner = uBlackHoles[j].diskInner;
-            float dOuter = uBlackHoles[j].diskOuter;
-            
-            if(distToPlane < 0.1 && r > dInner && r < dOuter) {
-                float density = 2.0 * (1.0 - distToPlane/0.1); 
-                float temp = (r - dInner) / (dOuter - dInner);
-                vec3 diskColor = mix(vec3(1.0, 0.8, 0.5), vec3(0.8, 0.2, 0.1), temp);
-                accumColor += diskColor * density * h; 
-            }
+        vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+        if(any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) {
+            return false;
         }
-        
-        // Escape Check
-        if(minR > 5000.0) {
-             return accumColor + GetStarfield(dir);
+        pos = uv * vec2(size) - 0.5;
+        if(i == 0) {
+            inverseDepth = texelFetch(uHistorySky, clamp(ivec2(floor(uv * vec2(size))), ivec2(0), size - 1), 0).w;
         }
-        
-        // Apply Gravity
-        dir = normalize(dir + totalForce * h);
-        
-        // Move Position
-        p += dir * h;
-        
-        // Max Distance Check
-        if(length(p - ro) > MAX_DIST) break;
     }
     
-    return accumColor + GetStarfield(dir); // Fallback
+    if(!Interpolate(uHistoryEmission, uHistorySky, pos, uReprojectMinCos, result, age)) {
+        return false;
+    }
+    vec3 moved = ro - uPrevCameraPos;
+    float parallax = length(moved - dot(moved, rd) * rd) * abs(result.inverseDepth - inverseDepth);
+    if(parallax > uReprojectMaxError || age + 1.0 >= float(uMaxAge)) {
+        return false;
+    }
+    age += 1.0;
+    return true;
 }
 
 void main()
 {
-    // 1. Calculate Ray Direction
-    vec2 ndc = TexCoords * 2.0 - 1.0;
-    vec4 clipCoords = vec4(ndc.x, ndc.y, -1.0, 1.0);
-    vec4 eyeCoords = inverse(projection) * clipCoords;
-    eyeCoords = vec4(eyeCoords.xy, -1.0, 0.0);
-    vec3 rd = normalize(vec3(inverse(view) * eyeCoords));
     vec3 ro = cameraPos;
-    
-    // 2. Trace Geodesic
-    vec3 col = TraceGeodesic(ro, rd);
-    
-    FragColor = vec4(col, 1.0);
+    vec3 rd = RayDirection(TexCoords + uJitter / uResolution); // Offset by uJitter pixels
+    RayResult result;
+    float age = FreshAge();
+    float reprojectedAge;
+    if(uPass == 1) {
+        result = TraceRay(ro, rd);
+        FragColor = vec4(0.0); // Not bound
+    } else {
+        if(uPass == 2 && Upsample(result)) {
+            // Interpolated from fresh rays
+        } else if(uTemporal && Reproject(ro, rd, result, reprojectedAge)) {
+            age = reprojectedAge;
+        } else {
+            result = TraceRay(ro, rd);
+        }
+        FragColor = vec4(Shade(result), 1.0);
+    }
+    EmissionOut = vec4(result.emission, age);
+    SkyOut = PackSky(result);
 }
@@ -0,0 +1,39 @@
+#include "Accumulation.hpp"
+
+namespace {
+
+float radicalInverse(int index, int base) {
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    while (index > 0) {
+        result += (index % base) * fraction;
+        index /= base;
+        fraction /= base;
+    }
+    return result;
+}
+
+} // namespace
+
+Accumulation::Accumulation(int maxSamples)
+    : maxSamples(maxSamples > 0 ? maxSamples : 1)
+{
+}
+
+bool Accumulation::update(const Camera& camera, const World& world, int width, int height,
+                          const Geodesic::MarchParams& params) {
+    ViewKey current{ camera.position, camera.yaw, camera.pitch, camera.zoom, width, height,
+                     &world, world.getRevision(), params };
+    if (hasKey && current == key) {
+        return false;
+    }
+    key = current;
+    hasKey = true;
+    sampleCount = 0;
+    return true;
+}
+
+glm::vec2 Accumulation::jitter(int sampleIndex) {
+    if (sampleIndex <= 0) return glm::vec2(0.0f);
+    return glm::vec2(radicalInverse(sampleIndex, 2), radicalInverse(sampleIndex, 3)) - 0.5f;
+}
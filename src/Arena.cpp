@@ -0,0 +1,35 @@
+#include "Arena.hpp"
+#include <cstdint>
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    if (!blocks.empty()) {
+        Block& block = blocks.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t aligned = (base + block.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (aligned + bytes <= base + block.size) {
+            block.used = aligned + bytes - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    // Oversized requests get a block of their own; the padding covers any alignment
+    size_t size = bytes + alignment > blockSize ? bytes + alignment : blockSize;
+    blocks.push_back({ std::unique_ptr<std::byte[]>(new std::byte[size]), size, 0 });
+    return allocate(bytes, alignment);
+}
+
+void Arena::reset() {
+    blocks.clear();
+}
+
+size_t Arena::bytesUsed() const {
+    size_t used = 0;
+    for (const auto& block : blocks) used += block.used;
+    return used;
+}
+
+size_t Arena::bytesReserved() const {
+    size_t reserved = 0;
+    for (const auto& block : blocks) reserved += block.size;
+    return reserved;
+}
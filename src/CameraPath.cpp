@@ -0,0 +1,119 @@
+#include "CameraPath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "SceneFile.hpp"
+
+namespace {
+
+constexpr int NUM_CHANNELS = 6;
+
+// Flattened so every channel goes through the same spline code
+void toChannels(const CameraPose& pose, float channels[NUM_CHANNELS]) {
+    channels[0] = pose.position.x;
+    channels[1] = pose.position.y;
+    channels[2] = pose.position.z;
+    channels[3] = pose.yaw;
+    channels[4] = pose.pitch;
+    channels[5] = pose.fov;
+}
+
+CameraPose fromChannels(const float channels[NUM_CHANNELS]) {
+    CameraPose pose;
+    pose.position = glm::vec3(channels[0], channels[1], channels[2]);
+    pose.yaw = channels[3];
+    pose.pitch = channels[4];
+    pose.fov = channels[5];
+    return pose;
+}
+
+} // namespace
+
+Camera CameraPose::toCamera() const {
+    Camera camera(position, glm::vec3(0.0f, 1.0f, 0.0f), yaw, pitch);
+    camera.zoom = fov;
+    return camera;
+}
+
+void CameraPath::addKeyframe(const Keyframe& key) {
+    auto at = std::lower_bound(keys.begin(), keys.end(), key.time,
+                               [](const Keyframe& k, float time) { return k.time < time; });
+    if (at != keys.end() && at->time == key.time) {
+        *at = key;
+    } else {
+        keys.insert(at, key);
+    }
+}
+
+CameraPose CameraPath::evaluate(float time) const {
+    if (keys.empty()) return CameraPose();
+    if (time <= keys.front().time) return keys.front().pose;
+    if (time >= keys.back().time) return keys.back().pose;
+
+    // Segment [k1, k2] holding time, with its outer neighbours k0 and k3 (clamped at the ends)
+    size_t k2 = std::upper_bound(keys.begin(), keys.end(), time,
+                                 [](float t, const Keyframe& k) { return t < k.time; }) - keys.begin();
+    size_t k1 = k2 - 1;
+    size_t k0 = k1 > 0 ? k1 - 1 : k1;
+    size_t k3 = k2 + 1 < keys.size() ? k2 + 1 : k2;
+
+    float t0 = keys[k0].time, t1 = keys[k1].time, t2 = keys[k2].time, t3 = keys[k3].time;
+    float p0[NUM_CHANNELS], p1[NUM_CHANNELS], p2[NUM_CHANNELS], p3[NUM_CHANNELS], out[NUM_CHANNELS];
+    toChannels(keys[k0].pose, p0);
+    toChannels(keys[k1].pose, p1);
+    toChannels(keys[k2].pose, p2);
+    toChannels(keys[k3].pose, p3);
+
+    // Cubic Hermite on the segment with Catmull-Rom tangents (rates per second
+    // over the neighbouring keys, one-sided at the ends), scaled to the segment
+    float span = t2 - t1;
+    float u = (time - t1) / span;
+    float u2 = u * u;
+    float u3 = u2 * u;
+    float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+    float h10 = u3 - 2.0f * u2 + u;
+    float h01 = -2.0f * u3 + 3.0f * u2;
+    float h11 = u3 - u2;
+    for (int c = 0; c < NUM_CHANNELS; ++c) {
+        float m1 = (p2[c] - p0[c]) / (t2 - t0) * span;
+        float m2 = (p3[c] - p1[c]) / (t3 - t1) * span;
+        out[c] = h00 * p1[c] + h10 * m1 + h01 * p2[c] + h11 * m2;
+    }
+    return fromChannels(out);
+}
+
+int CameraPath::frameCount(float fps) const {
+    if (keys.empty() || fps <= 0.0f) return 0;
+    // The small bias keeps a duration that is a whole number of frames from losing its last one to rounding
+    return static_cast<int>(std::floor((getEndTime() - getStartTime()) * fps + 1e-3f)) + 1;
+}
+
+bool CameraPath::load(const std::string& filePath, CameraPath& path) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Could not open camera path " << filePath << std::endl;
+        return false;
+    }
+
+    SceneFile::TextLine line;
+    while (SceneFile::readTextLine(file, line)) {
+        if (line.keyword != "key") {
+            std::cerr << filePath << ":" << line.number << ": unknown entry " << line.keyword << std::endl;
+            return false;
+        }
+        const std::vector<float>& values = line.values;
+        if (!line.numeric || values.size() != 7) {
+            std::cerr << filePath << ":" << line.number << ": expected key TIME X Y Z YAW PITCH FOV" << std::endl;
+            return false;
+        }
+        Keyframe key;
+        key.time = values[0];
+        key.pose.position = glm::vec3(values[1], values[2], values[3]);
+        key.pose.yaw = values[4];
+        key.pose.pitch = values[5];
+        key.pose.fov = values[6];
+        path.addKeyframe(key);
+    }
+    return true;
+}
@@ -1,186 +1,195 @@
 #include "CpuRayTracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <glm/gtc/type_ptr.hpp>
 
-// Simple shader to display the texture
-const char* textureVertexShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoords;
+namespace {
 
-out vec2 TexCoords;
+// Texture internal format and upload type for each DisplayFormat; both are 4 bytes per pixel
+struct DisplayTexelFormat {
+    GLenum internalFormat;
+    GLenum type;
+};
 
-void main()
-{
-    TexCoords = aTexCoords;
-    gl_Position = vec4(aPos, 1.0);
+DisplayTexelFormat texelFormatFor(CpuRayTracer::DisplayFormat format) {
+    if (format == CpuRayTracer::DisplayFormat::RGB10A2) {
+        return { GL_RGB10_A2, GL_UNSIGNED_INT_2_10_10_10_REV };
+    }
+    return { GL_RGBA8, GL_UNSIGNED_INT_8_8_8_8_REV };
 }
-)";
-
-const char* textureFragmentShaderSource = R"(
-#version 330 core
-out vec4 FragColor;
-
-in vec2 TexCoords;
 
-uniform sampler2D screenTexture;
+} // namespace
 
-void main()
-{
-    FragColor = texture(screenTexture, TexCoords);
+CpuRayTracer::CpuRayTracer() {
+    setPipelineDepth(DEFAULT_PIPELINE_DEPTH);
 }
-)";
-
-CpuRayTracer::CpuRayTracer() {}
 
 CpuRayTracer::~CpuRayTracer() {
-    glDeleteVertexArrays(1, &quadVAO);
-    glDeleteBuffers(1, &quadVBO);
+    pipeline.reset();
+    cleanupUploadRing();
     glDeleteTextures(1, &textureID);
-    glDeleteProgram(shaderProgram);
 }
 
 void CpuRayTracer::init(int width, int height) {
-    setupQuad();
-    setupShader();
-    
     // Initialize texture
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    bufferWidth = width;
-    bufferHeight = height;
-    pixelBuffer.resize(width * height * 3);
+    updateTexture(width, height, settings.displayFormat);
 }
 
-void CpuRayTracer::setupQuad() {
-    float quadVertices[] = {
-        // positions        // texture Coords
-        -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-         1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-         1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-    };
-    
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+void CpuRayTracer::setPipelineDepth(int depth) {
+    depth = std::clamp(depth, 0, FramePipeline::MAX_DEPTH);
+    if (depth == 0) {
+        pipeline.reset(); // Joins the render thread; the renderer is ours again
+    } else if (pipeline) {
+        pipeline->setDepth(depth);
+    } else {
+        pipeline = std::make_unique<FramePipeline>(renderer, accumulation, depth);
+    }
 }
 
-void CpuRayTracer::setupShader() {
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &textureVertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &textureFragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+void CpuRayTracer::updateTexture(int width, int height, DisplayFormat format) {
+    textureWidth = width;
+    textureHeight = height;
+    textureFormat = format;
+
+    DisplayTexelFormat texel = texelFormatFor(format);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, texel.internalFormat, width, height, 0, GL_RGBA, texel.type, NULL);
+    setupUploadRing(width, height);
 }
 
-glm::vec3 CpuRayTracer::traceRay(const glm::vec3& origin, const glm::vec3& direction) {
-    // Sphere definition (matching GPU)
-    glm::vec3 sphereCenter(0.0f, 0.0f, -3.0f);
-    float sphereRadius = 1.0f;
-    glm::vec3 sphereColor(1.0f, 0.2f, 0.2f);
-    
-    // Ray-Sphere Intersection
-    glm::vec3 oc = origin - sphereCenter;
-    float a = glm::dot(direction, direction);
-    float b = 2.0f * glm::dot(oc, direction);
-    float c = glm::dot(oc, oc) - sphereRadius * sphereRadius;
-    float discriminant = b*b - 4*a*c;
-    
-    if (discriminant > 0) {
-        float t = (-b - sqrt(discriminant)) / (2.0f * a);
-        if (t > 0) {
-            // Hit
-            glm::vec3 hitPoint = origin + direction * t;
-            glm::vec3 normal = glm::normalize(hitPoint - sphereCenter);
-            
-            // Simple lighting
-            glm::vec3 lightDir = glm::normalize(glm::vec3(1.0f, 1.0f, 1.0f));
-            float diff = std::max(glm::dot(normal, lightDir), 0.0f);
-            glm::vec3 ambient(0.1f);
-            
-            return (ambient + diff) * sphereColor;
+void CpuRayTracer::setupUploadRing(int width, int height) {
+    cleanupUploadRing();
+
+    GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * sizeof(uint32_t);
+    persistentMapping = GLAD_GL_VERSION_4_4;
+    for (UploadBuffer& buffer : uploadRing) {
+        glGenBuffers(1, &buffer.pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+        if (persistentMapping) {
+            // Coherent, so tonemapped texels are visible to the copy without an explicit flush
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+            buffer.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+        } else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
         }
     }
-    
-    // Background
-    glm::vec3 unitDir = glm::normalize(direction);
-    float t_bg = 0.5f * (unitDir.y + 1.0f);
-    return (1.0f - t_bg) * glm::vec3(1.0f, 1.0f, 1.0f) + t_bg * glm::vec3(0.5f, 0.7f, 1.0f);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    nextUpload = 0;
 }
 
-void CpuRayTracer::render(const Camera& camera, int width, int height) {
-    // Resize buffer if needed
-    if (width != bufferWidth || height != bufferHeight) {
-        bufferWidth = width;
-        bufferHeight = height;
-        pixelBuffer.resize(width * height * 3);
-        
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-    }
-    
-    // Calculate camera basis
-    glm::vec3 w = glm::normalize(camera.position - (camera.position + camera.front));
-    glm::vec3 u = glm::normalize(glm::cross(camera.up, w));
-    glm::vec3 v = glm::cross(w, u);
-    
-    float theta = glm::radians((float)camera.zoom);
-    float h = tan(theta/2);
-    float viewport_height = 2.0 * h;
-    float viewport_width = viewport_height * ((float)width/height);
-    
-    glm::vec3 horizontal = viewport_width * u;
-    glm::vec3 vertical = viewport_height * v;
-    glm::vec3 lower_left_corner = camera.position - horizontal/2.0f - vertical/2.0f - w;
-    
-    // Parallelize this loop for performance if possible (OpenMP would be good here, but standard C++ for now)
-    #pragma omp parallel for
-    for (int j = 0; j < height; ++j) {
-        for (int i = 0; i < width; ++i) {
-            float u_coord = (float)i / (width - 1);
-            float v_coord = (float)j / (height - 1);
-            
-            glm::vec3 rayDir = lower_left_corner + u_coord*horizontal + v_coord*vertical - camera.position;
-            glm::vec3 color = traceRay(camera.position, rayDir);
-            
-            int index = (j * width + i) * 3;
-            pixelBuffer[index] = color.r;
-            pixelBuffer[index + 1] = color.g;
-            pixelBuffer[index + 2] = color.b;
+void CpuRayTracer::cleanupUploadRing() {
+    for (UploadBuffer& buffer : uploadRing) {
+        if (buffer.fence) {
+            glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
         }
+        if (buffer.pbo) {
+            // Deleting a buffer unmaps it
+            glDeleteBuffers(1, &buffer.pbo);
+            buffer.pbo = 0;
+        }
+        buffer.mapped = nullptr;
     }
-    
-    // Update texture
+}
+
+bool CpuRayTracer::render(const Camera& camera, const World& world, int width, int height) {
+    return pipeline ? renderPipelined(camera, world, width, height) : renderSynchronously(camera, world, width, height);
+}
+
+bool CpuRayTracer::renderSynchronously(const Camera& camera, const World& world, int width, int height) {
+    // Resize texture if needed
+    if (width != textureWidth || height != textureHeight || settings.displayFormat != textureFormat) {
+        updateTexture(width, height, settings.displayFormat);
+        accumulation.reset(); // A converged image would otherwise never be uploaded
+    }
+
+    // The caller's world outlives the call, so it is used in place rather than copied
+    FramePipeline::Request request{ camera, std::shared_ptr<const World>(std::shared_ptr<const World>(), &world),
+                                    width, height, settings };
+    if (!FramePipeline::trace(renderer, accumulation, request, lastStats)) {
+        return false; // The texture already holds the final image
+    }
+
+    auto uploadBegin = std::chrono::steady_clock::now();
+    upload(width, height, nullptr);
+    lastUploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - uploadBegin).count();
+    lastRenderMs = lastStats.traceMs + lastUploadMs;
+    return true;
+}
+
+bool CpuRayTracer::renderPipelined(const Camera& camera, const World& world, int width, int height) {
+    // The render thread gets its own copy of the scene, made again only when it changes
+    if (!worldSnapshot || snapshotSource != &world || snapshotRevision != world.getRevision()) {
+        worldSnapshot = std::make_shared<const World>(world.snapshot());
+        snapshotSource = &world;
+        snapshotRevision = world.getRevision();
+    }
+    pipeline->submit({ camera, worldSnapshot, width, height, settings });
+
+    const FramePipeline::Frame* frame = pipeline->acquire();
+    if (!frame) {
+        return false;
+    }
+
+    auto uploadBegin = std::chrono::steady_clock::now();
+    const FramePipeline::Stats& stats = frame->stats;
+    if (stats.width != textureWidth || stats.height != textureHeight || frame->format != textureFormat) {
+        updateTexture(stats.width, stats.height, frame->format);
+    }
+    upload(stats.width, stats.height, frame->texels.data());
+    lastStats = stats;
+    lastUploadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - uploadBegin).count();
+    lastRenderMs = lastStats.traceMs + lastUploadMs;
+    return true;
+}
+
+bool CpuRayTracer::upload(int width, int height, const uint32_t* texels) {
+    UploadBuffer& buffer = uploadRing[nextUpload];
+    nextUpload = (nextUpload + 1) % UPLOAD_RING_SIZE;
+
+    // Written UPLOAD_RING_SIZE frames ago, so normally long copied by now
+    if (buffer.fence) {
+        glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(buffer.fence);
+        buffer.fence = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+    size_t size = static_cast<size_t>(width) * height * sizeof(uint32_t);
+    void* dst = buffer.mapped;
+    if (!dst) {
+        // Orphans the previous storage, so mapping never waits for the GPU either
+        dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+    if (!dst) {
+        std::cerr << "ERROR::CPU_RAYTRACER:: Could not map the upload buffer, frame dropped" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    if (texels) {
+        std::memcpy(dst, texels, size);
+    } else {
+        renderer.tonemap(textureFormat, static_cast<uint32_t*>(dst));
+    }
+    // GL_FALSE means the storage was lost while mapped (e.g. a mode switch)
+    if (!buffer.mapped && glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE) {
+        std::cerr << "ERROR::CPU_RAYTRACER:: Upload buffer contents were lost, frame dropped" << std::endl;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    // Sourced from the bound buffer: returns at once and copies in the background
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, pixelBuffer.data());
-    
-    // Render quad
-    glUseProgram(shaderProgram);
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, texelFormatFor(textureFormat).type, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return true;
 }
@@ -0,0 +1,198 @@
+#include "CpuRenderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Geodesic.hpp"
+
+CpuRenderer::CpuRenderer(unsigned int threadCount, int tileSize)
+    : pool(threadCount)
+    , tileSize(tileSize > 0 ? tileSize : 1)
+    , isa(GeodesicPacket::detectIsa())
+{
+}
+
+void CpuRenderer::setIsa(GeodesicPacket::Isa requested) {
+    isa = GeodesicPacket::isSupported(requested) ? requested : GeodesicPacket::detectIsa();
+}
+
+void CpuRenderer::render(const Camera& camera, const World& world, int width, int height,
+                         const glm::vec2& jitter, float blend) {
+    renderRegion(camera, world, width, height, { 0, 0, width, height }, jitter, blend);
+}
+
+void CpuRenderer::renderRegion(const Camera& camera, const World& world, int width, int height,
+                               const Region& region, const glm::vec2& jitter, float blend) {
+    // Resize buffer if needed
+    if (region.width != bufferWidth || region.height != bufferHeight) {
+        bufferWidth = region.width;
+        bufferHeight = region.height;
+        pixelBuffer.resize((size_t)region.width * region.height * 3);
+        blend = 1.0f; // Nothing to average with
+    }
+
+    // Flatten the scene so the hot loop never touches the World; kept across
+    // frames (e.g. a whole sequence) until the World changes
+    if (sceneRevision != world.getRevision()) {
+        blackHoles = Geodesic::gatherBlackHoles(world);
+        sceneRevision = world.getRevision();
+    }
+    const Geodesic::BlackHoleData* bhData = blackHoles.data();
+    int numBlackHoles = static_cast<int>(blackHoles.size());
+    const Geodesic::MarchParams params = marchParams;
+
+    // A lone hole can be shaded from precomputed geodesics; only rays near its disk are marched
+    std::shared_ptr<const DeflectionTable> table;
+    if (deflectionLut && numBlackHoles == 1) {
+        table = deflectionCache.get(bhData[0].rs, params, &pool);
+    }
+    usingDeflectionLut = table != nullptr;
+
+    // Camera basis, matching the ray setup in raytracer.frag
+    float halfHeight = std::tan(glm::radians(camera.zoom) * 0.5f);
+    float halfWidth = halfHeight * ((float)width / height);
+    glm::vec3 origin = camera.position;
+    glm::vec3 front = camera.front;
+    glm::vec3 right = camera.right * halfWidth;
+    glm::vec3 up = camera.up * halfHeight;
+
+    // Sample the sky at the mip level matching the pixel size at the centre of the view
+    Geodesic::Sky sky{ skyMap.get(), 0.0f, skyParams };
+    if (skyMap) sky.lod = skyMap->lodForPixel(2.0f * halfHeight / height);
+
+    int tilesX = (region.width + tileSize - 1) / tileSize;
+    int tilesY = (region.height + tileSize - 1) / tileSize;
+    tileStats.resize(tilesX * tilesY);
+
+    // Geodesic cost varies wildly per pixel (photon sphere vs. open sky), so
+    // tiles are scheduled through the work-stealing pool rather than split statically
+    pool.parallelFor(tilesX * tilesY, [&](int tile, int worker) {
+        auto tileBegin = std::chrono::steady_clock::now();
+
+        int x0 = region.x + (tile % tilesX) * tileSize;
+        int y0 = region.y + (tile / tilesX) * tileSize;
+        int x1 = std::min(x0 + tileSize, region.x + region.width);
+        int y1 = std::min(y0 + tileSize, region.y + region.height);
+
+        // Rays along a tile row are neighbours, so they march as coherent SIMD packets
+        constexpr int kChunk = 64;
+        alignas(64) float dirX[kChunk], dirY[kChunk], dirZ[kChunk];
+        float rgb[kChunk * 3];
+        int marched[kChunk];    // Pixels of the chunk the table could not shade
+        float marchedRgb[kChunk * 3];
+        uint64_t steps = 0;
+        uint64_t skippedRays = 0;
+
+        for (int j = y0; j < y1; ++j) {
+            // Pixel centre in NDC, row 0 is the bottom of the texture
+            float ndcY = ((j + 0.5f + jitter.y) / height) * 2.0f - 1.0f;
+
+            for (int i0 = x0; i0 < x1; i0 += kChunk) {
+                int count = std::min(kChunk, x1 - i0);
+                for (int k = 0; k < count; ++k) {
+                    float ndcX = ((i0 + k + 0.5f + jitter.x) / width) * 2.0f - 1.0f;
+                    glm::vec3 rayDir = glm::normalize(front + ndcX * right + ndcY * up);
+                    dirX[k] = rayDir.x;
+                    dirY[k] = rayDir.y;
+                    dirZ[k] = rayDir.z;
+                }
+
+                if (!table) {
+                    steps += GeodesicPacket::traceRays(isa, origin, dirX, dirY, dirZ, count, bhData, numBlackHoles,
+                                                       rgb, params, sky, &skippedRays);
+                } else {
+                    // Compact the rays that need marching to the front so they still fill whole packets
+                    int numMarched = 0;
+                    for (int k = 0; k < count; ++k) {
+                        glm::vec3 color;
+                        glm::vec3 rayDir(dirX[k], dirY[k], dirZ[k]);
+                        if (table->shade(origin, rayDir, bhData[0], color, sky)) {
+                            rgb[k * 3] = color.r;
+                            rgb[k * 3 + 1] = color.g;
+                            rgb[k * 3 + 2] = color.b;
+                        } else {
+                            dirX[numMarched] = rayDir.x;
+                            dirY[numMarched] = rayDir.y;
+                            dirZ[numMarched] = rayDir.z;
+                            marched[numMarched++] = k;
+                        }
+                    }
+                    if (numMarched > 0) {
+                        steps += GeodesicPacket::traceRays(isa, origin, dirX, dirY, dirZ, numMarched, bhData,
+                                                           numBlackHoles, marchedRgb, params, sky, &skippedRays);
+                        for (int m = 0; m < numMarched; ++m) {
+                            std::copy(marchedRgb + m * 3, marchedRgb + m * 3 + 3, rgb + marched[m] * 3);
+                        }
+                    }
+                }
+
+                // Running average for progressive refinement
+                float* dst = &pixelBuffer[((size_t)(j - region.y) * region.width + (i0 - region.x)) * 3];
+                if (blend >= 1.0f) {
+                    std::copy(rgb, rgb + count * 3, dst);
+                } else {
+                    for (int k = 0; k < count * 3; ++k) {
+                        dst[k] += (rgb[k] - dst[k]) * blend;
+                    }
+                }
+            }
+        }
+
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tileBegin).count();
+        tileStats[tile] = { x0, y0, x1 - x0, y1 - y0, worker, ms, steps, skippedRays };
+    });
+}
+
+namespace {
+
+// One row of linear RGB floats to packed texels with BITS per channel and the rest of the word as opaque alpha
+template <int BITS>
+void packRow(const float* src, uint32_t* dst, int width) {
+    constexpr float MAX_VALUE = static_cast<float>((1 << BITS) - 1);
+    constexpr uint32_t ALPHA = ~0u << (3 * BITS);
+    for (int x = 0; x < width; ++x) {
+        // Compile-time shifts, no branches and a signed conversion, so the loop vectorizes
+        uint32_t r = static_cast<int>(std::clamp(src[x * 3], 0.0f, 1.0f) * MAX_VALUE + 0.5f);
+        uint32_t g = static_cast<int>(std::clamp(src[x * 3 + 1], 0.0f, 1.0f) * MAX_VALUE + 0.5f);
+        uint32_t b = static_cast<int>(std::clamp(src[x * 3 + 2], 0.0f, 1.0f) * MAX_VALUE + 0.5f);
+        dst[x] = ALPHA | r | (g << BITS) | (b << (2 * BITS));
+    }
+}
+
+} // namespace
+
+void CpuRenderer::tonemap(DisplayFormat format, uint32_t* out) {
+    const int width = bufferWidth;
+    const int height = bufferHeight;
+
+    // A band of rows per pool index keeps the scheduling cost negligible next to the conversion
+    constexpr int ROWS_PER_BAND = 16;
+    int bands = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+    pool.parallelFor(bands, [&](int band, int) {
+        int y1 = std::min(height, (band + 1) * ROWS_PER_BAND);
+        for (int y = band * ROWS_PER_BAND; y < y1; ++y) {
+            const float* src = &pixelBuffer[(size_t)y * width * 3];
+            uint32_t* dst = out + (size_t)y * width;
+            if (format == DisplayFormat::RGB10A2) {
+                packRow<10>(src, dst, width);
+            } else {
+                packRow<8>(src, dst, width);
+            }
+        }
+    });
+}
+
+uint64_t CpuRenderer::getLastFrameSteps() const {
+    uint64_t steps = 0;
+    for (const auto& tile : tileStats) {
+        steps += tile.steps;
+    }
+    return steps;
+}
+
+uint64_t CpuRenderer::getLastFrameSkippedRays() const {
+    uint64_t skipped = 0;
+    for (const auto& tile : tileStats) {
+        skipped += tile.skippedRays;
+    }
+    return skipped;
+}
@@ -0,0 +1,199 @@
+#include "Deflate.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr int WINDOW_SIZE = 32768;
+constexpr int HASH_BITS = 15;
+constexpr int MIN_MATCH = 3;
+constexpr int MAX_MATCH = 258;
+// Candidates tried per position; longer chains find little more in rendered images
+constexpr int MAX_CHAIN = 16;
+constexpr size_t MAX_STORED_BLOCK = 65535;
+
+constexpr uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                         257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                         8193, 12289, 16385, 24577 };
+constexpr uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                         7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Deflate packs bits from the least significant end, but Huffman codes go most significant bit first
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : out(out) {}
+
+    void put(uint32_t value, int count) {
+        bits |= static_cast<uint64_t>(value) << used;
+        used += count;
+        while (used >= 8) {
+            out.push_back(static_cast<unsigned char>(bits));
+            bits >>= 8;
+            used -= 8;
+        }
+    }
+
+    void putCode(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        put(reversed, length);
+    }
+
+    void flush() {
+        if (used > 0) out.push_back(static_cast<unsigned char>(bits));
+        bits = 0;
+        used = 0;
+    }
+
+private:
+    std::vector<unsigned char>& out;
+    uint64_t bits = 0;
+    int used = 0;
+};
+
+// Fixed literal/length code (RFC 1951, 3.2.6)
+void putLiteralLength(BitWriter& writer, int symbol) {
+    if (symbol < 144) writer.putCode(0x30 + symbol, 8);
+    else if (symbol < 256) writer.putCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280) writer.putCode(symbol - 256, 7);
+    else writer.putCode(0xC0 + symbol - 280, 8);
+}
+
+void putMatch(BitWriter& writer, int length, int distance) {
+    int lengthCode = static_cast<int>(std::upper_bound(LENGTH_BASE, LENGTH_BASE + 29, length) - LENGTH_BASE) - 1;
+    putLiteralLength(writer, 257 + lengthCode);
+    writer.put(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+    int distanceCode = static_cast<int>(std::upper_bound(DISTANCE_BASE, DISTANCE_BASE + 30, distance) - DISTANCE_BASE) - 1;
+    writer.putCode(distanceCode, 5);
+    writer.put(distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+}
+
+uint32_t hash3(const unsigned char* p) {
+    uint32_t key = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    return (key * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// One final block with the fixed codes
+void deflateFixed(const unsigned char* data, size_t size, std::vector<unsigned char>& out) {
+    std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+    std::vector<int32_t> previous(WINDOW_SIZE, -1);
+    BitWriter writer(out);
+    writer.put(1, 1); // BFINAL
+    writer.put(1, 2); // BTYPE = fixed Huffman
+
+    auto insert = [&](size_t pos) {
+        uint32_t h = hash3(data + pos);
+        previous[pos & (WINDOW_SIZE - 1)] = head[h];
+        head[h] = static_cast<int32_t>(pos);
+    };
+
+    size_t pos = 0;
+    while (pos < size) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (pos + MIN_MATCH <= size) {
+            int maxLength = static_cast<int>(std::min<size_t>(MAX_MATCH, size - pos));
+            int32_t candidate = head[hash3(data + pos)];
+            for (int chain = 0; chain < MAX_CHAIN && candidate >= 0; ++chain) {
+                size_t distance = pos - candidate;
+                if (distance > WINDOW_SIZE) break;
+                const unsigned char* a = data + candidate;
+                const unsigned char* b = data + pos;
+                // Checking the byte that would beat the best so far first rejects most candidates at once
+                if (a[bestLength] == b[bestLength]) {
+                    int length = 0;
+                    while (length < maxLength && a[length] == b[length]) ++length;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = static_cast<int>(distance);
+                        if (length == maxLength) break;
+                    }
+                }
+                int32_t next = previous[candidate & (WINDOW_SIZE - 1)];
+                if (next >= candidate) break; // The slot has been reused by a newer position
+                candidate = next;
+            }
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            putMatch(writer, bestLength, bestDistance);
+            size_t end = pos + bestLength;
+            for (; pos < end; ++pos) {
+                if (pos + MIN_MATCH <= size) insert(pos);
+            }
+        } else {
+            putLiteralLength(writer, data[pos]);
+            if (pos + MIN_MATCH <= size) insert(pos);
+            ++pos;
+        }
+    }
+    putLiteralLength(writer, 256); // End of block
+    writer.flush();
+}
+
+void deflateStored(const unsigned char* data, size_t size, std::vector<unsigned char>& out) {
+    size_t pos = 0;
+    do {
+        size_t length = std::min(size - pos, MAX_STORED_BLOCK);
+        bool last = pos + length == size;
+        // Block headers of stored blocks end on a byte boundary
+        out.push_back(last ? 1 : 0);
+        out.push_back(static_cast<unsigned char>(length));
+        out.push_back(static_cast<unsigned char>(length >> 8));
+        out.push_back(static_cast<unsigned char>(~length));
+        out.push_back(static_cast<unsigned char>(~length >> 8));
+        out.insert(out.end(), data + pos, data + pos + length);
+        pos += length;
+    } while (pos < size);
+}
+
+} // namespace
+
+namespace Deflate {
+
+void compress(const unsigned char* data, size_t size, std::vector<unsigned char>& out) {
+    // CM = 8 (deflate), 32 KiB window, no dictionary, "fastest" level; the check bits make it a multiple of 31
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    size_t start = out.size();
+    deflateFixed(data, size, out);
+    size_t storedSize = size + 5 * std::max<size_t>(1, (size + MAX_STORED_BLOCK - 1) / MAX_STORED_BLOCK);
+    if (out.size() - start > storedSize) {
+        out.resize(start);
+        deflateStored(data, size, out);
+    }
+
+    uint32_t check = adler32(data, size);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<unsigned char>(check >> shift));
+    }
+}
+
+uint32_t adler32(const unsigned char* data, size_t size, uint32_t adler) {
+    constexpr uint32_t MOD = 65521;
+    // Sums can run this many bytes before they could overflow 32 bits
+    constexpr size_t RUN = 5552;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t run = std::min(size, RUN);
+        size -= run;
+        for (size_t i = 0; i < run; ++i) {
+            a += data[i];
+            b += a;
+        }
+        data += run;
+        a %= MOD;
+        b %= MOD;
+    }
+    return (b << 16) | a;
+}
+
+} // namespace Deflate
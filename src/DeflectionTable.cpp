@@ -0,0 +1,145 @@
+#include "DeflectionTable.hpp"
+#include <algorithm>
+#include <cmath>
+#include "ThreadPool.hpp"
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+constexpr int ROWS = 2 * DeflectionTable::RADIUS_SAMPLES;
+
+} // namespace
+
+DeflectionTable::DeflectionTable(float rs, const Geodesic::MarchParams& params, ThreadPool* pool)
+    : rs(rs)
+    , params(params)
+    , data(static_cast<size_t>(IMPACT_SAMPLES) * ROWS * 2, 0.0f)
+{
+    // A bare hole at the origin, observer on the +z axis, rays in the xz plane
+    const Geodesic::BlackHoleData hole{ glm::vec3(0.0f), rs, 0.0f, 0.0f };
+
+    auto traceRow = [&](int row, int) {
+        bool outbound = row >= RADIUS_SAMPLES;
+        float radius = radiusAt(outbound ? row - RADIUS_SAMPLES : row);
+        glm::vec3 ro(0.0f, 0.0f, radius);
+        float* out = &data[static_cast<size_t>(row) * IMPACT_SAMPLES * 2];
+
+        // From large impact parameters (almost unbent) inwards, so the
+        // deflection can be unwrapped past +-pi as rays start to loop the hole
+        float previous = 0.0f;
+        for (int column = IMPACT_SAMPLES - 1; column >= 0; --column) {
+            float sinAlpha = std::min(impactAt(column), radius) / radius;
+            float cosAlpha = std::sqrt(std::max(0.0f, 1.0f - sinAlpha * sinAlpha));
+            glm::vec3 rd(sinAlpha, 0.0f, outbound ? cosAlpha : -cosAlpha);
+            // Unit vector perpendicular to rd, on the side of the hole
+            glm::vec3 towards = outbound ? glm::vec3(cosAlpha, 0.0f, -sinAlpha) : glm::vec3(-cosAlpha, 0.0f, -sinAlpha);
+
+            Geodesic::RayState ray{ ro, rd, glm::vec3(0.0f) };
+            Geodesic::StepResult result = Geodesic::march(ray, &hole, 1, this->params);
+
+            float deflection = previous;
+            float transmittance = 0.0f;
+            if (result != Geodesic::StepResult::Captured) {
+                deflection = std::atan2(glm::dot(ray.dir, towards), glm::dot(ray.dir, rd));
+                while (deflection - previous > PI) deflection -= 2.0f * PI;
+                while (deflection - previous < -PI) deflection += 2.0f * PI;
+                transmittance = 1.0f;
+            }
+            out[column * 2] = deflection;
+            out[column * 2 + 1] = transmittance;
+            previous = deflection;
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(ROWS, traceRow);
+    } else {
+        for (int row = 0; row < ROWS; ++row) traceRow(row, 0);
+    }
+}
+
+float DeflectionTable::impactAt(int column) const {
+    float u = (float)column / (IMPACT_SAMPLES - 1);
+    return rs * (std::pow(1.0f + Geodesic::ESCAPE_RADIUS / rs, u) - 1.0f);
+}
+
+float DeflectionTable::radiusAt(int row) const {
+    float v = (float)row / (RADIUS_SAMPLES - 1);
+    return rs * std::pow(Geodesic::ESCAPE_RADIUS / rs, v);
+}
+
+float DeflectionTable::impactCoord(float impactParameter) const {
+    float u = std::log(1.0f + impactParameter / rs) / std::log(1.0f + Geodesic::ESCAPE_RADIUS / rs);
+    return std::clamp(u * (IMPACT_SAMPLES - 1), 0.0f, (float)(IMPACT_SAMPLES - 1));
+}
+
+float DeflectionTable::radiusCoord(float observerRadius) const {
+    float v = std::log(std::max(observerRadius, rs) / rs) / std::log(Geodesic::ESCAPE_RADIUS / rs);
+    return std::clamp(v * (RADIUS_SAMPLES - 1), 0.0f, (float)(RADIUS_SAMPLES - 1));
+}
+
+DeflectionTable::Sample DeflectionTable::fetch(int column, int row) const {
+    const float* sample = &data[(static_cast<size_t>(row) * IMPACT_SAMPLES + column) * 2];
+    return { sample[0], sample[1] };
+}
+
+DeflectionTable::Sample DeflectionTable::lookup(float observerRadius, float impactParameter, bool outbound) const {
+    float x = impactCoord(impactParameter);
+    float y = radiusCoord(observerRadius);
+    int x0 = std::min((int)x, IMPACT_SAMPLES - 2);
+    int y0 = std::min((int)y, RADIUS_SAMPLES - 2);
+    float fx = x - x0;
+    float fy = y - y0;
+    int rowOffset = outbound ? RADIUS_SAMPLES : 0;
+
+    Sample s00 = fetch(x0, y0 + rowOffset);
+    Sample s10 = fetch(x0 + 1, y0 + rowOffset);
+    Sample s01 = fetch(x0, y0 + 1 + rowOffset);
+    Sample s11 = fetch(x0 + 1, y0 + 1 + rowOffset);
+    auto bilinear = [&](float a, float b, float c, float d) {
+        return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fy);
+    };
+    return { bilinear(s00.deflection, s10.deflection, s01.deflection, s11.deflection),
+             bilinear(s00.transmittance, s10.transmittance, s01.transmittance, s11.transmittance) };
+}
+
+bool DeflectionTable::shade(const glm::vec3& ro, const glm::vec3& rd, const Geodesic::BlackHoleData& bh,
+                            glm::vec3& color, const Geodesic::Sky& sky) const {
+    glm::vec3 toHole = bh.pos - ro;
+    float radius = glm::length(toHole);
+    float along = glm::dot(toHole, rd);
+    glm::vec3 perpendicular = toHole - along * rd;
+    float impact = glm::length(perpendicular);
+    bool outbound = along < 0.0f;
+
+    // Periapsis is at most b, so farther out the ray can never cross the disk;
+    // an outbound ray also only moves away from it
+    float diskReach = bh.diskOuter + bh.rs;
+    if (bh.diskOuter > 0.0f && impact < diskReach && (!outbound || radius < diskReach)) {
+        return false;
+    }
+
+    Sample sample = lookup(radius, impact, outbound);
+    glm::vec3 towards = impact > 0.0f ? perpendicular / impact : rd;
+    glm::vec3 dir = rd * std::cos(sample.deflection) + towards * std::sin(sample.deflection);
+    color = sample.transmittance * sky.sample(dir);
+    return true;
+}
+
+std::shared_ptr<const DeflectionTable> DeflectionCache::get(float rs, const Geodesic::MarchParams& params,
+                                                             ThreadPool* pool) {
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        if ((*it)->getRs() == rs && (*it)->getParams() == params) {
+            auto table = *it;
+            tables.erase(it);
+            tables.push_back(table);
+            return table;
+        }
+    }
+
+    if (tables.size() >= capacity) {
+        tables.erase(tables.begin());
+    }
+    tables.push_back(std::make_shared<const DeflectionTable>(rs, params, pool));
+    return tables.back();
+}
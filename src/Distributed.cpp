@@ -0,0 +1,717 @@
+#include "Distributed.hpp"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include "Accumulation.hpp"
+#include "SceneFile.hpp"
+#include "SkyMap.hpp"
+#include "World.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace Distributed {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+#if defined(_WIN32)
+using SocketHandle = SOCKET;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+constexpr int SEND_FLAGS = 0;
+constexpr int SHUTDOWN_BOTH = SD_BOTH;
+
+void closeSocket(SocketHandle handle) { closesocket(handle); }
+int pollSockets(pollfd* fds, int count, int timeoutMs) { return WSAPoll(fds, count, timeoutMs); }
+
+// Winsock has to be started once per process before any other call
+bool startNetworking() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+#else
+using SocketHandle = int;
+constexpr SocketHandle NO_SOCKET = -1;
+constexpr int SEND_FLAGS = MSG_NOSIGNAL; // A vanished peer is an error return, not SIGPIPE
+constexpr int SHUTDOWN_BOTH = SHUT_RDWR;
+
+void closeSocket(SocketHandle handle) { close(handle); }
+int pollSockets(pollfd* fds, int count, int timeoutMs) { return poll(fds, static_cast<nfds_t>(count), timeoutMs); }
+bool startNetworking() { return true; }
+#endif
+
+// Owning TCP socket with whole-buffer sends and receives
+class Socket {
+public:
+    Socket() = default;
+    explicit Socket(SocketHandle handle) : handle(handle) {}
+    ~Socket() {
+        if (handle != NO_SOCKET) closeSocket(handle);
+    }
+
+    Socket(Socket&& other) noexcept : handle(other.handle) { other.handle = NO_SOCKET; }
+    Socket& operator=(Socket&& other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    bool isValid() const { return handle != NO_SOCKET; }
+    SocketHandle get() const { return handle; }
+
+    bool sendAll(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+            auto sent = send(handle, bytes, chunk, SEND_FLAGS);
+            if (sent <= 0) return false;
+            bytes += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool receiveAll(void* data, size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+            auto received = recv(handle, bytes, chunk, 0);
+            if (received <= 0) return false; // Closed or failed
+            bytes += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    // Fails any send or receive blocked on the socket in another thread
+    void shutdownBoth() {
+        if (handle != NO_SOCKET) shutdown(handle, SHUTDOWN_BOTH);
+    }
+
+private:
+    SocketHandle handle = NO_SOCKET;
+};
+
+// Units and results are small, frequent messages: send them straight away
+void setNoDelay(const Socket& socket) {
+    int enabled = 1;
+    setsockopt(socket.get(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+}
+
+Socket connectTo(const std::string& host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return Socket();
+    }
+
+    Socket socket;
+    for (addrinfo* address = addresses; address && !socket.isValid(); address = address->ai_next) {
+        Socket candidate(::socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+        if (candidate.isValid()
+            && connect(candidate.get(), address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == 0) {
+            socket = std::move(candidate);
+        }
+    }
+    freeaddrinfo(addresses);
+    if (socket.isValid()) setNoDelay(socket);
+    return socket;
+}
+
+// --- Messages: a type and payload size, then the payload ---
+
+enum class MessageType : uint32_t {
+    Hello = 1,  // Worker -> coordinator: protocol version
+    Job,        // Coordinator -> worker: Job::encode()
+    Ready,      // Worker -> coordinator: job loaded and sky baked, units welcome
+    Unit,       // Coordinator -> worker: unit id, frame, region
+    Result,     // Worker -> coordinator: unit id, steps, skipped rays, RGB floats
+    Done        // Coordinator -> worker: no more units
+};
+
+// Headers and payload fields are copied byte for byte
+static_assert(std::endian::native == std::endian::little, "Messages are sent as little-endian structs");
+
+struct MessageHeader {
+    uint32_t type;
+    uint32_t size;
+};
+
+// Also bounds what a corrupt header can make the receiver allocate
+constexpr uint32_t MAX_MESSAGE_SIZE = 1u << 30;
+
+bool sendMessage(Socket& socket, MessageType type, const std::vector<unsigned char>& payload) {
+    MessageHeader header{ static_cast<uint32_t>(type), static_cast<uint32_t>(payload.size()) };
+    return payload.size() <= MAX_MESSAGE_SIZE && socket.sendAll(&header, sizeof(header))
+           && socket.sendAll(payload.data(), payload.size());
+}
+
+bool receiveMessage(Socket& socket, MessageType& type, std::vector<unsigned char>& payload) {
+    MessageHeader header;
+    if (!socket.receiveAll(&header, sizeof(header)) || header.size > MAX_MESSAGE_SIZE) return false;
+    type = static_cast<MessageType>(header.type);
+    payload.resize(header.size);
+    return socket.receiveAll(payload.data(), payload.size());
+}
+
+class PayloadWriter {
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        putBytes(&value, sizeof(value));
+    }
+    void putBytes(const void* data, size_t size) {
+        const unsigned char* begin = static_cast<const unsigned char*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+    std::vector<unsigned char>& getBytes() { return bytes; }
+
+private:
+    std::vector<unsigned char> bytes;
+};
+
+// Reads past the end fail and leave the reader failed, so fields can be read
+// unchecked and the result tested once
+class PayloadReader {
+public:
+    explicit PayloadReader(const std::vector<unsigned char>& bytes) : bytes(bytes) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        getBytes(&value, sizeof(value));
+        return value;
+    }
+    void getBytes(void* data, size_t size) {
+        if (size > remaining()) {
+            ok = false;
+            return;
+        }
+        std::memcpy(data, bytes.data() + offset, size);
+        offset += size;
+    }
+    const unsigned char* current() const { return bytes.data() + offset; }
+    size_t remaining() const { return ok ? bytes.size() - offset : 0; }
+    bool isOk() const { return ok; }
+
+private:
+    const std::vector<unsigned char>& bytes;
+    size_t offset = 0;
+    bool ok = true;
+};
+
+} // namespace
+
+// --- Job ---
+
+std::vector<unsigned char> Job::encode() const {
+    PayloadWriter out;
+    out.put<int32_t>(width);
+    out.put<int32_t>(height);
+    out.put<int32_t>(samples);
+    out.put<int32_t>(unitSize);
+    out.put<int32_t>(marchParams.maxSteps);
+    out.put<float>(marchParams.maxDistance);
+    out.put<float>(marchParams.stepFactor);
+    out.put<float>(marchParams.bendingStrength);
+    out.put<int32_t>(static_cast<int32_t>(marchParams.integrator));
+    out.put<float>(marchParams.tolerance);
+    out.put<uint8_t>(marchParams.boundingSpheres);
+    out.put<uint8_t>(deflectionLut);
+    out.put<float>(skyParams.starDensity);
+    out.put<float>(skyParams.nebulaIntensity);
+    out.put<uint8_t>(bakedSky);
+    out.put<int32_t>(skySize);
+    out.put<uint32_t>(static_cast<uint32_t>(frames.size()));
+    for (const CameraPose& pose : frames) {
+        out.put(pose.position);
+        out.put<float>(pose.yaw);
+        out.put<float>(pose.pitch);
+        out.put<float>(pose.fov);
+    }
+    out.put<uint64_t>(scene.size());
+    out.putBytes(scene.data(), scene.size());
+    return std::move(out.getBytes());
+}
+
+bool Job::decode(const std::vector<unsigned char>& data, Job& job) {
+    PayloadReader in(data);
+    job.width = in.get<int32_t>();
+    job.height = in.get<int32_t>();
+    job.samples = in.get<int32_t>();
+    job.unitSize = in.get<int32_t>();
+    job.marchParams.maxSteps = in.get<int32_t>();
+    job.marchParams.maxDistance = in.get<float>();
+    job.marchParams.stepFactor = in.get<float>();
+    job.marchParams.bendingStrength = in.get<float>();
+    job.marchParams.integrator = static_cast<Geodesic::Integrator>(in.get<int32_t>());
+    job.marchParams.tolerance = in.get<float>();
+    job.marchParams.boundingSpheres = in.get<uint8_t>() != 0;
+    job.deflectionLut = in.get<uint8_t>() != 0;
+    job.skyParams.starDensity = in.get<float>();
+    job.skyParams.nebulaIntensity = in.get<float>();
+    job.bakedSky = in.get<uint8_t>() != 0;
+    job.skySize = in.get<int32_t>();
+
+    uint32_t frameCount = in.get<uint32_t>();
+    constexpr size_t POSE_SIZE = sizeof(glm::vec3) + 3 * sizeof(float);
+    if (frameCount > in.remaining() / POSE_SIZE) return false;
+    job.frames.resize(frameCount);
+    for (CameraPose& pose : job.frames) {
+        pose.position = in.get<glm::vec3>();
+        pose.yaw = in.get<float>();
+        pose.pitch = in.get<float>();
+        pose.fov = in.get<float>();
+    }
+
+    uint64_t sceneSize = in.get<uint64_t>();
+    if (sceneSize != in.remaining()) return false;
+    job.scene.assign(in.current(), in.current() + sceneSize);
+    return in.isOk() && job.width > 0 && job.height > 0 && job.samples > 0 && job.unitSize > 0 && job.skySize > 0;
+}
+
+// --- Coordinator ---
+
+struct Coordinator::Listener {
+    Socket socket;
+};
+
+struct Coordinator::Connection {
+    explicit Connection(Socket socket) : socket(std::move(socket)) {}
+
+    Socket socket;
+    std::thread thread;
+    // Guarded by the coordinator's mutex
+    int unit = -1;          // In flight, if any
+    bool idle = false;      // Past the handshake with no unit in flight
+    bool finished = false;  // serve() returned; the thread only has to be joined
+    Clock::time_point assigned;
+};
+
+Coordinator::Coordinator(Job job, FrameSink sink)
+    : job(std::move(job))
+    , sink(std::move(sink))
+{
+    const Job& j = this->job;
+    int unitSize = std::max(j.unitSize, 1);
+    int unitsX = (j.width + unitSize - 1) / unitSize;
+    int unitsY = (j.height + unitSize - 1) / unitSize;
+
+    // Frame by frame and bottom to top, so frames finish (and free their pixels) roughly in order
+    for (int frame = 0; frame < static_cast<int>(j.frames.size()); ++frame) {
+        for (int y = 0; y < unitsY; ++y) {
+            for (int x = 0; x < unitsX; ++x) {
+                int x0 = x * unitSize;
+                int y0 = y * unitSize;
+                CpuRenderer::Region region{ x0, y0, std::min(unitSize, j.width - x0), std::min(unitSize, j.height - y0) };
+                pending.push_back(static_cast<int>(units.size()));
+                units.push_back({ frame, region, false, 0, {} });
+            }
+        }
+    }
+    framePixels.resize(j.frames.size());
+    unitsLeft.assign(j.frames.size(), unitsX * unitsY);
+    frameSunk.assign(j.frames.size(), false);
+    jobMessage = j.encode();
+}
+
+Coordinator::~Coordinator() = default;
+
+bool Coordinator::listen(uint16_t requestedPort) {
+    if (!startNetworking()) {
+        std::cerr << "Could not initialize networking" << std::endl;
+        return false;
+    }
+
+    Socket socket(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (!socket.isValid()) {
+        std::cerr << "Could not create the coordinator socket" << std::endl;
+        return false;
+    }
+#if !defined(_WIN32)
+    // Lets a restarted coordinator take the port back straight away
+    int reuse = 1;
+    setsockopt(socket.get(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(requestedPort);
+    if (bind(socket.get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(socket.get(), SOMAXCONN) != 0) {
+        std::cerr << "Could not listen on port " << requestedPort << std::endl;
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(socket.get(), reinterpret_cast<sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+    listener = std::make_unique<Listener>(Listener{ std::move(socket) });
+    return true;
+}
+
+bool Coordinator::run() {
+    if (!listener) {
+        std::cerr << "The coordinator has to listen before it can run" << std::endl;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = units.empty();
+    }
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (finished) break;
+        }
+        // Short timeout, so the loop notices the job finishing
+        pollfd ready = { listener->socket.get(), POLLIN, 0 };
+        if (pollSockets(&ready, 1, 100) <= 0) continue;
+
+        Socket socket(accept(listener->socket.get(), nullptr, nullptr));
+        if (!socket.isValid()) continue;
+        setNoDelay(socket);
+
+        // Workers that keep reconnecting would otherwise pile up threads and sockets for the whole job
+        std::vector<std::unique_ptr<Connection>> closed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto open = std::stable_partition(connections.begin(), connections.end(),
+                                              [](const std::unique_ptr<Connection>& c) { return !c->finished; });
+            std::move(open, connections.end(), std::back_inserter(closed));
+            connections.erase(open, connections.end());
+        }
+        for (auto& connection : closed) {
+            connection->thread.join();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        connections.push_back(std::make_unique<Connection>(std::move(socket)));
+        Connection& connection = *connections.back();
+        connection.thread = std::thread(&Coordinator::serve, this, std::ref(connection));
+        ++stats.workersConnected;
+    }
+
+    {
+        // Whatever is still being traced is a copy nobody needs; the rest say goodbye on their own
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& connection : connections) {
+            if (!connection->idle) connection->socket.shutdownBoth();
+        }
+    }
+    for (auto& connection : connections) {
+        connection->thread.join();
+    }
+    connections.clear();
+    return !failed;
+}
+
+void Coordinator::serve(Connection& connection) {
+    // However serve() returns, run() may join and drop the connection from then on
+    struct MarkFinished {
+        Coordinator& coordinator;
+        Connection& connection;
+        ~MarkFinished() {
+            std::lock_guard<std::mutex> lock(coordinator.mutex);
+            connection.finished = true;
+        }
+    } markFinished{ *this, connection };
+
+    MessageType type;
+    std::vector<unsigned char> payload;
+    if (!receiveMessage(connection.socket, type, payload) || type != MessageType::Hello) {
+        return; // Not a worker
+    }
+    PayloadReader hello(payload);
+    uint32_t version = hello.get<uint32_t>();
+    if (version != PROTOCOL_VERSION) {
+        std::cerr << "Turning away a worker speaking protocol version " << version << ", expected "
+                  << PROTOCOL_VERSION << std::endl;
+        return;
+    }
+    // Units are only timed from Ready on, so a worker's setup never makes them look slow
+    if (!sendMessage(connection.socket, MessageType::Job, jobMessage)
+        || !receiveMessage(connection.socket, type, payload) || type != MessageType::Ready) {
+        return;
+    }
+
+    while (true) {
+        int id = nextUnit(connection);
+        if (id < 0) {
+            sendMessage(connection.socket, MessageType::Done, {});
+            return;
+        }
+
+        const Unit& unit = units[id];
+        PayloadWriter request;
+        request.put<uint32_t>(static_cast<uint32_t>(id));
+        request.put<int32_t>(unit.frame);
+        request.put(unit.region);
+        if (!sendMessage(connection.socket, MessageType::Unit, request.getBytes())
+            || !receiveMessage(connection.socket, type, payload) || type != MessageType::Result) {
+            abandonUnit(connection, id);
+            return;
+        }
+        if (!completeUnit(connection, id, payload)) {
+            std::cerr << "Dropping a worker that sent a malformed result" << std::endl;
+            abandonUnit(connection, id);
+            return;
+        }
+    }
+}
+
+int Coordinator::nextUnit(Connection& connection) {
+    std::unique_lock<std::mutex> lock(mutex);
+    connection.idle = true;
+    while (!finished) {
+        Clock::time_point now = Clock::now();
+        int id = -1;
+        bool inWindow = !pending.empty()
+            && (frameWindow <= 0 || units[pending.front()].frame < oldestOpenFrame + frameWindow);
+        if (inWindow) {
+            id = pending.front();
+            pending.pop_front();
+        } else if (unitsTimed > 0) {
+            // Nothing new to start: back up the oldest unit that is taking far too long
+            double slowMs = std::max(minSlowUnitMs, slowUnitFactor * unitMsTotal / unitsTimed);
+            for (int i = 0; i < static_cast<int>(units.size()); ++i) {
+                const Unit& unit = units[i];
+                if (unit.done || unit.copies != 1 || elapsedMs(unit.assigned, now) < slowMs) continue;
+                if (id < 0 || unit.assigned < units[id].assigned) id = i;
+            }
+            if (id >= 0) ++stats.unitsDuplicated;
+        }
+
+        if (id >= 0) {
+            Unit& unit = units[id];
+            if (unit.copies++ == 0) unit.assigned = now;
+            connection.unit = id;
+            connection.idle = false;
+            connection.assigned = now;
+            ++stats.unitsAssigned;
+            return id;
+        }
+        // Rechecked now and then, as units only turn slow with time
+        changed.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    return -1;
+}
+
+bool Coordinator::completeUnit(Connection& connection, int id, const std::vector<unsigned char>& result) {
+    const Unit& unit = units[id];
+    const CpuRenderer::Region& region = unit.region;
+    PayloadReader in(result);
+    uint32_t resultId = in.get<uint32_t>();
+    uint64_t steps = in.get<uint64_t>();
+    uint64_t skippedRays = in.get<uint64_t>();
+    size_t rowFloats = static_cast<size_t>(region.width) * 3;
+    if (!in.isOk() || resultId != static_cast<uint32_t>(id) || in.remaining() != rowFloats * region.height * sizeof(float)) {
+        return false;
+    }
+
+    std::vector<float> frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Unit& state = units[id];
+        connection.unit = -1;
+        connection.idle = true;
+        --state.copies;
+        unitMsTotal += elapsedMs(connection.assigned, Clock::now());
+        ++unitsTimed;
+        changed.notify_all();
+        if (state.done) {
+            ++stats.unitsDiscarded;
+            return true; // Another copy got here first
+        }
+        state.done = true;
+        stats.steps += steps;
+        stats.skippedRays += skippedRays;
+
+        std::vector<float>& pixels = framePixels[unit.frame];
+        if (pixels.empty()) pixels.resize(static_cast<size_t>(job.width) * job.height * 3);
+        for (int row = 0; row < region.height; ++row) {
+            float* dst = &pixels[(static_cast<size_t>(region.y + row) * job.width + region.x) * 3];
+            std::memcpy(dst, in.current() + row * rowFloats * sizeof(float), rowFloats * sizeof(float));
+        }
+        if (--unitsLeft[unit.frame] > 0) {
+            return true;
+        }
+        frame.swap(pixels);
+    }
+
+    bool written;
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        written = sink(unit.frame, frame);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++framesFinished;
+    frameSunk[unit.frame] = true;
+    while (oldestOpenFrame < static_cast<int>(frameSunk.size()) && frameSunk[oldestOpenFrame]) ++oldestOpenFrame;
+    failed = failed || !written;
+    finished = failed || framesFinished == static_cast<int>(job.frames.size());
+    changed.notify_all();
+    return true;
+}
+
+void Coordinator::abandonUnit(Connection& connection, int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Unit& unit = units[id];
+    connection.unit = -1;
+    --unit.copies;
+    if (unit.done) ++stats.unitsDiscarded;
+    if (finished) return; // Shut down by run(); nothing is missing
+
+    ++stats.workersLost;
+    if (!unit.done && unit.copies == 0) {
+        // First in line, so the frame it belongs to isn't held up any longer than needed
+        pending.push_front(id);
+        ++stats.unitsRequeued;
+        std::cerr << "Lost a worker, requeueing frame " << unit.frame << " unit (" << unit.region.x << ","
+                  << unit.region.y << ")" << std::endl;
+    }
+    changed.notify_all();
+}
+
+// --- Worker ---
+
+namespace {
+
+constexpr int CONNECT_ATTEMPTS = 50;
+constexpr std::chrono::milliseconds CONNECT_RETRY_DELAY{ 200 };
+
+} // namespace
+
+Worker::Worker(CpuRenderer& renderer, std::string skyCacheDir)
+    : renderer(renderer)
+    , skyCacheDir(std::move(skyCacheDir))
+{
+}
+
+bool Worker::run(const std::string& host, uint16_t port) {
+    if (!startNetworking()) {
+        std::cerr << "Could not initialize networking" << std::endl;
+        return false;
+    }
+
+    Socket socket;
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS && !socket.isValid(); ++attempt) {
+        if (attempt > 0) std::this_thread::sleep_for(CONNECT_RETRY_DELAY);
+        socket = connectTo(host, port);
+    }
+    if (!socket.isValid()) {
+        std::cerr << "Could not connect to coordinator " << host << ":" << port << std::endl;
+        return false;
+    }
+
+    PayloadWriter hello;
+    hello.put<uint32_t>(PROTOCOL_VERSION);
+    MessageType type;
+    std::vector<unsigned char> payload;
+    Job job;
+    if (!sendMessage(socket, MessageType::Hello, hello.getBytes()) || !receiveMessage(socket, type, payload)
+        || type != MessageType::Job || !Job::decode(payload, job)) {
+        std::cerr << "Did not get a job from coordinator " << host << ":" << port << std::endl;
+        return false;
+    }
+
+    World world;
+    if (!SceneFile::decodeBinary(job.scene.data(), job.scene.size(), world)) {
+        return false;
+    }
+    renderer.setMarchParams(job.marchParams);
+    renderer.setDeflectionLut(job.deflectionLut);
+    std::shared_ptr<const SkyMap> skyMap;
+    if (job.bakedSky) {
+        SkyCache skyCache(skyCacheDir);
+        skyMap = skyCache.get(job.skyParams, job.skySize, &renderer.getPool());
+    }
+    renderer.setSky(job.skyParams, skyMap);
+    if (!sendMessage(socket, MessageType::Ready, {})) {
+        std::cerr << "Lost the connection to the coordinator" << std::endl;
+        return false;
+    }
+
+    while (true) {
+        if (!receiveMessage(socket, type, payload)) {
+            std::cerr << "Lost the connection to the coordinator" << std::endl;
+            return false;
+        }
+        if (type == MessageType::Done) {
+            return true;
+        }
+
+        PayloadReader in(payload);
+        uint32_t id = in.get<uint32_t>();
+        int32_t frame = in.get<int32_t>();
+        CpuRenderer::Region region = in.get<CpuRenderer::Region>();
+        bool inside = region.x >= 0 && region.y >= 0 && region.width > 0 && region.height > 0
+                      && region.x + region.width <= job.width && region.y + region.height <= job.height;
+        if (type != MessageType::Unit || !in.isOk() || frame < 0 || frame >= static_cast<int>(job.frames.size())
+            || !inside) {
+            std::cerr << "Unexpected message from the coordinator" << std::endl;
+            return false;
+        }
+        if (unitLimit > 0 && unitsRendered >= unitLimit) {
+            return true; // Walks off with the unit, like a machine going down
+        }
+
+        Camera camera = job.frames[frame].toCamera();
+        uint64_t steps = 0;
+        uint64_t skippedRays = 0;
+        for (int sample = 0; sample < job.samples; ++sample) {
+            renderer.renderRegion(camera, world, job.width, job.height, region,
+                                  Accumulation::jitter(sample), 1.0f / (sample + 1));
+            steps += renderer.getLastFrameSteps();
+            skippedRays += renderer.getLastFrameSkippedRays();
+        }
+        if (unitDelay.count() > 0) {
+            std::this_thread::sleep_for(unitDelay);
+        }
+
+        PayloadWriter result;
+        result.put<uint32_t>(id);
+        result.put<uint64_t>(steps);
+        result.put<uint64_t>(skippedRays);
+        const std::vector<float>& pixels = renderer.getPixelBuffer();
+        result.putBytes(pixels.data(), pixels.size() * sizeof(float));
+        if (!sendMessage(socket, MessageType::Result, result.getBytes())) {
+            std::cerr << "Lost the connection to the coordinator" << std::endl;
+            return false;
+        }
+        ++unitsRendered;
+    }
+}
+
+} // namespace Distributed
@@ -0,0 +1,32 @@
+#pragma once
+
+// Butcher tableau of the Dormand-Prince 5(4) embedded Runge-Kutta pair, shared
+// by the scalar and packet Schwarzschild integrators (raytracer.frag has its
+// own copy). The 5th order solution is propagated; E holds the difference to
+// the 4th order one for the error estimate. Stage 7 is evaluated at the new
+// point, so its derivative is reused as stage 1 of the next step (FSAL).
+namespace DormandPrince {
+
+constexpr float A21 = 1.0f / 5.0f;
+constexpr float A31 = 3.0f / 40.0f, A32 = 9.0f / 40.0f;
+constexpr float A41 = 44.0f / 45.0f, A42 = -56.0f / 15.0f, A43 = 32.0f / 9.0f;
+constexpr float A51 = 19372.0f / 6561.0f, A52 = -25360.0f / 2187.0f, A53 = 64448.0f / 6561.0f,
+                A54 = -212.0f / 729.0f;
+constexpr float A61 = 9017.0f / 3168.0f, A62 = -355.0f / 33.0f, A63 = 46732.0f / 5247.0f,
+                A64 = 49.0f / 176.0f, A65 = -5103.0f / 18656.0f;
+
+// 5th order weights (B2 = 0)
+constexpr float B1 = 35.0f / 384.0f, B3 = 500.0f / 1113.0f, B4 = 125.0f / 192.0f,
+                B5 = -2187.0f / 6784.0f, B6 = 11.0f / 84.0f;
+
+// 5th minus 4th order weights (E2 = 0)
+constexpr float E1 = 71.0f / 57600.0f, E3 = -71.0f / 16695.0f, E4 = 71.0f / 1920.0f,
+                E5 = -17253.0f / 339200.0f, E6 = 22.0f / 525.0f, E7 = -1.0f / 40.0f;
+
+// Step size controller: h *= clamp(SAFETY * err^(-1/4), MIN_SCALE, MAX_SCALE).
+// The 1/4 exponent keeps it to square roots so every backend computes it the same way.
+constexpr float SAFETY = 0.9f;
+constexpr float MIN_SCALE = 0.2f;
+constexpr float MAX_SCALE = 5.0f;
+
+} // namespace DormandPrince
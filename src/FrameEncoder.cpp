@@ -0,0 +1,244 @@
+#include "FrameEncoder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#else
+#include <csignal>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+FrameEncoder::FrameEncoder(int width, int height, Settings settings)
+    : width(width)
+    , height(height)
+    , settings(std::move(settings))
+{
+}
+
+FrameEncoder::~FrameEncoder() {
+    finish();
+}
+
+std::string FrameEncoder::framePath(const std::string& pattern, int frame) {
+    char buffer[1024];
+    std::snprintf(buffer, sizeof(buffer), pattern.c_str(), frame);
+    return buffer;
+}
+
+std::string FrameEncoder::describeTarget(int frame) const {
+    if (piped) return "| " + settings.pipeCommand;
+    if (stream) return settings.output;
+    return framePath(settings.output, frame);
+}
+
+bool FrameEncoder::open() {
+    if (settings.bitDepth != 8 && settings.bitDepth != 16) {
+        std::cerr << "Frames can be written with 8 or 16 bits per sample, not " << settings.bitDepth << std::endl;
+        return false;
+    }
+    if (settings.threads <= 0 || settings.queueDepth <= 0) {
+        std::cerr << "The encoder needs at least one thread and one queue slot" << std::endl;
+        return false;
+    }
+
+    if (!settings.pipeCommand.empty()) {
+        format = settings.pipeFormat;
+        if (!ImageWriter::isRawFormat(format)) {
+            std::cerr << "Only raw RGB or YUV frames can be piped to an encoder" << std::endl;
+            return false;
+        }
+#if defined(_WIN32)
+        stream = popen(settings.pipeCommand.c_str(), "wb");
+#else
+        // An encoder that quits early should fail the write, not kill the renderer
+        std::signal(SIGPIPE, SIG_IGN);
+        stream = popen(settings.pipeCommand.c_str(), "w");
+#endif
+        if (!stream) {
+            std::cerr << "Could not start " << settings.pipeCommand << std::endl;
+            return false;
+        }
+        piped = true;
+    } else {
+        format = ImageWriter::formatFor(settings.output);
+        if (ImageWriter::isRawFormat(format)) {
+            stream = std::fopen(settings.output.c_str(), "wb");
+            if (!stream) {
+                std::cerr << "Could not open " << settings.output << " for writing." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    slots.resize(settings.queueDepth);
+    // More threads than slots would never have anything to do
+    int threadCount = std::min(settings.threads, settings.queueDepth);
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&FrameEncoder::run, this);
+    }
+    return true;
+}
+
+bool FrameEncoder::submit(int frame, const std::vector<float>& pixels) {
+    auto waitBegin = Clock::now();
+    Slot* slot = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto freeSlot = [&] {
+            auto it = std::find_if(slots.begin(), slots.end(),
+                                   [](const Slot& s) { return s.state == SlotState::Free; });
+            return it == slots.end() ? nullptr : &*it;
+        };
+        changed.wait(lock, [&] { return failed || stopping || freeSlot() != nullptr; });
+        if (failed || stopping) return false;
+        stats.waitMs += elapsedMs(waitBegin);
+        slot = freeSlot();
+        slot->state = SlotState::Filling;
+    }
+
+    // Outside the lock, so the threads keep going while a whole frame is copied
+    slot->frame = frame;
+    slot->pixels.assign(pixels.begin(), pixels.end());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slot->state = SlotState::Queued;
+    changed.notify_all();
+    return true;
+}
+
+bool FrameEncoder::finish() {
+    if (finished) return !failed;
+    finished = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    for (const Slot& slot : slots) {
+        if (slot.state == SlotState::Encoded) {
+            // Held back by an earlier frame that never came
+            std::cerr << "Frame " << slot.frame << " was not written: frame " << nextStreamFrame
+                      << " of the stream is missing" << std::endl;
+            failed = true;
+        }
+    }
+    if (stream && !closeStream()) {
+        failed = true;
+    }
+    return !failed;
+}
+
+bool FrameEncoder::closeStream() {
+    std::FILE* file = stream;
+    stream = nullptr;
+    if (!piped) {
+        if (std::fclose(file) != 0) {
+            std::cerr << "Could not finish writing " << settings.output << std::endl;
+            return false;
+        }
+        return true;
+    }
+    // Waits for the encoder to finish the video
+    int status = pclose(file);
+    if (status != 0) {
+        std::cerr << settings.pipeCommand << " failed (status " << status << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void FrameEncoder::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Lowest frame first, so a stream's next frame is never stuck behind later ones
+        Slot* slot = nullptr;
+        for (Slot& candidate : slots) {
+            if (candidate.state == SlotState::Queued && (!slot || candidate.frame < slot->frame)) {
+                slot = &candidate;
+            }
+        }
+        if (!slot) {
+            if (stopping) return;
+            changed.wait(lock);
+            continue;
+        }
+        slot->state = SlotState::Encoding;
+        lock.unlock();
+
+        auto encodeBegin = Clock::now();
+        ImageWriter::encode(format, slot->pixels, width, height, settings.bitDepth, slot->bytes);
+        double encodeMs = elapsedMs(encodeBegin);
+
+        if (stream) {
+            lock.lock();
+            stats.encodeMs += encodeMs;
+            slot->state = SlotState::Encoded;
+            writeStream(lock);
+            continue;
+        }
+
+        auto writeBegin = Clock::now();
+        std::string path = framePath(settings.output, slot->frame);
+        bool written = ImageWriter::writeFile(path, slot->bytes);
+        double writeMs = elapsedMs(writeBegin);
+
+        lock.lock();
+        stats.encodeMs += encodeMs;
+        stats.writeMs += writeMs;
+        if (written) {
+            ++stats.framesWritten;
+            stats.bytesWritten += slot->bytes.size();
+        }
+        failed = failed || !written;
+        slot->state = SlotState::Free;
+        changed.notify_all();
+    }
+}
+
+void FrameEncoder::writeStream(std::unique_lock<std::mutex>& lock) {
+    // Whoever is writing rescans before it stops, so it takes this frame too if it is next
+    if (streamWriting) return;
+    streamWriting = true;
+    while (true) {
+        auto next = std::find_if(slots.begin(), slots.end(), [&](const Slot& s) {
+            return s.state == SlotState::Encoded && s.frame == nextStreamFrame;
+        });
+        if (next == slots.end()) break;
+
+        bool skip = failed;
+        lock.unlock();
+        auto writeBegin = Clock::now();
+        bool written = skip || std::fwrite(next->bytes.data(), 1, next->bytes.size(), stream) == next->bytes.size();
+        double writeMs = elapsedMs(writeBegin);
+        lock.lock();
+
+        if (!written) {
+            std::cerr << "Could not write frame " << next->frame << " to " << describeTarget(next->frame) << std::endl;
+            failed = true;
+        } else if (!skip) {
+            ++stats.framesWritten;
+            stats.bytesWritten += next->bytes.size();
+        }
+        stats.writeMs += writeMs;
+        next->state = SlotState::Free;
+        ++nextStreamFrame;
+        changed.notify_all();
+    }
+    streamWriting = false;
+}
@@ -0,0 +1,116 @@
+#include "FramePipeline.hpp"
+#include <algorithm>
+#include <chrono>
+
+FramePipeline::FramePipeline(CpuRenderer& renderer, Accumulation& accumulation, int depth)
+    : renderer(renderer)
+    , accumulation(accumulation)
+    , depth(std::clamp(depth, 1, MAX_DEPTH))
+{
+    thread = std::thread(&FramePipeline::run, this);
+}
+
+FramePipeline::~FramePipeline() {
+    stopping.store(true, std::memory_order_release);
+    wake();
+    thread.join();
+}
+
+void FramePipeline::setDepth(int newDepth) {
+    depth.store(std::clamp(newDepth, 1, MAX_DEPTH), std::memory_order_relaxed);
+    wake();
+}
+
+void FramePipeline::submit(const Request& request) {
+    requests.write() = request;
+    requests.publish();
+    wake();
+}
+
+const FramePipeline::Frame* FramePipeline::acquire() {
+    if (!frames.update()) return nullptr;
+    wake(); // A depth-1 pipeline waits for exactly this
+    return &frames.read();
+}
+
+void FramePipeline::wake() {
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
+
+bool FramePipeline::trace(CpuRenderer& renderer, Accumulation& accumulation, const Request& request, Stats& stats) {
+    auto traceBegin = std::chrono::steady_clock::now();
+    const Settings& settings = request.settings;
+
+    // Settings Accumulation doesn't key on restart it here
+    if (renderer.getDeflectionLut() != settings.deflectionLut) {
+        accumulation.reset();
+        renderer.setDeflectionLut(settings.deflectionLut);
+    }
+    if (renderer.getSkyParams() != settings.skyParams || renderer.getSkyMap() != settings.skyMap) {
+        accumulation.reset();
+        renderer.setSky(settings.skyParams, settings.skyMap);
+    }
+    renderer.setMarchParams(settings.marchParams);
+    accumulation.setMaxSamples(settings.maxSamples);
+
+    const World& world = *request.world;
+    if (!settings.progressive) {
+        accumulation.reset();
+        renderer.render(request.camera, world, request.width, request.height);
+    } else {
+        accumulation.update(request.camera, world, request.width, request.height, settings.marchParams);
+        if (accumulation.isConverged()) {
+            return false; // The last frame is already the final image
+        }
+        renderer.render(request.camera, world, request.width, request.height,
+                        accumulation.getJitter(), accumulation.getBlendWeight());
+        accumulation.addSample();
+    }
+
+    stats.width = request.width;
+    stats.height = request.height;
+    stats.sampleCount = accumulation.getSampleCount();
+    stats.usingDeflectionLut = renderer.isUsingDeflectionLut();
+    stats.skippedRays = renderer.getLastFrameSkippedRays();
+    stats.traceMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - traceBegin).count();
+    return true;
+}
+
+void FramePipeline::run() {
+    bool haveRequest = false;
+    bool havePublished = false;
+    CpuRenderer::DisplayFormat publishedFormat = CpuRenderer::DisplayFormat::RGBA8;
+
+    while (true) {
+        // Anything the UI thread does after this load wakes the wait below straight away
+        uint32_t seen = wakeups.load(std::memory_order_acquire);
+        if (stopping.load(std::memory_order_acquire)) break;
+
+        // Snapshot for this frame: the newest request submitted so far
+        if (requests.update()) haveRequest = true;
+        bool throttled = depth.load(std::memory_order_relaxed) == 1 && frames.hasPending();
+        if (!haveRequest || throttled) {
+            wakeups.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+
+        const Request& request = requests.read();
+        CpuRenderer::DisplayFormat format = request.settings.displayFormat;
+        if (havePublished && format != publishedFormat) {
+            accumulation.reset(); // A converged image still has to reach the display in the new format
+        }
+
+        Frame& frame = frames.write();
+        if (!trace(renderer, accumulation, request, frame.stats)) {
+            wakeups.wait(seen, std::memory_order_acquire);
+            continue;
+        }
+        frame.texels.resize(static_cast<size_t>(request.width) * request.height);
+        renderer.tonemap(format, frame.texels.data());
+        frame.format = format;
+        frames.publish();
+        havePublished = true;
+        publishedFormat = format;
+    }
+}
@@ -0,0 +1,393 @@
+#include "Geodesic.hpp"
+#include <algorithm>
+#include <cmath>
+#include "DormandPrince.hpp"
+#include "SkyMap.hpp"
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+
+namespace Geodesic {
+
+// --- Starfield & Nebula ---
+// Pseudo-random number generator
+float hash(glm::vec3 p) {
+    p = glm::fract(p * 0.3183099f + 0.1f);
+    p *= 17.0f;
+    return glm::fract(p.x * p.y * p.z * (p.x + p.y + p.z));
+}
+
+float noise(const glm::vec3& x) {
+    glm::vec3 i = glm::floor(x);
+    glm::vec3 f = glm::fract(x);
+    f = f * f * (3.0f - 2.0f * f);
+
+    return glm::mix(glm::mix(glm::mix(hash(i + glm::vec3(0, 0, 0)),
+                                      hash(i + glm::vec3(1, 0, 0)), f.x),
+                             glm::mix(hash(i + glm::vec3(0, 1, 0)),
+                                      hash(i + glm::vec3(1, 1, 0)), f.x), f.y),
+                    glm::mix(glm::mix(hash(i + glm::vec3(0, 0, 1)),
+                                      hash(i + glm::vec3(1, 0, 1)), f.x),
+                             glm::mix(hash(i + glm::vec3(0, 1, 1)),
+                                      hash(i + glm::vec3(1, 1, 1)), f.x), f.y), f.z);
+}
+
+glm::vec3 getNebula(const glm::vec3& dir, float intensity) {
+    // Multi-layered noise for nebula clouds
+    float n = noise(dir * 3.0f);
+    n += 0.5f * noise(dir * 6.0f);
+    n += 0.25f * noise(dir * 12.0f);
+    n /= 1.75f;
+
+    // Color mapping: Dark Blue/Purple -> Bright Blue
+    return glm::mix(glm::vec3(0.05f, 0.0f, 0.1f), glm::vec3(0.1f, 0.4f, 0.8f), n * n * n) * intensity;
+}
+
+glm::vec3 getStarfield(const glm::vec3& dir, const SkyParams& sky) {
+    // Map direction to a grid and hash the cell ID
+    glm::vec3 id = glm::floor(dir * 150.0f);
+    float rnd = hash(id);
+
+    // Threshold to decide if a star exists in this cell
+    float star = rnd < sky.starDensity ? 0.0f : 1.0f;
+
+    return glm::vec3(star) + getNebula(dir, sky.nebulaIntensity); // Combine Stars + Nebula
+}
+
+glm::vec3 Sky::sample(const glm::vec3& dir) const {
+    return map ? map->sample(dir, lod) : getStarfield(dir, params);
+}
+
+// --- General Relativity ---
+namespace {
+
+#if defined(_MSC_VER)
+#define GEODESIC_FORCE_INLINE __forceinline
+#else
+#define GEODESIC_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// Disk density 2 * (1 - |y| / DISK_HALF_THICKNESS) integrated over the height above the midplane from 0 to y
+GEODESIC_FORCE_INLINE float diskDensityIntegral(float y) {
+    float u = std::clamp(y, -DISK_HALF_THICKNESS, DISK_HALF_THICKNESS);
+    return 2.0f * u - u * std::abs(u) / DISK_HALF_THICKNESS;
+}
+
+// Volumetric glow of every accretion disk along the straight segment a -> b.
+// The density is integrated exactly across the slab, so a step of any length
+// neither skips the thin disk nor samples it at an arbitrary height. Whether
+// the segment is inside the disk's radii, and its colour, is decided where it
+// comes closest to the midplane.
+GEODESIC_FORCE_INLINE void accumulateDisks(const glm::vec3& a, const glm::vec3& b, const BlackHoleData* blackHoles,
+                                           int numBlackHoles, glm::vec3& accumColor) {
+    glm::vec3 ab = b - a;
+    float length = glm::length(ab);
+    for (int j = 0; j < numBlackHoles; j++) {
+        const BlackHoleData& bh = blackHoles[j];
+        float ya = a.y - bh.pos.y;
+        float yb = b.y - bh.pos.y;
+        if (std::min(ya, yb) >= DISK_HALF_THICKNESS || std::max(ya, yb) <= -DISK_HALF_THICKNESS) continue;
+
+        float dy = yb - ya;
+        float density, t;
+        if (std::abs(dy) > DISK_FLAT_EPSILON) {
+            density = (diskDensityIntegral(yb) - diskDensityIntegral(ya)) / dy;
+            t = std::clamp(-ya / dy, 0.0f, 1.0f);
+        } else {
+            density = 2.0f * (1.0f - std::abs(0.5f * (ya + yb)) / DISK_HALF_THICKNESS);
+            t = 0.5f;
+        }
+        float r = glm::length(bh.pos - (a + ab * t));
+
+        if (r > bh.diskInner && r < bh.diskOuter) {
+            float temp = (r - bh.diskInner) / (bh.diskOuter - bh.diskInner);
+            glm::vec3 diskColor = glm::mix(glm::vec3(1.0f, 0.8f, 0.5f), glm::vec3(0.8f, 0.2f, 0.1f), temp);
+            accumColor += diskColor * density * length;
+        }
+    }
+}
+
+// Lower bound on the distance from p to the volume of bh's disk: the slab
+// |y| < DISK_HALF_THICKNESS between the spheres of radius diskInner and diskOuter
+GEODESIC_FORCE_INLINE float diskDistance(const glm::vec3& p, const BlackHoleData& bh, float r) {
+    float slab = std::abs(p.y - bh.pos.y) - DISK_HALF_THICKNESS;
+    return std::max(slab, std::max(bh.diskInner - r, r - bh.diskOuter));
+}
+
+// Body of one TraceGeodesic iteration, inlined into the trace loop
+GEODESIC_FORCE_INLINE StepResult stepInline(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                                             const MarchParams& params) {
+    // Find closest black hole for step size and gravity
+    float minR = MAX_DIST;
+    glm::vec3 totalForce(0.0f);
+
+    for (int j = 0; j < numBlackHoles; j++) {
+        glm::vec3 toBH = blackHoles[j].pos - ray.p;
+        float r = glm::length(toBH);
+        minR = std::min(minR, r);
+
+        // Gravity Bending (Sum of forces)
+        // Newtonian approximation: F ~ Rs / r^2
+        float force = params.bendingStrength * blackHoles[j].rs / (r * r);
+        totalForce += (toBH / r) * force;
+    }
+
+    // Adaptive Step Size
+    float h = std::max(MIN_STEP, minR * params.stepFactor);
+
+    // Check Event Horizons
+    for (int j = 0; j < numBlackHoles; j++) {
+        if (glm::length(blackHoles[j].pos - ray.p) < blackHoles[j].rs) {
+            return StepResult::Captured;
+        }
+    }
+
+    // Escape Check
+    if (minR > ESCAPE_RADIUS) {
+        return StepResult::Escaped;
+    }
+
+    // Apply Gravity
+    ray.dir = glm::normalize(ray.dir + totalForce * h);
+
+    // Move Position, collecting the accretion disk glow along the way
+    glm::vec3 start = ray.p;
+    ray.p += ray.dir * h;
+    accumulateDisks(start, ray.p, blackHoles, numBlackHoles, ray.accumColor);
+
+    return StepResult::Continue;
+}
+
+GEODESIC_FORCE_INLINE StepResult marchNewtonian(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                                                 const MarchParams& params, int& steps) {
+    const glm::vec3 ro = ray.p;
+    StepResult result = StepResult::Continue;
+
+    int i = 0;
+    while (i < params.maxSteps && result == StepResult::Continue) {
+        result = stepInline(ray, blackHoles, numBlackHoles, params);
+        i++;
+
+        // Max Distance Check
+        if (glm::length(ray.p - ro) > params.maxDistance) break;
+    }
+    steps = i;
+    return result;
+}
+
+// Schwarzschild x'' (the Binet equation u'' + u = 3/2 rs u^2 in Cartesian
+// form) summed over the holes. Each hole's h = |cross(x, x')| is taken from the
+// ray's start: exact for a single hole (h is conserved), an approximation for several.
+GEODESIC_FORCE_INLINE glm::vec3 schwarzschildAccel(const glm::vec3& p, const glm::vec3& ro, const glm::vec3& rd,
+                                                   const BlackHoleData* blackHoles, int numBlackHoles,
+                                                   float bendingStrength) {
+    glm::vec3 accel(0.0f);
+    for (int j = 0; j < numBlackHoles; j++) {
+        glm::vec3 h = glm::cross(ro - blackHoles[j].pos, rd);
+        glm::vec3 x = p - blackHoles[j].pos;
+        float r2 = glm::dot(x, x);
+        float r5 = r2 * r2 * std::sqrt(r2);
+        accel -= x * (bendingStrength * blackHoles[j].rs * glm::dot(h, h) / r5);
+    }
+    return accel;
+}
+
+GEODESIC_FORCE_INLINE StepResult marchSchwarzschild(RayState& ray, const BlackHoleData* blackHoles,
+                                                     int numBlackHoles, const MarchParams& params, int& steps) {
+    using namespace DormandPrince;
+    const glm::vec3 ro = ray.p;
+    const glm::vec3 rd = ray.dir;
+    auto accelAt = [&](const glm::vec3& p) {
+        return schwarzschildAccel(p, ro, rd, blackHoles, numBlackHoles, params.bendingStrength);
+    };
+
+    glm::vec3 p = ro;
+    glm::vec3 v = rd;
+    glm::vec3 a = accelAt(p);
+    glm::vec3 accumColor = ray.accumColor;
+    StepResult result = StepResult::Continue;
+    float h = 0.0f; // Picked on the first iteration
+
+    int i = 0;
+    while (i < params.maxSteps) {
+        // Closest hole, horizons and how far the nearest disk is
+        float minR = MAX_DIST;
+        float minDisk = MAX_DIST;
+        for (int j = 0; j < numBlackHoles; j++) {
+            float r = glm::length(blackHoles[j].pos - p);
+            minR = std::min(minR, r);
+            minDisk = std::min(minDisk, diskDistance(p, blackHoles[j], r));
+            if (r < blackHoles[j].rs) result = StepResult::Captured;
+        }
+        if (result == StepResult::Captured) break;
+        if (minR > ESCAPE_RADIUS) {
+            result = StepResult::Escaped;
+            break;
+        }
+
+        // The error control sizes steps for the bending; the disk glow is integrated along
+        // each step, so a step only has to stay short where it can cut through a disk
+        float firstStep = std::max(MIN_STEP, minR * params.stepFactor);
+        float maxStep = std::min(std::max(MIN_STEP, minR * RK_MAX_STEP_FACTOR), std::max(RK_DISK_STEP, minDisk));
+        h = std::min(h > 0.0f ? h : firstStep, maxStep);
+
+        // Dormand-Prince stages for y = (p, v), y' = (v, a(p))
+        glm::vec3 v1 = v, a1 = a;
+        glm::vec3 v2 = v + h * (A21 * a1);
+        glm::vec3 a2 = accelAt(p + h * (A21 * v1));
+        glm::vec3 v3 = v + h * (A31 * a1 + A32 * a2);
+        glm::vec3 a3 = accelAt(p + h * (A31 * v1 + A32 * v2));
+        glm::vec3 v4 = v + h * (A41 * a1 + A42 * a2 + A43 * a3);
+        glm::vec3 a4 = accelAt(p + h * (A41 * v1 + A42 * v2 + A43 * v3));
+        glm::vec3 v5 = v + h * (A51 * a1 + A52 * a2 + A53 * a3 + A54 * a4);
+        glm::vec3 a5 = accelAt(p + h * (A51 * v1 + A52 * v2 + A53 * v3 + A54 * v4));
+        glm::vec3 v6 = v + h * (A61 * a1 + A62 * a2 + A63 * a3 + A64 * a4 + A65 * a5);
+        glm::vec3 a6 = accelAt(p + h * (A61 * v1 + A62 * v2 + A63 * v3 + A64 * v4 + A65 * v5));
+
+        glm::vec3 pNext = p + h * (B1 * v1 + B3 * v3 + B4 * v4 + B5 * v5 + B6 * v6);
+        glm::vec3 vNext = v + h * (B1 * a1 + B3 * a3 + B4 * a4 + B5 * a5 + B6 * a6);
+        glm::vec3 aNext = accelAt(pNext);
+
+        // Local error, position relative to the distance to the nearest hole
+        glm::vec3 errP = h * (E1 * v1 + E3 * v3 + E4 * v4 + E5 * v5 + E6 * v6 + E7 * vNext);
+        glm::vec3 errV = h * (E1 * a1 + E3 * a3 + E4 * a4 + E5 * a5 + E6 * a6 + E7 * aNext);
+        float err = std::max(glm::length(errP) / (params.tolerance * minR), glm::length(errV) / params.tolerance);
+        i++;
+
+        if (err < 1.0f || h <= MIN_STEP) {
+            accumulateDisks(p, pNext, blackHoles, numBlackHoles, accumColor);
+            p = pNext;
+            v = vNext;
+            a = aNext;
+
+            // Max Distance Check
+            if (glm::length(p - ro) > params.maxDistance) break;
+        }
+
+        float scale = err > 0.0f ? SAFETY / std::sqrt(std::sqrt(err)) : MAX_SCALE;
+        h = std::max(MIN_STEP, h * std::clamp(scale, MIN_SCALE, MAX_SCALE));
+    }
+    steps = i;
+
+    // |v| drifts near a hole (only h is conserved), so hand back a unit direction
+    ray.p = p;
+    ray.dir = glm::normalize(v);
+    ray.accumColor = accumColor;
+    return result;
+}
+
+} // namespace
+
+StepResult step(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles, const MarchParams& params) {
+    return stepInline(ray, blackHoles, numBlackHoles, params);
+}
+
+float influenceRadius(const BlackHoleData& bh) {
+    return std::max(INFLUENCE_RS_FACTOR * bh.rs, DISK_REACH * bh.diskOuter);
+}
+
+float skipToInfluence(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                      const MarchParams& params) {
+    const glm::vec3 ro = ray.p;
+    const glm::vec3 rd = ray.dir;
+
+    // Nearest entry into an influence sphere along the straight line
+    float entry = MAX_DIST;
+    bool enters = false;
+    for (int j = 0; j < numBlackHoles; j++) {
+        glm::vec3 toBH = blackHoles[j].pos - ro;
+        float radius = influenceRadius(blackHoles[j]);
+        float dist2 = glm::dot(toBH, toBH);
+        if (dist2 <= radius * radius) {
+            return 0.0f; // Already inside, march from here
+        }
+        float along = glm::dot(toBH, rd);
+        glm::vec3 perpendicular = toBH - along * rd; // Not dist2 - along^2, which cancels far out
+        float perp2 = glm::dot(perpendicular, perpendicular);
+        if (along > 0.0f && perp2 < radius * radius) {
+            entry = std::min(entry, along - std::sqrt(radius * radius - perp2));
+            enters = true;
+        }
+    }
+
+    // Deflection collected on the skipped segment: the perpendicular pull of
+    // each hole integrated along the line, with s measured from the closest approach
+    bool schwarzschild = params.integrator == Integrator::Schwarzschild;
+    auto integral = [&](float s, float b) {
+        float r = std::sqrt(s * s + b * b);
+        return schwarzschild ? s * (2.0f * s * s + 3.0f * b * b) / (3.0f * r * r * r) : s / r;
+    };
+    glm::vec3 bend(0.0f);
+    for (int j = 0; j < numBlackHoles; j++) {
+        glm::vec3 toBH = blackHoles[j].pos - ro;
+        float along = glm::dot(toBH, rd);
+        glm::vec3 perpendicular = toBH - along * rd;
+        float b = glm::length(perpendicular);
+        if (b <= 0.0f) continue; // Radial rays are not bent
+
+        float atEnd = enters ? integral(entry - along, b) : (schwarzschild ? 2.0f / 3.0f : 1.0f);
+        float strength = params.bendingStrength * blackHoles[j].rs / b;
+        bend += perpendicular / b * (strength * (atEnd - integral(-along, b)));
+    }
+    if (numBlackHoles > 0) {
+        ray.dir = glm::normalize(rd + bend);
+    }
+
+    if (!enters) {
+        return -1.0f;
+    }
+    ray.p = ro + rd * entry;
+    return entry;
+}
+
+StepResult march(RayState& ray, const BlackHoleData* blackHoles, int numBlackHoles,
+                 const MarchParams& params, int* stepsTaken) {
+    int steps = 0;
+    StepResult result = params.integrator == Integrator::Schwarzschild
+        ? marchSchwarzschild(ray, blackHoles, numBlackHoles, params, steps)
+        : marchNewtonian(ray, blackHoles, numBlackHoles, params, steps);
+    if (stepsTaken) *stepsTaken = steps;
+    return result;
+}
+
+glm::vec3 traceGeodesic(const glm::vec3& ro, const glm::vec3& rd,
+                        const BlackHoleData* blackHoles, int numBlackHoles, int* stepsTaken,
+                        const MarchParams& params, const Sky& sky, bool* skippedRay) {
+    RayState ray{ ro, rd, glm::vec3(0.0f) };
+    int steps = 0;
+    StepResult result = StepResult::Escaped;
+    float skipped = params.boundingSpheres ? skipToInfluence(ray, blackHoles, numBlackHoles, params) : 0.0f;
+    bool marched = skipped >= 0.0f && skipped < params.maxDistance;
+    if (skippedRay) *skippedRay = !marched;
+    if (marched) {
+        // The distance limit still counts from the camera
+        MarchParams remaining = params;
+        remaining.maxDistance -= skipped;
+        result = params.integrator == Integrator::Schwarzschild
+            ? marchSchwarzschild(ray, blackHoles, numBlackHoles, remaining, steps)
+            : marchNewtonian(ray, blackHoles, numBlackHoles, remaining, steps);
+    }
+    if (stepsTaken) *stepsTaken = steps;
+
+    // Copy out so the ray state never has its address taken and stays in registers
+    glm::vec3 accumColor = ray.accumColor;
+    if (result == StepResult::Captured) {
+        return accumColor; // Black
+    }
+    glm::vec3 dir = ray.dir;
+    return accumColor + sky.sample(dir); // Escaped, or fallback
+}
+
+std::vector<BlackHoleData> gatherBlackHoles(const World& world) {
+    const BlackHolePool& pool = world.getBlackHoles();
+    std::vector<BlackHoleData> result(pool.size());
+    const glm::vec3* positions = pool.positions();
+    const float* rs = pool.schwarzschildRadii();
+    const float* diskInner = pool.diskInner();
+    const float* diskOuter = pool.diskOuter();
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] = { positions[i], rs[i], diskInner[i], diskOuter[i] };
+    }
+    return result;
+}
+
+} // namespace Geodesic
@@ -0,0 +1,145 @@
+#include "GeodesicPacket.hpp"
+#include <cstring>
+#include "simd/PacketIsa.hpp"
+
+#if GEODESIC_PACKET_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace GeodesicPacket {
+
+namespace {
+
+#if GEODESIC_PACKET_X86
+#if defined(_MSC_VER)
+// CPUID feature bits plus the OS check that the wider registers are saved on context switches
+bool cpuSupports(Isa isa) {
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool osAvx = (xcr0 & 0x6) == 0x6;
+    bool osAvx512 = (xcr0 & 0xE6) == 0xE6;
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    switch (isa) {
+    case Isa::SSE41: return sse41;
+    case Isa::AVX2: return avx && avx2 && fma && osAvx;
+    case Isa::AVX512: return avx512f && osAvx512;
+    default: return true;
+    }
+}
+#else
+bool cpuSupports(Isa isa) {
+    __builtin_cpu_init();
+    switch (isa) {
+    case Isa::SSE41: return __builtin_cpu_supports("sse4.1");
+    case Isa::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::AVX512: return __builtin_cpu_supports("avx512f");
+    default: return true;
+    }
+}
+#endif
+#else
+bool cpuSupports(Isa isa) {
+    return isa == Isa::Scalar;
+}
+#endif
+
+} // namespace
+
+Isa detectIsa() {
+    static const Isa best = [] {
+        for (Isa isa : { Isa::AVX512, Isa::AVX2, Isa::SSE41 }) {
+            if (cpuSupports(isa)) return isa;
+        }
+        return Isa::Scalar;
+    }();
+    return best;
+}
+
+bool isSupported(Isa isa) {
+    return cpuSupports(isa);
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::SSE41: return "sse4.1";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+bool parseIsa(const char* name, Isa& isa) {
+    for (Isa candidate : { Isa::Scalar, Isa::SSE41, Isa::AVX2, Isa::AVX512 }) {
+        if (std::strcmp(name, isaName(candidate)) == 0) {
+            isa = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+int laneCount(Isa isa) {
+    switch (isa) {
+    case Isa::SSE41: return 4;
+    case Isa::AVX2: return 8;
+    case Isa::AVX512: return 16;
+    default: return 1;
+    }
+}
+
+uint64_t traceRays(Isa isa, const glm::vec3& origin,
+                   const float* dirX, const float* dirY, const float* dirZ, int count,
+                   const Geodesic::BlackHoleData* blackHoles, int numBlackHoles,
+                   float* outRGB, const Geodesic::MarchParams& params, const Geodesic::Sky& sky,
+                   uint64_t* skippedRays) {
+    if (count <= 0) return 0;
+
+#if GEODESIC_PACKET_X86
+    switch (isa) {
+    case Isa::SSE41:
+        return traceRaysSse41(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB, params,
+                              sky, skippedRays);
+    case Isa::AVX2:
+        return traceRaysAvx2(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB, params,
+                             sky, skippedRays);
+    case Isa::AVX512:
+        return traceRaysAvx512(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB, params,
+                               sky, skippedRays);
+    default:
+        break;
+    }
+#endif
+
+    uint64_t steps = 0;
+    for (int k = 0; k < count; ++k) {
+        int raySteps = 0;
+        bool skipped = false;
+        glm::vec3 color = Geodesic::traceGeodesic(origin, glm::vec3(dirX[k], dirY[k], dirZ[k]),
+                                                  blackHoles, numBlackHoles, &raySteps, params, sky, &skipped);
+        outRGB[k * 3] = color.r;
+        outRGB[k * 3 + 1] = color.g;
+        outRGB[k * 3 + 2] = color.b;
+        steps += raySteps;
+        // Not raySteps == 0: a ray can also escape before its first step
+        if (skippedRays && skipped) ++*skippedRays;
+    }
+    return steps;
+}
+
+} // namespace GeodesicPacket
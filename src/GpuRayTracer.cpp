@@ -1,14 +1,19 @@
 #include "GpuRayTracer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
 #include <fstream>
 #include <sstream>
-#include "objects/BlackHole.hpp"
+#include <vector>
+#include "Geodesic.hpp"
 #include "World.hpp"
 
-// Helper to load shader code from file
+// Helper to load shader code from file. GLSL has no includes, so each
+// #include "name" line is replaced by that file, looked up next to this one.
 std::string loadShaderSource(const char* filePath) {
-    std::string content;
     std::ifstream fileStream(filePath, std::ios::in);
 
     if (!fileStream.is_open()) {
@@ -16,25 +21,148 @@ std::string loadShaderSource(const char* filePath) {
         return "";
     }
 
-    std::stringstream sstr;
-    sstr << fileStream.rdbuf();
-    content = sstr.str();
-    fileStream.close();
-    return content;
+    std::string directory = filePath;
+    size_t slash = directory.find_last_of("/\\");
+    directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+    std::stringstream content;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(fileStream, line)) {
+        ++lineNumber;
+        size_t open = line.find('"');
+        size_t close = line.rfind('"');
+        if (line.rfind("#include", 0) == 0 && open != std::string::npos && close > open) {
+            content << loadShaderSource((directory + line.substr(open + 1, close - open - 1)).c_str());
+            // Compile errors after it keep this file's line numbers
+            content << "#line " << lineNumber + 1 << "\n";
+        } else {
+            content << line << "\n";
+        }
+    }
+    return content.str();
 }
 
+namespace {
+
+// One element of uBlackHoles under std140: pos and rs share the first 16
+// bytes, the disk radii the second (padded to the struct's vec4 alignment)
+struct BlackHoleStd140 {
+    glm::vec3 pos;
+    float rs;
+    float diskInner;
+    float diskOuter;
+    float pad[2];
+};
+static_assert(sizeof(BlackHoleStd140) == 32, "must match the std140 layout of BlackHoleData");
+
+// uNumBlackHoles is padded to 16 bytes, the array starts after it
+constexpr int SCENE_HEADER_SIZE = 16;
+constexpr unsigned int SCENE_BINDING = 0;
+
+// Unit 0 is left to whoever samples the output texture
+constexpr int DEFLECTION_TEXTURE_UNIT = 1;
+constexpr int SKY_TEXTURE_UNIT = 2;
+constexpr int LOW_RES_EMISSION_UNIT = 3;
+constexpr int LOW_RES_SKY_UNIT = 4;
+constexpr int HISTORY_EMISSION_UNIT = 5;
+constexpr int HISTORY_SKY_UNIT = 6;
+
+// Image and buffer bindings of raytracer.comp
+constexpr unsigned int OUTPUT_IMAGE_UNIT = 0;
+constexpr unsigned int WORK_QUEUE_BINDING = 1;
+
+// Side of the pixel tiles raytracer.comp hands out, one group's worth each
+constexpr int COMPUTE_TILE_SIZE = 8;
+
+// Persistent work groups dispatched by the compute backend: some 64K lanes,
+// enough to fill a large GPU. More would only queue behind the first ones.
+constexpr int COMPUTE_GROUPS = 1024;
+
+// uPass in raytracer.frag
+constexpr int PASS_FULL = 0;
+constexpr int PASS_LOW_RES = 1;
+constexpr int PASS_UPSAMPLE = 2;
+
+// Neighbouring reduced-resolution rays whose sky directions are further apart
+// than this many of their own pixel widths are treated as an edge
+constexpr float UPSAMPLE_EDGE_PIXELS = 4.0f;
+
+// Reprojected history is rejected beyond this much parallax error, in pixels
+constexpr float REPROJECT_MAX_ERROR_PIXELS = 0.5f;
+
+// Formats of the RayResult targets (EmissionOut, SkyOut in raytracer.frag);
+// the sky directions need full floats
+constexpr GLenum RAY_RESULT_FORMATS[2] = { GL_RGBA16F, GL_RGBA32F };
+
+void createRayResultTexture(unsigned int texture, GLenum format, int width, int height) {
+    // Read back with texelFetch only, so no filtering
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+// Inserts extra lines right after the #version directive
+std::string insertDefines(const std::string& source, const std::string& defines) {
+    size_t lineEnd = source.find('\n');
+    if (lineEnd == std::string::npos) return source + "\n" + defines;
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+// Float literal the GLSL compiler reads back as the same float
+std::string glslFloat(float value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string literal = buffer;
+    if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+    return literal;
+}
+
+} // namespace
+
 GpuRayTracer::GpuRayTracer() {}
 
 GpuRayTracer::~GpuRayTracer() {
     cleanupFramebuffer();
+    cleanupLowResTargets();
+    cleanupHistory();
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
-    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &sceneUBO);
+    glDeleteTextures(1, &deflectionTexture);
+    glDeleteTextures(1, &skyTexture);
+    glDeleteQueries(2, timerQueries);
+    glDeleteProgram(genericProgram.id);
+    for (const auto& variant : variants) {
+        glDeleteProgram(variant.second.id);
+    }
+    glDeleteProgram(computeProgram.id);
+    for (const auto& variant : computeVariants) {
+        glDeleteProgram(variant.second.id);
+    }
+    glDeleteBuffers(1, &workQueueBuffer);
 }
 
 void GpuRayTracer::init(const std::string& fragmentShaderPath) {
+    // Size the black hole array to whatever the driver's uniform block limit allows
+    int maxBlockSize = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+    maxBlackHoles = (maxBlockSize - SCENE_HEADER_SIZE) / (int)sizeof(BlackHoleStd140);
+
     setupQuad();
     setupShaders(fragmentShaderPath);
+    setupSceneBuffer();
+    glGenQueries(2, timerQueries);
+
+    if (isComputeSupported()) {
+        glGenBuffers(1, &workQueueBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, workQueueBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
 }
 
 void GpuRayTracer::setupQuad() {
@@ -61,8 +189,22 @@ void GpuRayTracer::setupQuad() {
 }
 
 void GpuRayTracer::setupShaders(const std::string& fragmentShaderPath) {
-    std::string vertexCode = loadShaderSource("shaders/raytracer.vert");
-    std::string fragmentCode = loadShaderSource(fragmentShaderPath.c_str());
+    vertexSource = loadShaderSource("shaders/raytracer.vert");
+    fragmentSource = insertDefines(loadShaderSource(fragmentShaderPath.c_str()),
+                                   "#define MAX_BLACK_HOLES " + std::to_string(maxBlackHoles) + "\n");
+
+    genericProgram = buildProgram("");
+    if (GLAD_GL_VERSION_4_3) {
+        computeSource = insertDefines(loadShaderSource("shaders/raytracer.comp"),
+                                      "#define MAX_BLACK_HOLES " + std::to_string(maxBlackHoles) + "\n");
+        computeProgram = buildComputeProgram("");
+    }
+    postProcess.init(vertexSource, loadShaderSource("shaders/postprocess.frag"));
+}
+
+GpuRayTracer::ShaderProgram GpuRayTracer::buildProgram(const std::string& defines) {
+    std::string vertexCode = vertexSource;
+    std::string fragmentCode = insertDefines(fragmentSource, defines);
     
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
@@ -89,69 +231,495 @@ void GpuRayTracer::setupShaders(const std::string& fragmentShaderPath) {
         std::cout << "ERROR::GPU_RAYTRACER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
     
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    ShaderProgram program;
+    program.id = glCreateProgram();
+    glAttachShader(program.id, vertexShader);
+    glAttachShader(program.id, fragmentShader);
+    glLinkProgram(program.id);
     
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    glGetProgramiv(program.id, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        glGetProgramInfoLog(program.id, 512, NULL, infoLog);
         std::cout << "ERROR::GPU_RAYTRACER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
     
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    resolveUniforms(program);
+    return program;
+}
+
+GpuRayTracer::ShaderProgram GpuRayTracer::buildComputeProgram(const std::string& defines) {
+    std::string computeCode = insertDefines(computeSource, defines);
+    const char* cShaderCode = computeCode.c_str();
+
+    unsigned int computeShader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(computeShader, 1, &cShaderCode, NULL);
+    glCompileShader(computeShader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+        std::cout << "ERROR::GPU_RAYTRACER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    ShaderProgram program;
+    program.id = glCreateProgram();
+    glAttachShader(program.id, computeShader);
+    glLinkProgram(program.id);
+    glDeleteShader(computeShader);
+
+    glGetProgramiv(program.id, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program.id, 512, NULL, infoLog);
+        std::cout << "ERROR::GPU_RAYTRACER::COMPUTE_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        // Leaves the fragment backend in charge
+        glDeleteProgram(program.id);
+        return ShaderProgram();
+    }
+
+    resolveUniforms(program);
+    return program;
 }
 
-void GpuRayTracer::render(const Camera& camera, const World& world, int width, int height, float time) {
+void GpuRayTracer::resolveUniforms(ShaderProgram& program) {
+    // Resolve uniform locations once instead of on every frame. Parameters
+    // baked into a variant are not uniforms there and resolve to -1, which
+    // glUniform* ignores.
+    program.uniforms.cameraPos = glGetUniformLocation(program.id, "cameraPos");
+    program.uniforms.view = glGetUniformLocation(program.id, "view");
+    program.uniforms.projection = glGetUniformLocation(program.id, "projection");
+    program.uniforms.time = glGetUniformLocation(program.id, "time");
+    program.uniforms.resolution = glGetUniformLocation(program.id, "uResolution");
+    program.uniforms.jitter = glGetUniformLocation(program.id, "uJitter");
+    program.uniforms.maxSteps = glGetUniformLocation(program.id, "uMaxSteps");
+    program.uniforms.maxDistance = glGetUniformLocation(program.id, "uMaxDistance");
+    program.uniforms.stepFactor = glGetUniformLocation(program.id, "uStepFactor");
+    program.uniforms.bendingStrength = glGetUniformLocation(program.id, "uBendingStrength");
+    program.uniforms.integrator = glGetUniformLocation(program.id, "uIntegrator");
+    program.uniforms.tolerance = glGetUniformLocation(program.id, "uTolerance");
+    program.uniforms.boundingSpheres = glGetUniformLocation(program.id, "uBoundingSpheres");
+    program.uniforms.useDeflectionTable = glGetUniformLocation(program.id, "uUseDeflectionTable");
+    program.uniforms.deflectionLogRange = glGetUniformLocation(program.id, "uDeflectionLogRange");
+    program.uniforms.starDensity = glGetUniformLocation(program.id, "uStarDensity");
+    program.uniforms.nebulaIntensity = glGetUniformLocation(program.id, "uNebulaIntensity");
+    program.uniforms.useSkyMap = glGetUniformLocation(program.id, "uUseSkyMap");
+    program.uniforms.skyLod = glGetUniformLocation(program.id, "uSkyLod");
+    program.uniforms.pass = glGetUniformLocation(program.id, "uPass");
+    program.uniforms.upsampleMinCos = glGetUniformLocation(program.id, "uUpsampleMinCos");
+    program.uniforms.temporal = glGetUniformLocation(program.id, "uTemporal");
+    program.uniforms.prevViewProjection = glGetUniformLocation(program.id, "uPrevViewProjection");
+    program.uniforms.prevCameraPos = glGetUniformLocation(program.id, "uPrevCameraPos");
+    program.uniforms.maxAge = glGetUniformLocation(program.id, "uMaxAge");
+    program.uniforms.reprojectMinCos = glGetUniformLocation(program.id, "uReprojectMinCos");
+    program.uniforms.reprojectMaxError = glGetUniformLocation(program.id, "uReprojectMaxError");
+    program.uniforms.blendWeight = glGetUniformLocation(program.id, "uBlendWeight");
+
+    // Samplers never change unit, so set them once
+    glUseProgram(program.id);
+    glUniform1i(glGetUniformLocation(program.id, "uDeflectionTable"), DEFLECTION_TEXTURE_UNIT);
+    glUniform1i(glGetUniformLocation(program.id, "uSkyMap"), SKY_TEXTURE_UNIT);
+    glUniform1i(glGetUniformLocation(program.id, "uLowResEmission"), LOW_RES_EMISSION_UNIT);
+    glUniform1i(glGetUniformLocation(program.id, "uLowResSky"), LOW_RES_SKY_UNIT);
+    glUniform1i(glGetUniformLocation(program.id, "uHistoryEmission"), HISTORY_EMISSION_UNIT);
+    glUniform1i(glGetUniformLocation(program.id, "uHistorySky"), HISTORY_SKY_UNIT);
+    glUseProgram(0);
+
+    unsigned int sceneBlock = glGetUniformBlockIndex(program.id, "BlackHoleBlock");
+    if (sceneBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program.id, sceneBlock, SCENE_BINDING);
+    }
+}
+
+void GpuRayTracer::addVariant(const Geodesic::MarchParams& params) {
+    if (findVariant(variants, params)) return;
+
+    std::string defines = "#define MAX_STEPS " + std::to_string(params.maxSteps) + "\n"
+                        + "#define MAX_DIST " + glslFloat(params.maxDistance) + "\n"
+                        + "#define STEP_FACTOR " + glslFloat(params.stepFactor) + "\n"
+                        + "#define BENDING_STRENGTH " + glslFloat(params.bendingStrength) + "\n"
+                        + "#define INTEGRATOR " + std::to_string(static_cast<int>(params.integrator)) + "\n"
+                        + "#define TOLERANCE " + glslFloat(params.tolerance) + "\n"
+                        + "#define BOUNDING_SPHERES " + (params.boundingSpheres ? "true" : "false") + "\n";
+    variants.push_back({ params, buildProgram(defines) });
+    if (isComputeSupported()) {
+        computeVariants.push_back({ params, buildComputeProgram(defines) });
+    }
+}
+
+const GpuRayTracer::ShaderProgram* GpuRayTracer::findVariant(const VariantList& list, const Geodesic::MarchParams& params) {
+    for (const auto& variant : list) {
+        if (variant.first == params) return &variant.second;
+    }
+    return nullptr;
+}
+
+void GpuRayTracer::setupSceneBuffer() {
+    glGenBuffers(1, &sceneUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUBO);
+    glBufferData(GL_UNIFORM_BUFFER, SCENE_HEADER_SIZE + maxBlackHoles * sizeof(BlackHoleStd140), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_BINDING, sceneUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Nothing uploaded yet
+    uploadedWorld = nullptr;
+}
+
+void GpuRayTracer::uploadScene(const World& world) {
+    if (uploadedWorld == &world && uploadedRevision == world.getRevision()) {
+        return;
+    }
+
+    std::vector<Geodesic::BlackHoleData> blackHoles = Geodesic::gatherBlackHoles(world);
+    if ((int)blackHoles.size() > maxBlackHoles) {
+        std::cerr << "GpuRayTracer: scene has " << blackHoles.size() << " black holes, only the first "
+                  << maxBlackHoles << " fit in the uniform block" << std::endl;
+        blackHoles.resize(maxBlackHoles);
+    }
+
+    // Header followed by the used part of the array; the rest of the block is never read
+    std::vector<unsigned char> data(SCENE_HEADER_SIZE + blackHoles.size() * sizeof(BlackHoleStd140), 0);
+    int numBlackHoles = (int)blackHoles.size();
+    std::memcpy(data.data(), &numBlackHoles, sizeof(numBlackHoles));
+    for (size_t i = 0; i < blackHoles.size(); ++i) {
+        const Geodesic::BlackHoleData& bh = blackHoles[i];
+        BlackHoleStd140 element = { bh.pos, bh.rs, bh.diskInner, bh.diskOuter, { 0.0f, 0.0f } };
+        std::memcpy(data.data() + SCENE_HEADER_SIZE + i * sizeof(BlackHoleStd140), &element, sizeof(element));
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size(), data.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    sceneBlackHoles = std::move(blackHoles);
+    uploadedWorld = &world;
+    uploadedRevision = world.getRevision();
+}
+
+void GpuRayTracer::uploadDeflectionTable(const std::shared_ptr<const DeflectionTable>& table) {
+    if (table == uploadedTable) return;
+    uploadedTable = table;
+    if (!table) return; // Keep the texture; it is simply not sampled
+
+    if (deflectionTexture == 0) {
+        glGenTextures(1, &deflectionTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, deflectionTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, DeflectionTable::IMPACT_SAMPLES, 2 * DeflectionTable::RADIUS_SAMPLES,
+                 0, GL_RG, GL_FLOAT, table->getData().data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GpuRayTracer::uploadSkyMap() {
+    if (skyMap == uploadedSkyMap) return;
+    uploadedSkyMap = skyMap;
+    if (!skyMap) return; // Keep the texture; it is simply not sampled
+
+    if (skyTexture == 0) {
+        glGenTextures(1, &skyTexture);
+    }
+    // Texels are already half precision, so RGB16F stores them exactly
+    glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexture);
+    for (int level = 0; level < skyMap->getLevelCount(); ++level) {
+        int size = skyMap->getLevelSize(level);
+        for (int face = 0; face < SkyMap::FACES; ++face) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT,
+                         skyMap->getLevel(level) + static_cast<size_t>(face) * size * size * 3);
+        }
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, skyMap->getLevelCount() - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Clamped per face like SkyMap::sample, so GL_TEXTURE_CUBE_MAP_SEAMLESS stays off
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+void GpuRayTracer::setSky(const Geodesic::SkyParams& params, std::shared_ptr<const SkyMap> map) {
+    if (params != skyParams || map != skyMap) {
+        accumulation.reset();
+        historyValid = false;
+    }
+    skyParams = params;
+    skyMap = std::move(map);
+}
+
+void GpuRayTracer::setBackend(Backend newBackend) {
+    // The backends' results differ in the last bits, so don't mix them in one average
+    if (newBackend != backend) {
+        accumulation.reset();
+        historyValid = false;
+    }
+    backend = newBackend;
+}
+
+void GpuRayTracer::setMarchScale(int scale) {
+    scale = scale >= 4 ? 4 : (scale >= 2 ? 2 : 1);
+    if (scale != marchScale) accumulation.reset();
+    marchScale = scale;
+}
+
+void GpuRayTracer::setTemporalReuse(bool enabled, int maxAge) {
+    if (enabled != temporalReuse) historyValid = false;
+    temporalReuse = enabled;
+    temporalMaxAge = maxAge > 1 ? maxAge : 1;
+}
+
+void GpuRayTracer::setDeflectionLut(bool enabled) {
+    // The table shades slightly differently from marching, so don't mix the two in one average
+    if (enabled != deflectionLut) {
+        accumulation.reset();
+        historyValid = false;
+    }
+    deflectionLut = enabled;
+}
+
+bool GpuRayTracer::render(const Camera& camera, const World& world, int width, int height, float time) {
     // Bind framebuffer if it exists
     if (fbo != 0) {
         // Resize if needed
         if (fboWidth != width || fboHeight != height) {
             resizeFramebuffer(width, height);
         }
+    }
+
+    // Progressive refinement blends into the float FBO texture, so it needs one
+    bool accumulate = progressive && fbo != 0;
+    if (!accumulate) {
+        accumulation.reset();
+    } else {
+        accumulation.update(camera, world, width, height, marchParams);
+        if (accumulation.isConverged()) {
+            // The HDR texture already holds the final image
+            if (postProcess.isStale()) {
+                postProcess.apply(quadVAO, fboTexture, width, height);
+            }
+            return false;
+        }
+    }
+
+    if (fbo != 0) {
         glBindFramebuffer(GL_FRAMEBUFFER, fbo);
         glViewport(0, 0, width, height);
     }
     
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (!accumulate) {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
     
-    glUseProgram(shaderProgram);
+    // The compute backend writes to the FBO texture as an image, so it needs one
+    bool useCompute = backend == Backend::Compute && isComputeSupported() && fbo != 0;
+    usingCompute = useCompute;
+
+    // Prefer a variant with the current parameters compiled in
+    const ShaderProgram* variant = findVariant(useCompute ? computeVariants : variants, marchParams);
+    const ShaderProgram& program = variant ? *variant : (useCompute ? computeProgram : genericProgram);
+    usingVariant = variant != nullptr;
+    const UniformLocations& uniforms = program.uniforms;
+
+    glUseProgram(program.id);
     glBindVertexArray(quadVAO);
     
-    glUniform3fv(glGetUniformLocation(shaderProgram, "cameraPos"), 1, glm::value_ptr(camera.position));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(camera.getViewMatrix()));
+    glUniform3fv(uniforms.cameraPos, 1, glm::value_ptr(camera.position));
+    glUniformMatrix4fv(uniforms.view, 1, GL_FALSE, glm::value_ptr(camera.getViewMatrix()));
     
     glm::mat4 projection = glm::perspective(glm::radians((float)camera.zoom), (float)width / (float)height, 0.1f, 100000.0f);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniformMatrix4fv(uniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+    // Angle a pixel at the centre of the view spans
+    float pixelAngle = 2.0f * std::tan(glm::radians((float)camera.zoom) * 0.5f) / height;
     
-    glUniform1f(glGetUniformLocation(shaderProgram, "time"), time);
+    glUniform1f(uniforms.time, time);
+    glUniform2f(uniforms.resolution, (float)width, (float)height);
+
+    glm::vec2 jitter = accumulate ? accumulation.getJitter() : glm::vec2(0.0f);
+    glUniform2f(uniforms.jitter, jitter.x, jitter.y);
+
+    // --- Ray Parameters ---
+    glUniform1i(uniforms.maxSteps, marchParams.maxSteps);
+    glUniform1f(uniforms.maxDistance, marchParams.maxDistance);
+    glUniform1f(uniforms.stepFactor, marchParams.stepFactor);
+    glUniform1f(uniforms.bendingStrength, marchParams.bendingStrength);
+    glUniform1i(uniforms.integrator, static_cast<int>(marchParams.integrator));
+    glUniform1f(uniforms.tolerance, marchParams.tolerance);
+    glUniform1i(uniforms.boundingSpheres, marchParams.boundingSpheres ? 1 : 0);
     
     // --- World Objects ---
-    int numBlackHoles = 0;
-    for (const auto& obj : world.objects) {
-        if (auto bh = std::dynamic_pointer_cast<BlackHole>(obj)) {
-            if (numBlackHoles < 4) {
-                std::string base = "uBlackHoles[" + std::to_string(numBlackHoles) + "]";
-                glUniform3fv(glGetUniformLocation(shaderProgram, (base + ".pos").c_str()), 1, glm::value_ptr(bh->position));
-                glUniform1f(glGetUniformLocation(shaderProgram, (base + ".rs").c_str()), bh->rs);
-                glUniform1f(glGetUniformLocation(shaderProgram, (base + ".diskInner").c_str()), bh->diskInner);
-                glUniform1f(glGetUniformLocation(shaderProgram, (base + ".diskOuter").c_str()), bh->diskOuter);
-                numBlackHoles++;
-            }
-        }
+    bool sceneChanged = uploadedWorld != &world || uploadedRevision != world.getRevision();
+    uploadScene(world);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_BINDING, sceneUBO);
+
+    // --- Sky ---
+    uploadSkyMap();
+    glUniform1f(uniforms.starDensity, skyParams.starDensity);
+    glUniform1f(uniforms.nebulaIntensity, skyParams.nebulaIntensity);
+    glUniform1i(uniforms.useSkyMap, skyMap ? 1 : 0);
+    if (skyMap) {
+        glUniform1f(uniforms.skyLod, skyMap->lodForPixel(pixelAngle));
+        glActiveTexture(GL_TEXTURE0 + SKY_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // --- Deflection Table ---
+    std::shared_ptr<const DeflectionTable> table;
+    if (deflectionLut && sceneBlackHoles.size() == 1) {
+        table = deflectionCache.get(sceneBlackHoles[0].rs, marchParams);
+    }
+    uploadDeflectionTable(table);
+    usingDeflectionLut = table != nullptr;
+    glUniform1i(uniforms.useDeflectionTable, usingDeflectionLut ? 1 : 0);
+    if (table) {
+        float rs = table->getRs();
+        glUniform2f(uniforms.deflectionLogRange, std::log(1.0f + Geodesic::ESCAPE_RADIUS / rs),
+                    std::log(Geodesic::ESCAPE_RADIUS / rs));
+        glActiveTexture(GL_TEXTURE0 + DEFLECTION_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, deflectionTexture);
+        glActiveTexture(GL_TEXTURE0);
     }
-    glUniform1i(glGetUniformLocation(shaderProgram, "uNumBlackHoles"), numBlackHoles);
     
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    // Collect the query issued two frames ago before reusing it; it has normally finished by now
+    if (queryPending[queryIndex]) {
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(timerQueries[queryIndex], GL_QUERY_RESULT, &elapsedNs);
+        lastRenderMs = (float)(elapsedNs / 1.0e6);
+        queryPending[queryIndex] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timerQueries[queryIndex]);
+
+    // --- Reduced Resolution ---
+    // Needs the FBO to return to after the reduced-resolution pass
+    int scale = fbo != 0 && !useCompute ? marchScale : 1;
+    glUniform1i(uniforms.pass, scale > 1 ? PASS_UPSAMPLE : PASS_FULL);
+    if (scale > 1) {
+        int lowWidth = (width + scale - 1) / scale;
+        int lowHeight = (height + scale - 1) / scale;
+        if (lowWidth != lowResWidth || lowHeight != lowResHeight) {
+            setupLowResTargets(lowWidth, lowHeight);
+        }
+
+        // Same jitter in screen space, so the upsample can ignore it
+        glBindFramebuffer(GL_FRAMEBUFFER, lowResFbo);
+        glViewport(0, 0, lowWidth, lowHeight);
+        glUniform1i(uniforms.pass, PASS_LOW_RES);
+        glUniform2f(uniforms.resolution, (float)lowWidth, (float)lowHeight);
+        glUniform2f(uniforms.jitter, jitter.x * lowWidth / width, jitter.y * lowHeight / height);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+        glUniform1i(uniforms.pass, PASS_UPSAMPLE);
+        glUniform2f(uniforms.resolution, (float)width, (float)height);
+        glUniform2f(uniforms.jitter, jitter.x, jitter.y);
+        float lowResPixelAngle = pixelAngle * height / lowHeight;
+        glUniform1f(uniforms.upsampleMinCos, std::cos(std::min(UPSAMPLE_EDGE_PIXELS * lowResPixelAngle, 3.14159265f)));
+        glActiveTexture(GL_TEXTURE0 + LOW_RES_EMISSION_UNIT);
+        glBindTexture(GL_TEXTURE_2D, lowResTextures[0]);
+        glActiveTexture(GL_TEXTURE0 + LOW_RES_SKY_UNIT);
+        glBindTexture(GL_TEXTURE_2D, lowResTextures[1]);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // --- Temporal Reuse ---
+    // The history holds unjittered results only, so it is read and written on
+    // the first sample of a view and left alone while later ones accumulate
+    bool writeHistory = temporalReuse && fbo != 0 && !useCompute && (!accumulate || accumulation.getSampleCount() == 0);
+    bool reuseHistory = false;
+    if (writeHistory) {
+        if (width != historyWidth || height != historyHeight) {
+            setupHistory(width, height);
+        }
+        reuseHistory = historyValid && !sceneChanged && marchParams == historyParams;
+        if (reuseHistory) {
+            int previous = historySlot ^ 1;
+            glUniformMatrix4fv(uniforms.prevViewProjection, 1, GL_FALSE, glm::value_ptr(historyViewProjection));
+            glUniform3fv(uniforms.prevCameraPos, 1, glm::value_ptr(historyCameraPos));
+            glUniform1i(uniforms.maxAge, temporalMaxAge);
+            glUniform1f(uniforms.reprojectMinCos, std::cos(std::min(UPSAMPLE_EDGE_PIXELS * pixelAngle, 3.14159265f)));
+            glUniform1f(uniforms.reprojectMaxError, REPROJECT_MAX_ERROR_PIXELS * pixelAngle);
+            glActiveTexture(GL_TEXTURE0 + HISTORY_EMISSION_UNIT);
+            glBindTexture(GL_TEXTURE_2D, historyTextures[previous][0]);
+            glActiveTexture(GL_TEXTURE0 + HISTORY_SKY_UNIT);
+            glBindTexture(GL_TEXTURE_2D, historyTextures[previous][1]);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, historyTextures[historySlot][0], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, historyTextures[historySlot][1], 0);
+        const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, drawBuffers);
+    }
+    glUniform1i(uniforms.temporal, reuseHistory ? 1 : 0);
+
+    if (accumulate && !useCompute) {
+        // Running average: new = sample * w + old * (1 - w), with w = 1 / (n + 1)
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        glBlendColor(0.0f, 0.0f, 0.0f, accumulation.getBlendWeight());
+        // The history is replaced, not averaged
+        glDisablei(GL_BLEND, 1);
+        glDisablei(GL_BLEND, 2);
+    }
+
+    if (useCompute) {
+        dispatchCompute(uniforms, width, height, accumulate ? accumulation.getBlendWeight() : 1.0f);
+        // Nothing was written to the history meanwhile
+        historyValid = false;
+    } else {
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
     glBindVertexArray(0);
+
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[queryIndex] = true;
+    queryIndex ^= 1;
+
+    if (accumulate) {
+        glDisable(GL_BLEND);
+        accumulation.addSample();
+    }
+
+    if (writeHistory) {
+        // Back to the color attachment alone, so clears leave the history be
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        historyViewProjection = projection * camera.getViewMatrix();
+        historyCameraPos = camera.position;
+        historyParams = marchParams;
+        historyValid = true;
+        historySlot ^= 1;
+    }
     
-    // Unbind framebuffer
+    // Exposure, bloom and tonemapping into the texture on screen; leaves the framebuffer unbound
     if (fbo != 0) {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        postProcess.apply(quadVAO, fboTexture, width, height);
     }
+    return true;
+}
+
+void GpuRayTracer::dispatchCompute(const UniformLocations& uniforms, int width, int height, float blendWeight) {
+    glUniform1f(uniforms.blendWeight, blendWeight);
+    glBindImageTexture(OUTPUT_IMAGE_UNIT, fboTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA16F);
+
+    // The groups take their pixels from one counter, restarted every frame
+    const GLuint firstPixel = 0;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WORK_QUEUE_BINDING, workQueueBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(firstPixel), &firstPixel);
+
+    // Small frames need fewer groups than the GPU holds
+    int tiles = ((width + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE) * ((height + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE);
+    glDispatchCompute(std::min(tiles, COMPUTE_GROUPS), 1, 1);
+
+    // PostProcess samples the image, the next sample reads it back and the
+    // next frame resets the counter
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
 }
 
 void GpuRayTracer::initFramebuffer(int width, int height) {
@@ -164,12 +732,17 @@ void GpuRayTracer::initFramebuffer(int width, int height) {
     glGenFramebuffers(1, &fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     
-    // Create texture for color attachment
+    // Create texture for color attachment. Half float keeps the disk's glow
+    // above 1 for PostProcess, and still has bits enough below the display's
+    // 8 to average progressive samples in place without banding
     glGenTextures(1, &fboTexture);
     glBindTexture(GL_TEXTURE_2D, fboTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The bloom filters tap past the edges
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fboTexture, 0);
     
     // Create renderbuffer for depth/stencil (optional, but good practice)
@@ -186,6 +759,71 @@ void GpuRayTracer::initFramebuffer(int width, int height) {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void GpuRayTracer::setupLowResTargets(int width, int height) {
+    cleanupLowResTargets();
+
+    lowResWidth = width;
+    lowResHeight = height;
+
+    glGenFramebuffers(1, &lowResFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, lowResFbo);
+
+    glGenTextures(2, lowResTextures);
+    for (int i = 0; i < 2; ++i) {
+        createRayResultTexture(lowResTextures[i], RAY_RESULT_FORMATS[i], width, height);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, lowResTextures[i], 0);
+    }
+    // Only the RayResult outputs; FragColor is dropped
+    const GLenum drawBuffers[3] = { GL_NONE, GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(3, drawBuffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::FRAMEBUFFER:: Reduced-resolution framebuffer is not complete!" << std::endl;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void GpuRayTracer::cleanupLowResTargets() {
+    if (lowResFbo != 0) {
+        glDeleteFramebuffers(1, &lowResFbo);
+        lowResFbo = 0;
+    }
+    if (lowResTextures[0] != 0) {
+        glDeleteTextures(2, lowResTextures);
+        lowResTextures[0] = lowResTextures[1] = 0;
+    }
+    lowResWidth = 0;
+    lowResHeight = 0;
+}
+
+void GpuRayTracer::setupHistory(int width, int height) {
+    cleanupHistory();
+
+    historyWidth = width;
+    historyHeight = height;
+    for (auto& slot : historyTextures) {
+        glGenTextures(2, slot);
+        for (int i = 0; i < 2; ++i) {
+            createRayResultTexture(slot[i], RAY_RESULT_FORMATS[i], width, height);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GpuRayTracer::cleanupHistory() {
+    for (auto& slot : historyTextures) {
+        if (slot[0] != 0) {
+            glDeleteTextures(2, slot);
+            slot[0] = slot[1] = 0;
+        }
+    }
+    historyWidth = 0;
+    historyHeight = 0;
+    historyValid = false;
+}
+
 void GpuRayTracer::resizeFramebuffer(int width, int height) {
     if (width <= 0 || height <= 0) return;
     initFramebuffer(width, height);
@@ -207,18 +845,17 @@ void GpuRayTracer::cleanupFramebuffer() {
 }
 
 void GpuRayTracer::setMaxSteps(int steps) {
-    glUseProgram(shaderProgram);
-    // Note: This would require modifying the shader to use a uniform instead of #define
-    // For now, this is a placeholder - we'd need to update the shader
+    marchParams.maxSteps = steps;
 }
 
 void GpuRayTracer::setMaxDistance(float distance) {
-    glUseProgram(shaderProgram);
-    // Similar to above - placeholder for future shader updates
+    marchParams.maxDistance = distance;
+}
+
+void GpuRayTracer::setStepFactor(float factor) {
+    marchParams.stepFactor = factor;
 }
 
 void GpuRayTracer::setBendingStrength(float strength) {
-    glUseProgram(shaderProgram);
-    // This one we can implement since bending strength is already in the shader logic
-    // We'd need to pass it as a uniform
+    marchParams.bendingStrength = strength;
 }
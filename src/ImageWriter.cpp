@@ -0,0 +1,408 @@
+#include "ImageWriter.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <glm/gtc/packing.hpp>
+#include "Deflate.hpp"
+
+namespace {
+
+// Rows of EXR pixel data per ZIP-compressed chunk, fixed by the format
+constexpr int EXR_ZIP_ROWS = 16;
+
+bool endsWith(const std::string& text, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+uint32_t quantize(float value, float maxValue) {
+    return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * maxValue + 0.5f);
+}
+
+// Top row first
+const float* rowFromTop(const std::vector<float>& pixels, int width, int height, int row) {
+    return pixels.data() + static_cast<size_t>(height - 1 - row) * width * 3;
+}
+
+void putText(std::vector<unsigned char>& out, const std::string& text) {
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+void putBigEndian32(std::vector<unsigned char>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<unsigned char>(value >> shift));
+}
+
+template <typename T>
+void putLittleEndian(std::vector<unsigned char>& out, T value) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+void patchLittleEndian(std::vector<unsigned char>& out, size_t at, T value) {
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+// --- PNG ---
+
+uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+        return entries;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putPngChunk(std::vector<unsigned char>& out, const char type[4], const unsigned char* data, size_t size) {
+    putBigEndian32(out, static_cast<uint32_t>(size));
+    size_t typeAt = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (size > 0) out.insert(out.end(), data, data + size);
+    putBigEndian32(out, crc32(out.data() + typeAt, size + 4));
+}
+
+unsigned char paeth(int left, int up, int upLeft) {
+    int p = left + up - upLeft;
+    int pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - upLeft);
+    if (pa <= pb && pa <= pc) return static_cast<unsigned char>(left);
+    return static_cast<unsigned char>(pb <= pc ? up : upLeft);
+}
+
+// Filters row into out (after its filter type byte) with whichever of the five
+// filters leaves the smallest sum of signed bytes, the usual cheap stand-in for
+// compressing best
+void filterPngRow(const unsigned char* row, const unsigned char* previous, size_t rowBytes, int pixelBytes,
+                  unsigned char* out) {
+    static thread_local std::vector<unsigned char> trial;
+    trial.resize(rowBytes);
+    uint64_t bestCost = UINT64_MAX;
+    for (int filter = 0; filter < 5; ++filter) {
+        uint64_t cost = 0;
+        for (size_t i = 0; i < rowBytes; ++i) {
+            int left = i >= static_cast<size_t>(pixelBytes) ? row[i - pixelBytes] : 0;
+            int up = previous ? previous[i] : 0;
+            int upLeft = previous && i >= static_cast<size_t>(pixelBytes) ? previous[i - pixelBytes] : 0;
+            int predicted = 0;
+            switch (filter) {
+            case 1: predicted = left; break;
+            case 2: predicted = up; break;
+            case 3: predicted = (left + up) / 2; break;
+            case 4: predicted = paeth(left, up, upLeft); break;
+            }
+            unsigned char value = static_cast<unsigned char>(row[i] - predicted);
+            trial[i] = value;
+            cost += value < 128 ? value : 256 - value;
+        }
+        if (cost < bestCost) {
+            bestCost = cost;
+            out[0] = static_cast<unsigned char>(filter);
+            std::memcpy(out + 1, trial.data(), rowBytes);
+        }
+    }
+}
+
+void encodePNG(const std::vector<float>& pixels, int width, int height, int bitDepth,
+               std::vector<unsigned char>& out) {
+    int sampleBytes = bitDepth == 16 ? 2 : 1;
+    int pixelBytes = 3 * sampleBytes;
+    size_t rowBytes = static_cast<size_t>(width) * pixelBytes;
+    float maxValue = bitDepth == 16 ? 65535.0f : 255.0f;
+
+    // Samples are big-endian; each filtered row starts with its filter type
+    static thread_local std::vector<unsigned char> rows[2];
+    static thread_local std::vector<unsigned char> filtered;
+    static thread_local std::vector<unsigned char> compressed;
+    rows[0].resize(rowBytes);
+    rows[1].resize(rowBytes);
+    filtered.resize((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        const float* src = rowFromTop(pixels, width, height, y);
+        unsigned char* row = rows[y & 1].data();
+        for (int i = 0; i < width * 3; ++i) {
+            uint32_t value = quantize(src[i], maxValue);
+            if (sampleBytes == 2) {
+                row[i * 2] = static_cast<unsigned char>(value >> 8);
+                row[i * 2 + 1] = static_cast<unsigned char>(value);
+            } else {
+                row[i] = static_cast<unsigned char>(value);
+            }
+        }
+        const unsigned char* previous = y > 0 ? rows[(y - 1) & 1].data() : nullptr;
+        filterPngRow(row, previous, rowBytes, pixelBytes, &filtered[(rowBytes + 1) * y]);
+    }
+    compressed.clear();
+    Deflate::compress(filtered.data(), filtered.size(), compressed);
+
+    static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    out.assign(SIGNATURE, SIGNATURE + 8);
+    std::vector<unsigned char> header;
+    putBigEndian32(header, static_cast<uint32_t>(width));
+    putBigEndian32(header, static_cast<uint32_t>(height));
+    header.push_back(static_cast<unsigned char>(bitDepth == 16 ? 16 : 8));
+    header.push_back(2); // Truecolour
+    header.push_back(0); // Deflate
+    header.push_back(0); // Adaptive filtering
+    header.push_back(0); // Not interlaced
+    putPngChunk(out, "IHDR", header.data(), header.size());
+    putPngChunk(out, "IDAT", compressed.data(), compressed.size());
+    putPngChunk(out, "IEND", nullptr, 0);
+}
+
+// --- OpenEXR ---
+
+void putExrAttribute(std::vector<unsigned char>& out, const char* name, const char* type,
+                     const std::vector<unsigned char>& value) {
+    out.insert(out.end(), name, name + std::strlen(name) + 1);
+    out.insert(out.end(), type, type + std::strlen(type) + 1);
+    putLittleEndian<int32_t>(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+// Scanline image with B, G and R half channels (channels go in name order)
+void encodeEXR(const std::vector<float>& pixels, int width, int height, std::vector<unsigned char>& out) {
+    out.clear();
+    putLittleEndian<uint32_t>(out, 20000630); // Magic number
+    putLittleEndian<uint32_t>(out, 2);        // Version 2, single-part scanline file
+
+    std::vector<unsigned char> channels;
+    for (const char* name : { "B", "G", "R" }) {
+        channels.push_back(static_cast<unsigned char>(name[0]));
+        channels.push_back(0);
+        putLittleEndian<int32_t>(channels, 1); // HALF
+        putLittleEndian<uint32_t>(channels, 0); // pLinear and reserved
+        putLittleEndian<int32_t>(channels, 1); // x sampling
+        putLittleEndian<int32_t>(channels, 1); // y sampling
+    }
+    channels.push_back(0);
+    std::vector<unsigned char> window;
+    for (int32_t value : { 0, 0, width - 1, height - 1 }) putLittleEndian<int32_t>(window, value);
+    std::vector<unsigned char> one;
+    putLittleEndian<float>(one, 1.0f);
+    std::vector<unsigned char> origin(8, 0);
+
+    putExrAttribute(out, "channels", "chlist", channels);
+    putExrAttribute(out, "compression", "compression", { 3 }); // ZIP
+    putExrAttribute(out, "dataWindow", "box2i", window);
+    putExrAttribute(out, "displayWindow", "box2i", window);
+    putExrAttribute(out, "lineOrder", "lineOrder", { 0 }); // Increasing y, top row first
+    putExrAttribute(out, "pixelAspectRatio", "float", one);
+    putExrAttribute(out, "screenWindowCenter", "v2f", origin);
+    putExrAttribute(out, "screenWindowWidth", "float", one);
+    out.push_back(0);
+
+    int chunks = (height + EXR_ZIP_ROWS - 1) / EXR_ZIP_ROWS;
+    size_t offsetTable = out.size();
+    out.resize(out.size() + chunks * sizeof(uint64_t));
+
+    static thread_local std::vector<unsigned char> raw;
+    static thread_local std::vector<unsigned char> predicted;
+    static thread_local std::vector<unsigned char> compressed;
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        int firstRow = chunk * EXR_ZIP_ROWS;
+        int rows = std::min(EXR_ZIP_ROWS, height - firstRow);
+
+        // Each row holds all its B halves, then G, then R
+        raw.resize(static_cast<size_t>(rows) * width * 3 * sizeof(uint16_t));
+        unsigned char* dst = raw.data();
+        for (int row = 0; row < rows; ++row) {
+            const float* src = rowFromTop(pixels, width, height, firstRow + row);
+            for (int channel = 2; channel >= 0; --channel) {
+                for (int x = 0; x < width; ++x) {
+                    uint16_t half = glm::packHalf1x16(src[x * 3 + channel]);
+                    std::memcpy(dst, &half, sizeof(half));
+                    dst += sizeof(half);
+                }
+            }
+        }
+
+        // ZIP compression first splits the bytes at even and odd offsets
+        // (the halves' low and high bytes) and delta-codes the result
+        size_t size = raw.size();
+        predicted.resize(size);
+        size_t half = (size + 1) / 2;
+        for (size_t i = 0; i < size; ++i) {
+            predicted[(i & 1) ? half + i / 2 : i / 2] = raw[i];
+        }
+        for (size_t i = size; i-- > 1;) {
+            predicted[i] = static_cast<unsigned char>(predicted[i] - predicted[i - 1] + 128);
+        }
+        compressed.clear();
+        Deflate::compress(predicted.data(), size, compressed);
+
+        patchLittleEndian<uint64_t>(out, offsetTable + chunk * sizeof(uint64_t), out.size());
+        putLittleEndian<int32_t>(out, firstRow);
+        // Chunks that didn't shrink are stored as they are; readers tell by the size
+        const std::vector<unsigned char>& data = compressed.size() < size ? compressed : raw;
+        putLittleEndian<int32_t>(out, static_cast<int32_t>(data.size()));
+        out.insert(out.end(), data.begin(), data.end());
+    }
+}
+
+// --- Raw video frames ---
+
+// 8-bit samples as bytes, 16-bit ones little-endian
+void putSample(unsigned char*& dst, uint32_t value, int bitDepth) {
+    if (bitDepth == 16) {
+        *dst++ = static_cast<unsigned char>(value);
+        *dst++ = static_cast<unsigned char>(value >> 8);
+    } else {
+        *dst++ = static_cast<unsigned char>(value);
+    }
+}
+
+void encodeRGB(const std::vector<float>& pixels, int width, int height, int bitDepth,
+               std::vector<unsigned char>& out) {
+    int sampleBytes = bitDepth == 16 ? 2 : 1;
+    float maxValue = bitDepth == 16 ? 65535.0f : 255.0f;
+    out.resize(static_cast<size_t>(width) * height * 3 * sampleBytes);
+    unsigned char* dst = out.data();
+    for (int y = 0; y < height; ++y) {
+        const float* src = rowFromTop(pixels, width, height, y);
+        for (int i = 0; i < width * 3; ++i) putSample(dst, quantize(src[i], maxValue), bitDepth);
+    }
+}
+
+// Planar Y, then Cb and Cr at half resolution in both directions (rounded up),
+// each chroma sample from the average colour of its 2x2 block. Video range:
+// Y in [16, 235] and chroma in [16, 240], shifted up 8 bits at 16 bits.
+void encodeYUV(const std::vector<float>& pixels, int width, int height, int bitDepth,
+               std::vector<unsigned char>& out) {
+    constexpr float KR = 0.2126f, KB = 0.0722f, KG = 1.0f - KR - KB;
+    int sampleBytes = bitDepth == 16 ? 2 : 1;
+    float scale = bitDepth == 16 ? 256.0f : 1.0f;
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    size_t lumaSize = static_cast<size_t>(width) * height * sampleBytes;
+    size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight * sampleBytes;
+    out.resize(lumaSize + 2 * chromaSize);
+
+    auto sample = [&](float value) { return static_cast<uint32_t>(value * scale + 0.5f); };
+    auto clamped = [&](int x, int y, int channel) {
+        return std::clamp(rowFromTop(pixels, width, height, y)[x * 3 + channel], 0.0f, 1.0f);
+    };
+
+    unsigned char* luma = out.data();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float value = KR * clamped(x, y, 0) + KG * clamped(x, y, 1) + KB * clamped(x, y, 2);
+            putSample(luma, sample(16.0f + 219.0f * value), bitDepth);
+        }
+    }
+
+    unsigned char* cb = out.data() + lumaSize;
+    unsigned char* cr = cb + chromaSize;
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            float rgb[3] = { 0.0f, 0.0f, 0.0f };
+            int count = 0;
+            for (int y = cy * 2; y < std::min(cy * 2 + 2, height); ++y) {
+                for (int x = cx * 2; x < std::min(cx * 2 + 2, width); ++x) {
+                    for (int c = 0; c < 3; ++c) rgb[c] += clamped(x, y, c);
+                    ++count;
+                }
+            }
+            for (float& c : rgb) c /= count;
+            float value = KR * rgb[0] + KG * rgb[1] + KB * rgb[2];
+            putSample(cb, sample(128.0f + 224.0f * (rgb[2] - value) / (2.0f * (1.0f - KB))), bitDepth);
+            putSample(cr, sample(128.0f + 224.0f * (rgb[0] - value) / (2.0f * (1.0f - KR))), bitDepth);
+        }
+    }
+}
+
+} // namespace
+
+namespace ImageWriter {
+
+Format formatFor(const std::string& path) {
+    if (endsWith(path, ".pfm")) return Format::PFM;
+    if (endsWith(path, ".png")) return Format::PNG;
+    if (endsWith(path, ".exr")) return Format::EXR;
+    if (endsWith(path, ".yuv")) return Format::YUV;
+    if (endsWith(path, ".rgb")) return Format::RGB;
+    return Format::PPM;
+}
+
+const char* formatName(Format format) {
+    switch (format) {
+    case Format::PPM: return "PPM";
+    case Format::PFM: return "PFM";
+    case Format::PNG: return "PNG";
+    case Format::EXR: return "EXR";
+    case Format::YUV: return "YUV 4:2:0";
+    case Format::RGB: return "raw RGB";
+    }
+    return "unknown";
+}
+
+void encode(Format format, const std::vector<float>& pixels, int width, int height, int bitDepth,
+            std::vector<unsigned char>& out) {
+    switch (format) {
+    case Format::PPM: {
+        out.clear();
+        putText(out, "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n");
+        // PPM rows run top to bottom
+        size_t header = out.size();
+        out.resize(header + static_cast<size_t>(width) * height * 3);
+        unsigned char* dst = out.data() + header;
+        for (int y = 0; y < height; ++y) {
+            const float* src = rowFromTop(pixels, width, height, y);
+            for (int i = 0; i < width * 3; ++i) *dst++ = static_cast<unsigned char>(quantize(src[i], 255.0f));
+        }
+        break;
+    }
+    case Format::PFM: {
+        out.clear();
+        // Negative scale marks little-endian data; PFM rows already run bottom to top
+        putText(out, "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n");
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(pixels.data());
+        out.insert(out.end(), src, src + static_cast<size_t>(width) * height * 3 * sizeof(float));
+        break;
+    }
+    case Format::PNG: encodePNG(pixels, width, height, bitDepth, out); break;
+    case Format::EXR: encodeEXR(pixels, width, height, out); break;
+    case Format::YUV: encodeYUV(pixels, width, height, bitDepth, out); break;
+    case Format::RGB: encodeRGB(pixels, width, height, bitDepth, out); break;
+    }
+}
+
+bool writeFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+bool writePPM(const std::string& path, const std::vector<float>& pixels, int width, int height) {
+    std::vector<unsigned char> bytes;
+    encode(Format::PPM, pixels, width, height, 8, bytes);
+    return writeFile(path, bytes);
+}
+
+bool writePFM(const std::string& path, const std::vector<float>& pixels, int width, int height) {
+    std::vector<unsigned char> bytes;
+    encode(Format::PFM, pixels, width, height, 8, bytes);
+    return writeFile(path, bytes);
+}
+
+bool write(const std::string& path, const std::vector<float>& pixels, int width, int height, int bitDepth) {
+    std::vector<unsigned char> bytes;
+    encode(formatFor(path), pixels, width, height, bitDepth, bytes);
+    return writeFile(path, bytes);
+}
+
+} // namespace ImageWriter
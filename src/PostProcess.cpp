@@ -0,0 +1,223 @@
+#include "PostProcess.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+// uPass in postprocess.frag
+constexpr int PASS_THRESHOLD = 0;
+constexpr int PASS_DOWNSAMPLE = 1;
+constexpr int PASS_UPSAMPLE = 2;
+constexpr int PASS_COMPOSITE = 3;
+
+constexpr int SOURCE_UNIT = 0;
+constexpr int BLOOM_UNIT = 1;
+
+// Smaller levels add nothing a tent filter over the one above would not
+constexpr int MIN_BLOOM_SIZE = 8;
+
+unsigned int compileShader(GLenum type, const std::string& source, const char* name) {
+    const char* code = source.c_str();
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::POST_PROCESS::" << name << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+void createTarget(unsigned int fbo, unsigned int texture, GLenum format, int width, int height) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    // Bilinear taps do half of the filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR::FRAMEBUFFER:: Post-processing framebuffer is not complete!" << std::endl;
+    }
+}
+
+} // namespace
+
+PostProcess::~PostProcess() {
+    cleanupTargets();
+    glDeleteQueries(2, timerQueries);
+    glDeleteProgram(program);
+}
+
+void PostProcess::init(const std::string& vertexSource, const std::string& fragmentSource) {
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, "VERTEX");
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, "FRAGMENT");
+
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "ERROR::POST_PROCESS::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    uniforms.pass = glGetUniformLocation(program, "uPass");
+    uniforms.bloomThreshold = glGetUniformLocation(program, "uBloomThreshold");
+    uniforms.bloomKnee = glGetUniformLocation(program, "uBloomKnee");
+    uniforms.bloomStrength = glGetUniformLocation(program, "uBloomStrength");
+    uniforms.exposure = glGetUniformLocation(program, "uExposure");
+    uniforms.tonemap = glGetUniformLocation(program, "uTonemap");
+    uniforms.bloom = glGetUniformLocation(program, "uBloom");
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uSource"), SOURCE_UNIT);
+    glUniform1i(glGetUniformLocation(program, "uBloomTexture"), BLOOM_UNIT);
+    glUseProgram(0);
+
+    glGenQueries(2, timerQueries);
+}
+
+void PostProcess::setSettings(const Settings& newSettings) {
+    if (newSettings == settings) return;
+    settings = newSettings;
+    stale = true;
+}
+
+void PostProcess::apply(unsigned int quadVAO, unsigned int hdrTexture, int newWidth, int newHeight) {
+    if (newWidth != width || newHeight != height) {
+        setupTargets(newWidth, newHeight);
+    }
+
+    if (queryPending[queryIndex]) {
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(timerQueries[queryIndex], GL_QUERY_RESULT, &elapsedNs);
+        lastMs = (float)(elapsedNs / 1.0e6);
+        queryPending[queryIndex] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timerQueries[queryIndex]);
+
+    glUseProgram(program);
+    glBindVertexArray(quadVAO);
+
+    bool useBloom = settings.bloomStrength > 0.0f && settings.bloomLevels > 0 && bloomLevelCount > 0;
+    if (useBloom) {
+        bloom(hdrTexture);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFbo);
+    glViewport(0, 0, width, height);
+    glUniform1i(uniforms.pass, PASS_COMPOSITE);
+    glUniform1f(uniforms.exposure, std::exp2(settings.exposure));
+    glUniform1i(uniforms.tonemap, static_cast<int>(settings.tonemap));
+    glUniform1i(uniforms.bloom, useBloom ? 1 : 0);
+    glUniform1f(uniforms.bloomStrength, settings.bloomStrength);
+    glActiveTexture(GL_TEXTURE0 + SOURCE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, hdrTexture);
+    if (useBloom) {
+        glActiveTexture(GL_TEXTURE0 + BLOOM_UNIT);
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[0]);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[queryIndex] = true;
+    queryIndex ^= 1;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    stale = false;
+}
+
+void PostProcess::bloom(unsigned int hdrTexture) {
+    int levels = std::min(settings.bloomLevels, bloomLevelCount);
+    glUniform1f(uniforms.bloomThreshold, settings.bloomThreshold);
+    glUniform1f(uniforms.bloomKnee, std::max(settings.bloomKnee, 0.0f));
+
+    // Down: each level is filtered from the one above, the first from the image
+    glActiveTexture(GL_TEXTURE0 + SOURCE_UNIT);
+    for (int level = 0; level < levels; ++level) {
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFbos[level]);
+        glViewport(0, 0, bloomWidths[level], bloomHeights[level]);
+        glUniform1i(uniforms.pass, level == 0 ? PASS_THRESHOLD : PASS_DOWNSAMPLE);
+        glBindTexture(GL_TEXTURE_2D, level == 0 ? hdrTexture : bloomTextures[level - 1]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    // Up: each level gets the one below it added on, so level 0 ends up with all of them
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glUniform1i(uniforms.pass, PASS_UPSAMPLE);
+    for (int level = levels - 2; level >= 0; --level) {
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFbos[level]);
+        glViewport(0, 0, bloomWidths[level], bloomHeights[level]);
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[level + 1]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDisable(GL_BLEND);
+}
+
+void PostProcess::setupTargets(int newWidth, int newHeight) {
+    cleanupTargets();
+
+    width = newWidth;
+    height = newHeight;
+
+    glGenFramebuffers(1, &outputFbo);
+    glGenTextures(1, &outputTexture);
+    createTarget(outputFbo, outputTexture, GL_RGBA8, width, height);
+
+    // The glow is smooth and never negative, so the packed float format is plenty
+    bloomLevelCount = 0;
+    for (int level = 0; level < MAX_BLOOM_LEVELS; ++level) {
+        int levelWidth = width >> (level + 1);
+        int levelHeight = height >> (level + 1);
+        if (levelWidth < MIN_BLOOM_SIZE || levelHeight < MIN_BLOOM_SIZE) break;
+        bloomWidths[level] = levelWidth;
+        bloomHeights[level] = levelHeight;
+        glGenFramebuffers(1, &bloomFbos[level]);
+        glGenTextures(1, &bloomTextures[level]);
+        createTarget(bloomFbos[level], bloomTextures[level], GL_R11F_G11F_B10F, levelWidth, levelHeight);
+        ++bloomLevelCount;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PostProcess::cleanupTargets() {
+    if (outputFbo != 0) {
+        glDeleteFramebuffers(1, &outputFbo);
+        outputFbo = 0;
+    }
+    if (outputTexture != 0) {
+        glDeleteTextures(1, &outputTexture);
+        outputTexture = 0;
+    }
+    if (bloomLevelCount > 0) {
+        glDeleteFramebuffers(bloomLevelCount, bloomFbos);
+        glDeleteTextures(bloomLevelCount, bloomTextures);
+        std::fill(std::begin(bloomFbos), std::end(bloomFbos), 0u);
+        std::fill(std::begin(bloomTextures), std::end(bloomTextures), 0u);
+        bloomLevelCount = 0;
+    }
+    width = 0;
+    height = 0;
+}
@@ -0,0 +1,71 @@
+#include "ResolutionController.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float SMOOTHING = 0.2f;       // Weight of the newest sample in the moving average
+constexpr float OVER_BUDGET = 1.0f;     // Scale down above this fraction of the budget
+constexpr float UNDER_BUDGET = 0.9f;    // Scale up only if the larger frame still fits in this fraction
+constexpr float DOWN_MARGIN = 0.9f;     // Aim below the budget when scaling down
+constexpr int COOLDOWN_FRAMES = 10;
+
+} // namespace
+
+void ResolutionController::setScaleRange(float newMin, float newMax) {
+    minScale = std::clamp(newMin, SCALE_STEP, 1.0f);
+    maxScale = std::clamp(newMax, minScale, 1.0f);
+    scale = std::clamp(scale, minScale, maxScale);
+}
+
+void ResolutionController::reset() {
+    scale = maxScale;
+    smoothedMs = 0.0f;
+    hasSample = false;
+    cooldown = 0;
+    lastDecision = Decision::Hold;
+    lastDecisionMs = 0.0f;
+}
+
+float ResolutionController::update(float renderMs) {
+    smoothedMs = hasSample ? smoothedMs + (renderMs - smoothedMs) * SMOOTHING : renderMs;
+    hasSample = true;
+
+    if (cooldown > 0) {
+        --cooldown;
+        return scale;
+    }
+
+    float newScale = scale;
+    if (smoothedMs > targetMs * OVER_BUDGET) {
+        // Cost ~ scale^2: jump to the scale predicted to fit, rounded down to a step
+        float fit = scale * std::sqrt(targetMs * DOWN_MARGIN / smoothedMs);
+        newScale = std::floor(fit / SCALE_STEP + 1e-3f) * SCALE_STEP;
+        newScale = std::min(newScale, scale - SCALE_STEP);
+    } else {
+        float up = scale + SCALE_STEP;
+        float predictedMs = smoothedMs * (up / scale) * (up / scale);
+        if (predictedMs < targetMs * UNDER_BUDGET) {
+            newScale = up;
+        }
+    }
+    newScale = std::clamp(newScale, minScale, maxScale);
+
+    if (std::abs(newScale - scale) < SCALE_STEP * 0.5f) {
+        return scale;
+    }
+
+    lastDecision = newScale > scale ? Decision::ScaleUp : Decision::ScaleDown;
+    lastDecisionMs = smoothedMs;
+
+    // Carry the estimate over to the new resolution so the next decision isn't based on stale data
+    smoothedMs *= (newScale / scale) * (newScale / scale);
+    scale = newScale;
+    cooldown = COOLDOWN_FRAMES;
+    return scale;
+}
+
+glm::ivec2 ResolutionController::apply(int width, int height) const {
+    return glm::ivec2(std::max(1, (int)std::lround(width * scale)),
+                      std::max(1, (int)std::lround(height * scale)));
+}
@@ -0,0 +1,296 @@
+#include "SceneFile.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "World.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SceneFile {
+
+namespace {
+
+constexpr char MAGIC[8] = { 'B', 'H', 'S', 'C', 'E', 'N', 'E', '\0' };
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t COLUMN_ALIGNMENT = 64;
+
+// Black hole positions, masses, rs, disk inner, disk outer; object positions
+constexpr int NUM_COLUMNS = 6;
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t numBlackHoles;
+    uint64_t numObjects;
+    uint64_t columnOffsets[NUM_COLUMNS]; // From the start of the file
+};
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Positions are stored as packed float triples");
+static_assert(std::endian::native == std::endian::little, "Binary scenes are read and written as little-endian structs");
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+}
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return;
+        data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data) size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const unsigned char*>(mapped);
+                size = static_cast<size_t>(info.st_size);
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd); // The mapping keeps the file referenced
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<unsigned char*>(data), size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// Column sizes in bytes, in file order
+void columnSizes(uint64_t numBlackHoles, uint64_t numObjects, uint64_t sizes[NUM_COLUMNS]) {
+    sizes[0] = numBlackHoles * sizeof(glm::vec3);
+    for (int i = 1; i < 5; ++i) sizes[i] = numBlackHoles * sizeof(float);
+    sizes[5] = numObjects * sizeof(glm::vec3);
+}
+
+// Validates a binary scene held in memory and appends it to world; name is for messages
+bool parseBinary(const unsigned char* data, size_t size, const std::string& name, World& world) {
+    BinaryHeader header;
+    if (size < sizeof(header)) {
+        std::cerr << name << ": truncated scene header" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+        || header.headerSize != sizeof(header)) {
+        std::cerr << name << ": not a version " << VERSION << " binary scene" << std::endl;
+        return false;
+    }
+    // Also keeps the column sizes below from overflowing
+    if (header.numBlackHoles > size || header.numObjects > size) {
+        std::cerr << name << ": scene object counts exceed the file size" << std::endl;
+        return false;
+    }
+
+    uint64_t sizes[NUM_COLUMNS];
+    columnSizes(header.numBlackHoles, header.numObjects, sizes);
+    const unsigned char* columns[NUM_COLUMNS];
+    for (int i = 0; i < NUM_COLUMNS; ++i) {
+        uint64_t offset = header.columnOffsets[i];
+        bool inside = offset % COLUMN_ALIGNMENT == 0 && offset <= size && sizes[i] <= size - offset;
+        if (sizes[i] > 0 && !inside) {
+            std::cerr << name << ": scene column " << i << " lies outside the file" << std::endl;
+            return false;
+        }
+        columns[i] = sizes[i] > 0 ? data + offset : nullptr;
+    }
+
+    world.addBlackHoles(header.numBlackHoles,
+                        reinterpret_cast<const glm::vec3*>(columns[0]),
+                        reinterpret_cast<const float*>(columns[1]),
+                        reinterpret_cast<const float*>(columns[2]),
+                        reinterpret_cast<const float*>(columns[3]),
+                        reinterpret_cast<const float*>(columns[4]));
+    world.addObjects(header.numObjects, reinterpret_cast<const glm::vec3*>(columns[5]));
+    return true;
+}
+
+} // namespace
+
+bool readTextLine(std::istream& in, TextLine& line) {
+    std::string text;
+    while (std::getline(in, text)) {
+        ++line.number;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.resize(comment);
+
+        std::istringstream fields(text);
+        if (!(fields >> line.keyword)) continue; // Blank line
+
+        line.values.clear();
+        line.numeric = true;
+        std::string token;
+        while (fields >> token) {
+            char* end = nullptr;
+            line.values.push_back(std::strtof(token.c_str(), &end));
+            line.numeric = line.numeric && *end == '\0';
+        }
+        return true;
+    }
+    return false;
+}
+
+bool loadText(const std::string& path, World& world) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open scene " << path << std::endl;
+        return false;
+    }
+
+    TextLine line;
+    while (readTextLine(file, line)) {
+        const std::string& kind = line.keyword;
+        const std::vector<float>& values = line.values;
+        bool numeric = line.numeric;
+        if (kind == "blackhole" && numeric && (values.size() == 4 || values.size() == 6)) {
+            float diskInner = values.size() == 6 ? values[4] : 0.0f;
+            float diskOuter = values.size() == 6 ? values[5] : 0.0f;
+            world.add(BlackHole(glm::vec3(values[0], values[1], values[2]), values[3], diskInner, diskOuter));
+        } else if (kind == "object" && numeric && values.size() == 3) {
+            world.add(Object(glm::vec3(values[0], values[1], values[2])));
+        } else if (kind != "blackhole" && kind != "object") {
+            std::cerr << path << ":" << line.number << ": unknown object type " << kind << std::endl;
+            return false;
+        } else {
+            std::cerr << path << ":" << line.number << ": malformed " << kind << " line" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool saveText(const std::string& path, const World& world) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    // Enough digits for the floats to read back exactly
+    file << std::setprecision(9);
+    file << "# blackhole X Y Z MASS [DISK_INNER DISK_OUTER]\n# object X Y Z\n";
+    const BlackHolePool& blackHoles = world.getBlackHoles();
+    for (size_t i = 0; i < blackHoles.size(); ++i) {
+        const glm::vec3& p = blackHoles.positions()[i];
+        file << "blackhole " << p.x << " " << p.y << " " << p.z << " " << blackHoles.masses()[i] << " "
+             << blackHoles.diskInner()[i] << " " << blackHoles.diskOuter()[i] << "\n";
+    }
+    const ObjectPool& objects = world.getObjects();
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const glm::vec3& p = objects.positions()[i];
+        file << "object " << p.x << " " << p.y << " " << p.z << "\n";
+    }
+    return file.good();
+}
+
+bool loadBinary(const std::string& path, World& world) {
+    MappedFile file(path);
+    if (!file.getData()) {
+        std::cerr << "Could not map scene " << path << std::endl;
+        return false;
+    }
+    return parseBinary(file.getData(), file.getSize(), path, world);
+}
+
+bool saveBinary(const std::string& path, const World& world) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> bytes = encodeBinary(world);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+std::vector<unsigned char> encodeBinary(const World& world) {
+    const BlackHolePool& blackHoles = world.getBlackHoles();
+    const ObjectPool& objects = world.getObjects();
+    BinaryHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(header);
+    header.numBlackHoles = blackHoles.size();
+    header.numObjects = objects.size();
+
+    uint64_t sizes[NUM_COLUMNS];
+    columnSizes(header.numBlackHoles, header.numObjects, sizes);
+    uint64_t offset = alignUp(sizeof(header));
+    for (int i = 0; i < NUM_COLUMNS; ++i) {
+        header.columnOffsets[i] = offset;
+        offset = alignUp(offset + sizes[i]);
+    }
+
+    // Zero-filled, so the padding between columns is too
+    std::vector<unsigned char> bytes(header.columnOffsets[NUM_COLUMNS - 1] + sizes[NUM_COLUMNS - 1]);
+    const void* columns[NUM_COLUMNS] = { blackHoles.positions(), blackHoles.masses(),
+                                         blackHoles.schwarzschildRadii(), blackHoles.diskInner(),
+                                         blackHoles.diskOuter(), objects.positions() };
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    for (int i = 0; i < NUM_COLUMNS; ++i) {
+        if (sizes[i] > 0) std::memcpy(bytes.data() + header.columnOffsets[i], columns[i], sizes[i]);
+    }
+    return bytes;
+}
+
+bool decodeBinary(const unsigned char* data, size_t size, World& world) {
+    return parseBinary(data, size, "scene data", world);
+}
+
+bool isBinary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool load(const std::string& path, World& world) {
+    return isBinary(path) ? loadBinary(path, world) : loadText(path, world);
+}
+
+} // namespace SceneFile
@@ -0,0 +1,262 @@
+#include "SkyMap.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <glm/gtc/packing.hpp>
+#include "ThreadPool.hpp"
+
+namespace {
+
+constexpr char MAGIC[8] = { 'B', 'H', 'S', 'K', 'Y', 'M', 'A', 'P' };
+// Bump whenever the procedural sky or the bake changes, so stale cache files are rebuilt
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t faceSize;
+    uint32_t levelCount;
+    float starDensity;
+    float nebulaIntensity;
+};
+
+int roundFaceSize(int faceSize) {
+    return static_cast<int>(std::bit_ceil(static_cast<unsigned int>(std::max(faceSize, 1))));
+}
+
+float toHalf(float value) {
+    return glm::unpackHalf1x16(glm::packHalf1x16(value));
+}
+
+// Direction through face coordinates (s, t) in [0, 1], per the OpenGL cubemap face table
+glm::vec3 faceDirection(int face, float s, float t) {
+    float sc = 2.0f * s - 1.0f;
+    float tc = 2.0f * t - 1.0f;
+    switch (face) {
+    case 0: return glm::vec3(1.0f, -tc, -sc);
+    case 1: return glm::vec3(-1.0f, -tc, sc);
+    case 2: return glm::vec3(sc, 1.0f, tc);
+    case 3: return glm::vec3(sc, -1.0f, -tc);
+    case 4: return glm::vec3(sc, -tc, 1.0f);
+    default: return glm::vec3(-sc, -tc, -1.0f);
+    }
+}
+
+// Inverse of faceDirection: the face the major axis of dir points through
+int faceCoords(const glm::vec3& dir, float& s, float& t) {
+    glm::vec3 a = glm::abs(dir);
+    int face;
+    float sc, tc, ma;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = dir.x >= 0.0f ? 0 : 1;
+        sc = dir.x >= 0.0f ? -dir.z : dir.z;
+        tc = -dir.y;
+        ma = a.x;
+    } else if (a.y >= a.z) {
+        face = dir.y >= 0.0f ? 2 : 3;
+        sc = dir.x;
+        tc = dir.y >= 0.0f ? dir.z : -dir.z;
+        ma = a.y;
+    } else {
+        face = dir.z >= 0.0f ? 4 : 5;
+        sc = dir.z >= 0.0f ? dir.x : -dir.x;
+        tc = -dir.y;
+        ma = a.z;
+    }
+    s = 0.5f * (sc / ma + 1.0f);
+    t = 0.5f * (tc / ma + 1.0f);
+    return face;
+}
+
+} // namespace
+
+SkyMap::SkyMap(const Geodesic::SkyParams& params, int faceSize, ThreadPool* pool)
+    : params(params)
+    , faceSize(roundFaceSize(faceSize))
+{
+    allocateLevels();
+
+    // Level 0: 2x2 samples of the procedural sky per texel
+    const int n = this->faceSize;
+    auto bakeRow = [&](int row, int) {
+        int face = row / n;
+        int y = row % n;
+        float* out = &data[(static_cast<size_t>(face) * n + y) * n * 3];
+        for (int x = 0; x < n; ++x) {
+            glm::vec3 sum(0.0f);
+            for (int sy = 0; sy < 2; ++sy) {
+                for (int sx = 0; sx < 2; ++sx) {
+                    glm::vec3 dir = faceDirection(face, (x + 0.25f + 0.5f * sx) / n, (y + 0.25f + 0.5f * sy) / n);
+                    sum += Geodesic::getStarfield(glm::normalize(dir), this->params);
+                }
+            }
+            for (int c = 0; c < 3; ++c) out[x * 3 + c] = toHalf(sum[c] * 0.25f);
+        }
+    };
+    if (pool) {
+        pool->parallelFor(FACES * n, bakeRow);
+    } else {
+        for (int row = 0; row < FACES * n; ++row) bakeRow(row, 0);
+    }
+
+    // Box-filtered mips; tiny next to level 0, so not worth spreading out
+    for (int level = 1; level < getLevelCount(); ++level) {
+        int size = getLevelSize(level);
+        const float* src = getLevel(level - 1);
+        float* dst = data.data() + levelOffsets[level];
+        for (int face = 0; face < FACES; ++face) {
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    for (int c = 0; c < 3; ++c) {
+                        auto at = [&](int dx, int dy) {
+                            return src[((static_cast<size_t>(face) * size * 2 + y * 2 + dy) * size * 2 + x * 2 + dx) * 3 + c];
+                        };
+                        float average = 0.25f * (at(0, 0) + at(1, 0) + at(0, 1) + at(1, 1));
+                        dst[((static_cast<size_t>(face) * size + y) * size + x) * 3 + c] = toHalf(average);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<const SkyMap> SkyMap::load(const std::string& path, const Geodesic::SkyParams& params, int faceSize) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return nullptr;
+
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+        || header.faceSize != static_cast<uint32_t>(roundFaceSize(faceSize))
+        || header.starDensity != params.starDensity || header.nebulaIntensity != params.nebulaIntensity) {
+        return nullptr;
+    }
+
+    std::shared_ptr<SkyMap> map(new SkyMap());
+    map->params = params;
+    map->faceSize = static_cast<int>(header.faceSize);
+    map->allocateLevels();
+    if (header.levelCount != map->levelOffsets.size()) return nullptr;
+
+    // Stored as halves, which the texels are exactly
+    size_t total = map->data.size();
+    std::vector<uint16_t> halves(total);
+    if (!file.read(reinterpret_cast<char*>(halves.data()), static_cast<std::streamsize>(total * sizeof(uint16_t)))) {
+        std::cerr << "Sky cache " << path << " is truncated, baking it again" << std::endl;
+        return nullptr;
+    }
+    for (size_t i = 0; i < total; ++i) {
+        map->data[i] = glm::unpackHalf1x16(halves[i]);
+    }
+    return map;
+}
+
+bool SkyMap::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not open " << path << " for writing." << std::endl;
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.faceSize = static_cast<uint32_t>(faceSize);
+    header.levelCount = static_cast<uint32_t>(getLevelCount());
+    header.starDensity = params.starDensity;
+    header.nebulaIntensity = params.nebulaIntensity;
+
+    std::vector<uint16_t> halves(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        halves[i] = glm::packHalf1x16(data[i]);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(halves.data()), static_cast<std::streamsize>(halves.size() * sizeof(uint16_t)));
+    return file.good();
+}
+
+void SkyMap::allocateLevels() {
+    size_t total = 0;
+    for (int size = faceSize; size > 0; size /= 2) {
+        levelOffsets.push_back(total);
+        total += static_cast<size_t>(FACES) * size * size * 3;
+    }
+    data.resize(total);
+}
+
+glm::vec3 SkyMap::sampleLevel(int face, float s, float t, int level) const {
+    int size = getLevelSize(level);
+    const float* texels = getLevel(level) + static_cast<size_t>(face) * size * size * 3;
+
+    // Texel centres sit at half-integers; neighbours past the edge clamp to it
+    float x = s * size - 0.5f;
+    float y = t * size - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float wx = x - fx;
+    float wy = y - fy;
+    int x0 = std::clamp(static_cast<int>(fx), 0, size - 1);
+    int y0 = std::clamp(static_cast<int>(fy), 0, size - 1);
+    int x1 = std::clamp(static_cast<int>(fx) + 1, 0, size - 1);
+    int y1 = std::clamp(static_cast<int>(fy) + 1, 0, size - 1);
+
+    auto fetch = [&](int tx, int ty) {
+        const float* texel = texels + (static_cast<size_t>(ty) * size + tx) * 3;
+        return glm::vec3(texel[0], texel[1], texel[2]);
+    };
+    return glm::mix(glm::mix(fetch(x0, y0), fetch(x1, y0), wx), glm::mix(fetch(x0, y1), fetch(x1, y1), wx), wy);
+}
+
+glm::vec3 SkyMap::sample(const glm::vec3& dir, float lod) const {
+    float s, t;
+    int face = faceCoords(dir, s, t);
+
+    lod = std::clamp(lod, 0.0f, static_cast<float>(getLevelCount() - 1));
+    int level = static_cast<int>(lod);
+    float blend = lod - level;
+    glm::vec3 color = sampleLevel(face, s, t, level);
+    if (blend > 0.0f) {
+        color = glm::mix(color, sampleLevel(face, s, t, level + 1), blend);
+    }
+    return color;
+}
+
+float SkyMap::lodForPixel(float pixelAngle) const {
+    // A level-0 texel at the centre of a face spans about 2 / faceSize radians
+    return std::max(0.0f, std::log2(pixelAngle * faceSize * 0.5f));
+}
+
+std::shared_ptr<const SkyMap> SkyCache::get(const Geodesic::SkyParams& params, int faceSize, ThreadPool* pool) {
+    if (current && current->getParams() == params && current->getFaceSize() == roundFaceSize(faceSize)) {
+        return current;
+    }
+
+    std::string path = directory.empty() ? std::string() : pathFor(params, faceSize);
+    std::shared_ptr<const SkyMap> map = path.empty() ? nullptr : SkyMap::load(path, params, faceSize);
+    if (!map) {
+        map = std::make_shared<const SkyMap>(params, faceSize, pool);
+        if (!path.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            map->save(path);
+        }
+    }
+    current = map;
+    return current;
+}
+
+std::string SkyCache::pathFor(const Geodesic::SkyParams& params, int faceSize) const {
+    // The exact float bits, so every slider position gets its own file
+    uint32_t density, intensity;
+    std::memcpy(&density, &params.starDensity, sizeof(density));
+    std::memcpy(&intensity, &params.nebulaIntensity, sizeof(intensity));
+    char name[64];
+    std::snprintf(name, sizeof(name), "sky_%d_%08x_%08x.bin", roundFaceSize(faceSize), density, intensity);
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,99 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& task) {
+    if (count <= 0) return;
+
+    std::lock_guard<std::mutex> jobLock(jobMutex);
+
+    currentTask = &task;
+    remaining.store(count);
+
+    // Deal indices round-robin so expensive neighbouring items start on different workers
+    unsigned int numQueues = size();
+    for (unsigned int q = 0; q < numQueues; ++q) {
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        for (int i = q; i < count; i += numQueues) {
+            queues[q]->items.push_back(i);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    ++generation;
+    jobReady.notify_all();
+    jobDone.wait(lock, [this] { return remaining.load() == 0; });
+    currentTask = nullptr;
+}
+
+bool ThreadPool::popOrSteal(unsigned int workerIndex, int& item) {
+    // Own queue first, from the front
+    {
+        WorkerQueue& own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty()) {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the back of the other queues
+    unsigned int numQueues = size();
+    for (unsigned int offset = 1; offset < numQueues; ++offset) {
+        WorkerQueue& victim = *queues[(workerIndex + offset) % numQueues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex) {
+    uint64_t seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            jobReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        int item;
+        while (popOrSteal(workerIndex, item)) {
+            (*currentTask)(item, static_cast<int>(workerIndex));
+
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                jobDone.notify_all();
+            }
+        }
+    }
+}
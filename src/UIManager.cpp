@@ -1,5 +1,6 @@
 #include "UIManager.hpp"
 #include "Camera.hpp"
+#include "PostProcess.hpp"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include <algorithm>
@@ -10,6 +11,16 @@ UIManager::UIManager() {
 UIManager::~UIManager() {
 }
 
+const std::array<UIManager::QualityPreset, 3>& UIManager::getQualityPresets() {
+    // "Medium" matches the RenderSettings defaults
+    static const std::array<QualityPreset, 3> presets = {{
+        { "Low", 100, 10000.0f, 0.12f, 1.5f },
+        { "Medium", 200, 10000.0f, 0.08f, 1.5f },
+        { "High", 400, 10000.0f, 0.04f, 1.5f },
+    }};
+    return presets;
+}
+
 void UIManager::init() {
     setupStyle();
 }
@@ -247,10 +258,60 @@ void UIManager::renderRenderSettingsPanel() {
     }
 
     if (ImGui::CollapsingHeader("Ray Tracing", ImGuiTreeNodeFlags_DefaultOpen)) {
+        const auto& presets = getQualityPresets();
+        for (size_t i = 0; i < presets.size(); ++i) {
+            if (i > 0) ImGui::SameLine();
+            if (ImGui::Button(presets[i].name)) {
+                renderSettings.maxRaySteps = presets[i].maxRaySteps;
+                renderSettings.maxDistance = presets[i].maxDistance;
+                renderSettings.adaptiveStepSize = presets[i].adaptiveStepSize;
+                renderSettings.bendingStrength = presets[i].bendingStrength;
+            }
+        }
         ImGui::SliderInt("Max Steps", &renderSettings.maxRaySteps, 50, 500);
         ImGui::SliderFloat("Max Distance", &renderSettings.maxDistance, 1000.0f, 100000.0f, "%.0f");
         ImGui::SliderFloat("Adaptive Step", &renderSettings.adaptiveStepSize, 0.01f, 0.2f, "%.3f");
         ImGui::SliderFloat("Bending Strength", &renderSettings.bendingStrength, 0.1f, 5.0f, "%.2f");
+        const char* integrators[] = { "Newtonian", "Schwarzschild (RK45)" };
+        int integrator = renderSettings.schwarzschild ? 1 : 0;
+        if (ImGui::Combo("Integrator", &integrator, integrators, IM_ARRAYSIZE(integrators))) {
+            renderSettings.schwarzschild = integrator == 1;
+        }
+        if (renderSettings.schwarzschild) {
+            ImGui::SliderFloat("Tolerance", &renderSettings.tolerance, 1e-5f, 1e-1f, "%.0e", ImGuiSliderFlags_Logarithmic);
+        }
+        ImGui::Checkbox("Bounding Spheres", &renderSettings.boundingSpheres);
+        ImGui::Checkbox("Deflection Lookup Table", &renderSettings.deflectionLut);
+        ImGui::Checkbox("Baked Sky", &renderSettings.bakedSky);
+        const char* backends[] = { "Fragment", "Compute (GL 4.3)" };
+        int backend = renderSettings.computeBackend ? 1 : 0;
+        if (ImGui::Combo("GPU Backend", &backend, backends, IM_ARRAYSIZE(backends))) {
+            renderSettings.computeBackend = backend == 1;
+        }
+        const char* marchScales[] = { "Full", "Half", "Quarter" };
+        int marchScale = renderSettings.marchScale >= 4 ? 2 : renderSettings.marchScale - 1;
+        if (ImGui::Combo("GPU March Resolution", &marchScale, marchScales, IM_ARRAYSIZE(marchScales))) {
+            renderSettings.marchScale = 1 << marchScale;
+        }
+        ImGui::Checkbox("Temporal Reuse", &renderSettings.temporalReuse);
+        const char* displayFormats[] = { "8-bit (RGBA8)", "10-bit (RGB10A2)" };
+        int displayFormat = renderSettings.cpuTenBitDisplay ? 1 : 0;
+        if (ImGui::Combo("CPU Display Format", &displayFormat, displayFormats, IM_ARRAYSIZE(displayFormats))) {
+            renderSettings.cpuTenBitDisplay = displayFormat == 1;
+        }
+        const char* pipelineDepths[] = { "UI thread", "Render thread, 1 frame ahead", "Render thread, 2 frames ahead" };
+        ImGui::Combo("CPU Pipeline", &renderSettings.cpuPipelineDepth, pipelineDepths, IM_ARRAYSIZE(pipelineDepths));
+        ImGui::Checkbox("Progressive Refinement", &renderSettings.progressive);
+        ImGui::SliderInt("Max Samples", &renderSettings.maxSamples, 1, 1024);
+    }
+
+    if (ImGui::CollapsingHeader("Post-Processing (GPU)", ImGuiTreeNodeFlags_DefaultOpen)) {
+        ImGui::SliderFloat("Exposure", &renderSettings.exposure, -4.0f, 4.0f, "%+.2f EV");
+        const char* tonemaps[] = { "Clamp", "Reinhard", "ACES" };
+        ImGui::Combo("Tonemap", &renderSettings.tonemap, tonemaps, IM_ARRAYSIZE(tonemaps));
+        ImGui::SliderFloat("Bloom Strength", &renderSettings.bloomStrength, 0.0f, 1.0f, "%.3f");
+        ImGui::SliderFloat("Bloom Threshold", &renderSettings.bloomThreshold, 0.0f, 4.0f, "%.2f");
+        ImGui::SliderInt("Bloom Levels", &renderSettings.bloomLevels, 1, PostProcess::MAX_BLOOM_LEVELS);
     }
 
     ImGui::End();
@@ -323,19 +384,92 @@ void UIManager::renderPerformancePanel(float fps) {
                         ImVec2(0, 80));
     }
 
+    if (ImGui::CollapsingHeader("Renderer", ImGuiTreeNodeFlags_DefaultOpen)) {
+        renderRendererStats();
+
+        if (perfSettings.dynamicResolution) {
+            ImGui::PlotLines("Resolution Scale",
+                            perfSettings.resolutionScaleHistory.data(),
+                            perfSettings.resolutionScaleHistory.size(),
+                            perfSettings.resolutionScaleIndex,
+                            nullptr,
+                            0.0f,
+                            1.0f,
+                            ImVec2(0, 60));
+        }
+    }
+
     if (ImGui::CollapsingHeader("Options")) {
         ImGui::Checkbox("Show FPS", &perfSettings.showFps);
         ImGui::Checkbox("VSync", &perfSettings.vsync);
         ImGui::SliderFloat("Target FPS", &perfSettings.targetFps, 30.0f, 144.0f, "%.0f");
+        ImGui::Checkbox("Dynamic Resolution", &perfSettings.dynamicResolution);
+        ImGui::SliderFloat("Min Resolution Scale", &perfSettings.minResolutionScale, 0.25f, 1.0f, "%.2f");
     }
 
     ImGui::End();
 }
 
+void UIManager::renderRendererStats() {
+    const RendererStats& stats = rendererStats;
+    if (stats.gpu) {
+        ImGui::TextUnformatted(stats.specializedShader ? "Shader: specialized preset" : "Shader: generic (uniform parameters)");
+    } else {
+        ImGui::TextUnformatted("CPU marcher");
+    }
+    if (stats.usingDeflectionLut) {
+        ImGui::TextUnformatted("Deflection table: in use");
+    }
+
+    if (stats.gpu) {
+        if (stats.usingCompute) {
+            ImGui::TextUnformatted("Backend: compute, persistent threads");
+        } else if (stats.computeSelected) {
+            ImGui::TextUnformatted("Backend: fragment (compute needs GL 4.3)");
+        }
+        if (stats.marchScale > 1 && !stats.usingCompute) {
+            ImGui::Text("March: 1/%d resolution, edges re-traced", stats.marchScale);
+        }
+        if (stats.temporalReuse && !stats.usingCompute) {
+            ImGui::Text("Temporal reuse: up to %d frames", stats.temporalMaxAge);
+        }
+        ImGui::Text("Post-processing: %.2f ms", stats.postProcessMs);
+    }
+    if (stats.skyFaceSize > 0) {
+        ImGui::Text("Sky: %d px cubemap", stats.skyFaceSize);
+    }
+
+    if (!stats.gpu) {
+        if (stats.countSkippedRays) {
+            ImGui::Text("Rays skipped: %.0f%%", stats.skippedRayPercent);
+        }
+        ImGui::Text("Trace: %.2f ms, upload: %.2f ms (%s)", stats.traceMs, stats.uploadMs,
+                    stats.persistentPbos ? "persistent PBOs" : "mapped PBOs");
+        if (stats.pipelineDepth > 0) {
+            ImGui::Text("Render thread: %d frame(s) ahead", stats.pipelineDepth);
+        }
+    }
+
+    if (stats.progressive) {
+        ImGui::Text("Samples: %d / %d", stats.samples, stats.maxSamples);
+    }
+    if (stats.dynamicResolution) {
+        static const char* decisionNames[] = { "hold", "up", "down" };
+        ImGui::Text("Resolution: %dx%d (%.0f%%)", stats.renderWidth, stats.renderHeight, stats.resolutionScale * 100.0f);
+        ImGui::Text("Render: %.2f ms, budget %.2f ms", stats.smoothedMs, stats.budgetMs);
+        ImGui::Text("Last change: %s at %.2f ms", decisionNames[(int)stats.lastDecision], stats.lastDecisionMs);
+    }
+}
+
 void UIManager::renderInfoBar() {
     // Could add a status bar at the bottom if desired
 }
 
+void UIManager::recordResolutionScale(float scale) {
+    perfSettings.resolutionScaleHistory[perfSettings.resolutionScaleIndex] = scale;
+    perfSettings.resolutionScaleIndex = (perfSettings.resolutionScaleIndex + 1) % perfSettings.resolutionScaleHistory.size();
+}
+
 void UIManager::updateFrameTime(float deltaTime) {
     float frameTimeMs = deltaTime * 1000.0f;
     perfSettings.frameTimeHistory[perfSettings.frameTimeIndex] = frameTimeMs;
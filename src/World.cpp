@@ -1,9 +1,81 @@
 #include "World.hpp"
+#include <atomic>
 
-void World::add(std::shared_ptr<Object> obj) {
-    objects.push_back(obj);
+BlackHole BlackHolePool::get(size_t index) const {
+    BlackHole blackHole(positions()[index], masses()[index], diskInner()[index], diskOuter()[index]);
+    // Stored as given, not re-derived from the mass
+    blackHole.rs = schwarzschildRadii()[index];
+    blackHole.diskInner = diskInner()[index];
+    blackHole.diskOuter = diskOuter()[index];
+    return blackHole;
+}
+
+BlackHoleHandle World::add(const BlackHole& blackHole) {
+    markChanged();
+    return blackHoles.insert(arena, blackHole.position, blackHole.mass, blackHole.rs,
+                             blackHole.diskInner, blackHole.diskOuter);
+}
+
+ObjectHandle World::add(const Object& object) {
+    markChanged();
+    return objects.insert(arena, object.position);
+}
+
+void World::addBlackHoles(size_t count, const glm::vec3* positions, const float* masses, const float* rs,
+                          const float* diskInner, const float* diskOuter) {
+    blackHoles.append(arena, count, positions, masses, rs, diskInner, diskOuter);
+    markChanged();
+}
+
+void World::addObjects(size_t count, const glm::vec3* positions) {
+    objects.append(arena, count, positions);
+    markChanged();
+}
+
+bool World::remove(BlackHoleHandle handle) {
+    if (!blackHoles.erase(handle)) return false;
+    markChanged();
+    return true;
+}
+
+bool World::remove(ObjectHandle handle) {
+    if (!objects.erase(handle)) return false;
+    markChanged();
+    return true;
+}
+
+bool World::update(BlackHoleHandle handle, const BlackHole& blackHole) {
+    if (!blackHoles.contains(handle)) return false;
+    blackHoles.write(blackHoles.indexOf(handle), blackHole.position, blackHole.mass, blackHole.rs,
+                     blackHole.diskInner, blackHole.diskOuter);
+    markChanged();
+    return true;
+}
+
+bool World::update(ObjectHandle handle, const Object& object) {
+    if (!objects.contains(handle)) return false;
+    objects.write(objects.indexOf(handle), object.position);
+    markChanged();
+    return true;
+}
+
+World World::snapshot() const {
+    World copy;
+    copy.addBlackHoles(blackHoles.size(), blackHoles.positions(), blackHoles.masses(), blackHoles.schwarzschildRadii(),
+                       blackHoles.diskInner(), blackHoles.diskOuter());
+    copy.addObjects(objects.size(), objects.positions());
+    copy.revision = revision;
+    return copy;
 }
 
 void World::clear() {
+    blackHoles.clear();
     objects.clear();
+    arena.reset();
+    markChanged();
+}
+
+uint64_t World::nextRevision() {
+    static std::atomic<uint64_t> counter{ 0 };
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
 }
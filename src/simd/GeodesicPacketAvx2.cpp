@@ -0,0 +1,79 @@
+#include "PacketIsa.hpp"
+
+#if GEODESIC_PACKET_X86
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <immintrin.h>
+
+// Everything below is compiled for AVX2/FMA; only called after a runtime CPU check
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+
+#include "PacketKernel.hpp"
+
+namespace {
+
+struct Avx2Mask {
+    __m256 m;
+
+    static Avx2Mask none() { return { _mm256_setzero_ps() }; }
+    static Avx2Mask firstN(int n) {
+        __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        return { _mm256_cmp_ps(index, _mm256_set1_ps((float)n), _CMP_LT_OQ) };
+    }
+    bool any() const { return _mm256_movemask_ps(m) != 0; }
+    unsigned int bits() const { return (unsigned int)_mm256_movemask_ps(m); }
+    Avx2Mask andNot(Avx2Mask other) const { return { _mm256_andnot_ps(other.m, m) }; }
+};
+
+inline Avx2Mask operator&(Avx2Mask a, Avx2Mask b) { return { _mm256_and_ps(a.m, b.m) }; }
+inline Avx2Mask operator|(Avx2Mask a, Avx2Mask b) { return { _mm256_or_ps(a.m, b.m) }; }
+
+struct Avx2Vec {
+    using Mask = Avx2Mask;
+    static constexpr int Width = 8;
+    __m256 v;
+
+    static Avx2Vec set1(float f) { return { _mm256_set1_ps(f) }; }
+    static Avx2Vec load(const float* p) { return { _mm256_load_ps(p) }; }
+    void store(float* p) const { _mm256_store_ps(p, v); }
+};
+
+inline Avx2Vec operator+(Avx2Vec a, Avx2Vec b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Avx2Vec operator-(Avx2Vec a, Avx2Vec b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Avx2Vec operator*(Avx2Vec a, Avx2Vec b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Avx2Vec operator/(Avx2Vec a, Avx2Vec b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Avx2Mask operator<(Avx2Vec a, Avx2Vec b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline Avx2Mask operator>(Avx2Vec a, Avx2Vec b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline Avx2Vec sqrt(Avx2Vec a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Avx2Vec min(Avx2Vec a, Avx2Vec b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Avx2Vec max(Avx2Vec a, Avx2Vec b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Avx2Vec abs(Avx2Vec a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+inline Avx2Vec select(Avx2Mask m, Avx2Vec a, Avx2Vec b) { return { _mm256_blendv_ps(b.v, a.v, m.m) }; }
+
+} // namespace
+
+namespace GeodesicPacket {
+
+uint64_t traceRaysAvx2(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                       const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                       const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays)
+{
+    return detail::traceRays<Avx2Vec>(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB,
+                                      params, sky, skippedRays);
+}
+
+} // namespace GeodesicPacket
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // GEODESIC_PACKET_X86
@@ -0,0 +1,76 @@
+#include "PacketIsa.hpp"
+
+#if GEODESIC_PACKET_X86
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <immintrin.h>
+
+// Everything below is compiled for AVX-512F; only called after a runtime CPU check
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#include "PacketKernel.hpp"
+
+namespace {
+
+struct Avx512Mask {
+    __mmask16 m;
+
+    static Avx512Mask none() { return { 0 }; }
+    static Avx512Mask firstN(int n) { return { (__mmask16)(n >= 16 ? 0xFFFFu : (1u << n) - 1u) }; }
+    bool any() const { return m != 0; }
+    unsigned int bits() const { return m; }
+    Avx512Mask andNot(Avx512Mask other) const { return { (__mmask16)(m & ~other.m) }; }
+};
+
+inline Avx512Mask operator&(Avx512Mask a, Avx512Mask b) { return { (__mmask16)(a.m & b.m) }; }
+inline Avx512Mask operator|(Avx512Mask a, Avx512Mask b) { return { (__mmask16)(a.m | b.m) }; }
+
+struct Avx512Vec {
+    using Mask = Avx512Mask;
+    static constexpr int Width = 16;
+    __m512 v;
+
+    static Avx512Vec set1(float f) { return { _mm512_set1_ps(f) }; }
+    static Avx512Vec load(const float* p) { return { _mm512_load_ps(p) }; }
+    void store(float* p) const { _mm512_store_ps(p, v); }
+};
+
+inline Avx512Vec operator+(Avx512Vec a, Avx512Vec b) { return { _mm512_add_ps(a.v, b.v) }; }
+inline Avx512Vec operator-(Avx512Vec a, Avx512Vec b) { return { _mm512_sub_ps(a.v, b.v) }; }
+inline Avx512Vec operator*(Avx512Vec a, Avx512Vec b) { return { _mm512_mul_ps(a.v, b.v) }; }
+inline Avx512Vec operator/(Avx512Vec a, Avx512Vec b) { return { _mm512_div_ps(a.v, b.v) }; }
+inline Avx512Mask operator<(Avx512Vec a, Avx512Vec b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+inline Avx512Mask operator>(Avx512Vec a, Avx512Vec b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ) }; }
+inline Avx512Vec sqrt(Avx512Vec a) { return { _mm512_sqrt_ps(a.v) }; }
+inline Avx512Vec min(Avx512Vec a, Avx512Vec b) { return { _mm512_min_ps(a.v, b.v) }; }
+inline Avx512Vec max(Avx512Vec a, Avx512Vec b) { return { _mm512_max_ps(a.v, b.v) }; }
+inline Avx512Vec abs(Avx512Vec a) { return { _mm512_abs_ps(a.v) }; }
+inline Avx512Vec select(Avx512Mask m, Avx512Vec a, Avx512Vec b) { return { _mm512_mask_blend_ps(m.m, b.v, a.v) }; }
+
+} // namespace
+
+namespace GeodesicPacket {
+
+uint64_t traceRaysAvx512(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                         const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                         const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays)
+{
+    return detail::traceRays<Avx512Vec>(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB,
+                                        params, sky, skippedRays);
+}
+
+} // namespace GeodesicPacket
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // GEODESIC_PACKET_X86
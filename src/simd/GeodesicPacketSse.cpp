@@ -0,0 +1,78 @@
+#include "PacketIsa.hpp"
+
+#if GEODESIC_PACKET_X86
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <immintrin.h>
+
+// Everything below is compiled for SSE4.1; only called after a runtime CPU check
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+#include "PacketKernel.hpp"
+
+namespace {
+
+struct SseMask {
+    __m128 m;
+
+    static SseMask none() { return { _mm_setzero_ps() }; }
+    static SseMask firstN(int n) {
+        return { _mm_cmplt_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps((float)n)) };
+    }
+    bool any() const { return _mm_movemask_ps(m) != 0; }
+    unsigned int bits() const { return (unsigned int)_mm_movemask_ps(m); }
+    SseMask andNot(SseMask other) const { return { _mm_andnot_ps(other.m, m) }; }
+};
+
+inline SseMask operator&(SseMask a, SseMask b) { return { _mm_and_ps(a.m, b.m) }; }
+inline SseMask operator|(SseMask a, SseMask b) { return { _mm_or_ps(a.m, b.m) }; }
+
+struct SseVec {
+    using Mask = SseMask;
+    static constexpr int Width = 4;
+    __m128 v;
+
+    static SseVec set1(float f) { return { _mm_set1_ps(f) }; }
+    static SseVec load(const float* p) { return { _mm_load_ps(p) }; }
+    void store(float* p) const { _mm_store_ps(p, v); }
+};
+
+inline SseVec operator+(SseVec a, SseVec b) { return { _mm_add_ps(a.v, b.v) }; }
+inline SseVec operator-(SseVec a, SseVec b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline SseVec operator*(SseVec a, SseVec b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline SseVec operator/(SseVec a, SseVec b) { return { _mm_div_ps(a.v, b.v) }; }
+inline SseMask operator<(SseVec a, SseVec b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline SseMask operator>(SseVec a, SseVec b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline SseVec sqrt(SseVec a) { return { _mm_sqrt_ps(a.v) }; }
+inline SseVec min(SseVec a, SseVec b) { return { _mm_min_ps(a.v, b.v) }; }
+inline SseVec max(SseVec a, SseVec b) { return { _mm_max_ps(a.v, b.v) }; }
+inline SseVec abs(SseVec a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+inline SseVec select(SseMask m, SseVec a, SseVec b) { return { _mm_blendv_ps(b.v, a.v, m.m) }; }
+
+} // namespace
+
+namespace GeodesicPacket {
+
+uint64_t traceRaysSse41(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                        const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                        const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays)
+{
+    return detail::traceRays<SseVec>(origin, dirX, dirY, dirZ, count, blackHoles, numBlackHoles, outRGB,
+                                     params, sky, skippedRays);
+}
+
+} // namespace GeodesicPacket
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // GEODESIC_PACKET_X86
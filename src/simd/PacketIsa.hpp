@@ -0,0 +1,28 @@
+#pragma once
+
+// Entry points of the per-ISA packet marchers in src/simd/. Only call one
+// after GeodesicPacket::isSupported() has confirmed the CPU can run it.
+// Each returns the number of integration steps taken by all rays and adds
+// the rays the bounding spheres let skip marching to *skippedRays if given.
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GEODESIC_PACKET_X86 1
+#endif
+
+namespace GeodesicPacket {
+
+uint64_t traceRaysSse41(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                        const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                        const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays);
+uint64_t traceRaysAvx2(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                       const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                       const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays);
+uint64_t traceRaysAvx512(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                         const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                         const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays);
+
+} // namespace GeodesicPacket
@@ -0,0 +1,441 @@
+#pragma once
+
+// Shared packet marcher for the per-ISA translation units in src/simd/.
+// Each unit includes its dependencies, enables its instruction set with a
+// target pragma, includes this header, defines a vector type V (and its mask
+// type) with the small interface used below and instantiates traceRays<V>.
+// The dependencies must come before the pragma so std/glm inline functions
+// stay compiled for the baseline ISA. Keep the per-step logic identical to
+// Geodesic::traceGeodesic.
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Geodesic.hpp"
+#include "../DormandPrince.hpp"
+
+namespace GeodesicPacket {
+namespace detail {
+
+// Disk density integrated over the height above the midplane from 0 to y, per lane
+template <typename V>
+inline V diskDensityIntegral(V y)
+{
+    const V diskHalf = V::set1(Geodesic::DISK_HALF_THICKNESS);
+    V u = min(max(y, V::set1(-Geodesic::DISK_HALF_THICKNESS)), diskHalf);
+    return V::set1(2.0f) * u - u * abs(u) / diskHalf;
+}
+
+// Adds the glow of every accretion disk along the segments a -> b of the `mask` lanes,
+// integrated exactly across the slab like Geodesic::accumulateDisks
+template <typename V>
+inline void accumulateDisks(V ax, V ay, V az, V bx, V by, V bz, typename V::Mask mask,
+                            const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, V& accR, V& accG, V& accB)
+{
+    using M = typename V::Mask;
+    const V diskHalf = V::set1(Geodesic::DISK_HALF_THICKNESS);
+    const V zero = V::set1(0.0f);
+    const V one = V::set1(1.0f);
+    const V two = V::set1(2.0f);
+    const V half = V::set1(0.5f);
+
+    V abx = bx - ax;
+    V aby = by - ay;
+    V abz = bz - az;
+    V length = sqrt(abx * abx + aby * aby + abz * abz);
+
+    for (int j = 0; j < numBlackHoles; j++) {
+        const Geodesic::BlackHoleData& bh = blackHoles[j];
+        V ya = ay - V::set1(bh.pos.y);
+        V yb = by - V::set1(bh.pos.y);
+        M crosses = mask & (min(ya, yb) < diskHalf) & (max(ya, yb) > zero - diskHalf);
+        if (!crosses.any()) continue;
+
+        // Steps (nearly) parallel to the slab take the density at their mean height
+        V dy = yb - ya;
+        M flat = abs(dy) < V::set1(Geodesic::DISK_FLAT_EPSILON);
+        V safeDy = select(flat, one, dy);
+        V slopedDensity = (diskDensityIntegral<V>(yb) - diskDensityIntegral<V>(ya)) / safeDy;
+        V flatDensity = two * (one - abs(half * (ya + yb)) / diskHalf);
+        V density = select(flat, flatDensity, slopedDensity);
+        V t = select(flat, half, min(max((zero - ya) / safeDy, zero), one));
+
+        V tx = V::set1(bh.pos.x) - (ax + abx * t);
+        V ty = V::set1(bh.pos.y) - (ay + aby * t);
+        V tz = V::set1(bh.pos.z) - (az + abz * t);
+        V r = sqrt(tx * tx + ty * ty + tz * tz);
+
+        M inDisk = crosses & (r > V::set1(bh.diskInner)) & (r < V::set1(bh.diskOuter));
+        if (!inDisk.any()) continue;
+
+        V temp = (r - V::set1(bh.diskInner)) / V::set1(bh.diskOuter - bh.diskInner);
+        V weight = density * length;
+        // mix(vec3(1.0, 0.8, 0.5), vec3(0.8, 0.2, 0.1), temp)
+        V colR = V::set1(1.0f) + V::set1(-0.2f) * temp;
+        V colG = V::set1(0.8f) + V::set1(-0.6f) * temp;
+        V colB = V::set1(0.5f) + V::set1(-0.4f) * temp;
+        accR = select(inDisk, accR + colR * weight, accR);
+        accG = select(inDisk, accG + colG * weight, accG);
+        accB = select(inDisk, accB + colB * weight, accB);
+    }
+}
+
+// Adds the sky to the lanes that escaped and writes the packet's colours out
+template <typename V>
+inline void resolvePacket(V accR, V accG, V accB, V dx, V dy, V dz, typename V::Mask escaped, int count,
+                          float* outRGB, const Geodesic::Sky& sky)
+{
+    constexpr int W = V::Width;
+    alignas(64) float out[6][W];
+    accR.store(out[0]);
+    accG.store(out[1]);
+    accB.store(out[2]);
+    dx.store(out[3]);
+    dy.store(out[4]);
+    dz.store(out[5]);
+    unsigned int escapedBits = escaped.bits();
+
+    for (int k = 0; k < count; ++k) {
+        glm::vec3 color(out[0][k], out[1][k], out[2][k]);
+        if (escapedBits & (1u << k)) {
+            color += sky.sample(glm::vec3(out[3][k], out[4][k], out[5][k]));
+        }
+        outRGB[k * 3] = color.r;
+        outRGB[k * 3 + 1] = color.g;
+        outRGB[k * 3 + 2] = color.b;
+    }
+}
+
+// Start of up to W rays that made it past the bounding spheres, each with
+// its own point (where it entered a sphere) and remaining distance budget.
+// Lanes past `count` repeat the last ray so they still hold finite values.
+template <int W>
+struct PacketRays {
+    alignas(64) float px[W], py[W], pz[W];
+    alignas(64) float dx[W], dy[W], dz[W];
+    alignas(64) float maxDistance[W];
+    int count = 0;
+
+    void pad() {
+        for (int k = count; k < W; ++k) {
+            px[k] = px[count - 1]; py[k] = py[count - 1]; pz[k] = pz[count - 1];
+            dx[k] = dx[count - 1]; dy[k] = dy[count - 1]; dz[k] = dz[count - 1];
+            maxDistance[k] = maxDistance[count - 1];
+        }
+    }
+};
+
+// Traces a packet of rays; lanes past rays.count are masked off from the start.
+// Returns the number of integration steps summed over the live lanes.
+template <typename V>
+uint64_t tracePacket(const PacketRays<V::Width>& rays, const Geodesic::BlackHoleData* blackHoles, int numBlackHoles,
+                     float* outRGB, const Geodesic::MarchParams& params, const Geodesic::Sky& sky)
+{
+    using M = typename V::Mask;
+
+    // --- Ray state (SoA) ---
+    const V ox0 = V::load(rays.px), oy0 = V::load(rays.py), oz0 = V::load(rays.pz);
+    V px = ox0, py = oy0, pz = oz0;
+    V dx = V::load(rays.dx), dy = V::load(rays.dy), dz = V::load(rays.dz);
+    V accR = V::set1(0.0f), accG = V::set1(0.0f), accB = V::set1(0.0f);
+    M active = M::firstN(rays.count);
+    M escaped = M::none(); // Lanes that finish on the sky rather than a horizon
+
+    const V minStep = V::set1(Geodesic::MIN_STEP);
+    const V stepFactor = V::set1(params.stepFactor);
+    const V escapeRadius = V::set1(Geodesic::ESCAPE_RADIUS);
+    const V maxDist = V::load(rays.maxDistance);
+    const V maxDist2 = maxDist * maxDist;
+
+    uint64_t steps = 0;
+    for (int i = 0; i < params.maxSteps && active.any(); i++) {
+        steps += std::popcount(active.bits());
+
+        // Gravity, closest distance and horizon test share one distance per black hole
+        V minR = V::set1(Geodesic::MAX_DIST);
+        V fx = V::set1(0.0f), fy = V::set1(0.0f), fz = V::set1(0.0f);
+        M captured = M::none();
+
+        for (int j = 0; j < numBlackHoles; j++) {
+            const Geodesic::BlackHoleData& bh = blackHoles[j];
+            V tx = V::set1(bh.pos.x) - px;
+            V ty = V::set1(bh.pos.y) - py;
+            V tz = V::set1(bh.pos.z) - pz;
+            V r2 = tx * tx + ty * ty + tz * tz;
+            V r = sqrt(r2);
+            minR = min(minR, r);
+
+            // normalize(toBH) * bendingStrength * rs / r^2
+            V force = V::set1(params.bendingStrength * bh.rs) / (r2 * r);
+            fx = fx + tx * force;
+            fy = fy + ty * force;
+            fz = fz + tz * force;
+
+            captured = captured | (r < V::set1(bh.rs));
+        }
+
+        // Adaptive Step Size
+        V h = max(minStep, minR * stepFactor);
+
+        // Event horizons: those lanes are done and keep what they accumulated
+        active = active.andNot(captured);
+
+        // Escape Check
+        M escaping = active & (minR > escapeRadius);
+        escaped = escaped | escaping;
+        active = active.andNot(escaping);
+
+        // Apply Gravity
+        V ndx = dx + fx * h;
+        V ndy = dy + fy * h;
+        V ndz = dz + fz * h;
+        V len = sqrt(ndx * ndx + ndy * ndy + ndz * ndz);
+        dx = select(active, ndx / len, dx);
+        dy = select(active, ndy / len, dy);
+        dz = select(active, ndz / len, dz);
+
+        // Move Position, collecting the accretion disk glow along the way
+        V nx = px + dx * h;
+        V ny = py + dy * h;
+        V nz = pz + dz * h;
+        accumulateDisks<V>(px, py, pz, nx, ny, nz, active, blackHoles, numBlackHoles, accR, accG, accB);
+        px = select(active, nx, px);
+        py = select(active, ny, py);
+        pz = select(active, nz, pz);
+
+        // Max Distance Check
+        V ox = px - ox0;
+        V oy = py - oy0;
+        V oz = pz - oz0;
+        M tooFar = active & ((ox * ox + oy * oy + oz * oz) > maxDist2);
+        escaped = escaped | tooFar;
+        active = active.andNot(tooFar);
+    }
+
+    // Lanes that ran out of steps fall back to the sky like the scalar marcher
+    escaped = escaped | active;
+
+    resolvePacket<V>(accR, accG, accB, dx, dy, dz, escaped, rays.count, outRGB, sky);
+    return steps;
+}
+
+// Three lanes-wide vectors: one component per register
+template <typename V>
+struct Vec3Lanes {
+    V x, y, z;
+};
+
+template <typename V>
+inline Vec3Lanes<V> operator+(const Vec3Lanes<V>& a, const Vec3Lanes<V>& b) {
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+template <typename V>
+inline Vec3Lanes<V> operator*(float s, const Vec3Lanes<V>& a) {
+    V k = V::set1(s);
+    return { k * a.x, k * a.y, k * a.z };
+}
+
+template <typename V>
+inline Vec3Lanes<V> operator*(V s, const Vec3Lanes<V>& a) {
+    return { s * a.x, s * a.y, s * a.z };
+}
+
+template <typename V>
+inline Vec3Lanes<V> select(typename V::Mask m, const Vec3Lanes<V>& a, const Vec3Lanes<V>& b) {
+    return { select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z) };
+}
+
+template <typename V>
+inline V length(const Vec3Lanes<V>& a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+
+// Packet version of Geodesic's Schwarzschild integrator: Dormand-Prince 5(4)
+// with a step size per lane. Lanes that reject a step stay in place and retry
+// with a smaller one while the others advance. Each attempt counts as a step.
+template <typename V>
+uint64_t tracePacketSchwarzschild(const PacketRays<V::Width>& rays, const Geodesic::BlackHoleData* blackHoles,
+                                  int numBlackHoles, float* outRGB, const Geodesic::MarchParams& params,
+                                  const Geodesic::Sky& sky)
+{
+    using namespace DormandPrince;
+    using M = typename V::Mask;
+    using V3 = Vec3Lanes<V>;
+
+    // x'' summed over the holes, with each hole's h^2 = |cross(o - c, d)|^2 taken from the ray's start
+    const V3 origin{ V::load(rays.px), V::load(rays.py), V::load(rays.pz) };
+    const V3 dir0{ V::load(rays.dx), V::load(rays.dy), V::load(rays.dz) };
+    auto accelAt = [&](const V3& p) {
+        V3 accel{ V::set1(0.0f), V::set1(0.0f), V::set1(0.0f) };
+        for (int j = 0; j < numBlackHoles; j++) {
+            const Geodesic::BlackHoleData& bh = blackHoles[j];
+            V ox = origin.x - V::set1(bh.pos.x), oy = origin.y - V::set1(bh.pos.y), oz = origin.z - V::set1(bh.pos.z);
+            V hx = oy * dir0.z - oz * dir0.y;
+            V hy = oz * dir0.x - ox * dir0.z;
+            V hz = ox * dir0.y - oy * dir0.x;
+            V h2 = hx * hx + hy * hy + hz * hz;
+
+            V3 x{ p.x - V::set1(bh.pos.x), p.y - V::set1(bh.pos.y), p.z - V::set1(bh.pos.z) };
+            V r2 = x.x * x.x + x.y * x.y + x.z * x.z;
+            V k = V::set1(-params.bendingStrength * bh.rs) * h2 / (r2 * r2 * sqrt(r2));
+            accel = accel + k * x;
+        }
+        return accel;
+    };
+
+    V3 p = origin;
+    V3 v = dir0;
+    V3 a = accelAt(p);
+    V h = V::set1(0.0f); // Picked on the first iteration
+    V accR = V::set1(0.0f), accG = V::set1(0.0f), accB = V::set1(0.0f);
+    M active = M::firstN(rays.count);
+    M escaped = M::none();
+
+    const V zero = V::set1(0.0f);
+    const V one = V::set1(1.0f);
+    const V minStep = V::set1(Geodesic::MIN_STEP);
+    const V stepFactor = V::set1(params.stepFactor);
+    const V maxStepFactor = V::set1(Geodesic::RK_MAX_STEP_FACTOR);
+    const V diskStep = V::set1(Geodesic::RK_DISK_STEP);
+    const V escapeRadius = V::set1(Geodesic::ESCAPE_RADIUS);
+    const V maxDist = V::load(rays.maxDistance);
+    const V maxDist2 = maxDist * maxDist;
+    const V invTolerance = V::set1(1.0f / params.tolerance);
+
+    uint64_t steps = 0;
+    for (int i = 0; i < params.maxSteps && active.any(); i++) {
+        // Closest hole, horizons and how far the nearest disk is
+        V minR = V::set1(Geodesic::MAX_DIST);
+        V minDisk = V::set1(Geodesic::MAX_DIST);
+        M captured = M::none();
+        for (int j = 0; j < numBlackHoles; j++) {
+            const Geodesic::BlackHoleData& bh = blackHoles[j];
+            V tx = V::set1(bh.pos.x) - p.x;
+            V ty = V::set1(bh.pos.y) - p.y;
+            V tz = V::set1(bh.pos.z) - p.z;
+            V r = sqrt(tx * tx + ty * ty + tz * tz);
+            minR = min(minR, r);
+            V slab = abs(ty) - V::set1(Geodesic::DISK_HALF_THICKNESS);
+            minDisk = min(minDisk, max(slab, max(V::set1(bh.diskInner) - r, r - V::set1(bh.diskOuter))));
+            captured = captured | (r < V::set1(bh.rs));
+        }
+        active = active.andNot(captured);
+        M escaping = active & (minR > escapeRadius);
+        escaped = escaped | escaping;
+        active = active.andNot(escaping);
+        if (!active.any()) break;
+        steps += std::popcount(active.bits());
+
+        V firstStep = max(minStep, minR * stepFactor);
+        V maxStep = min(max(minStep, minR * maxStepFactor), max(diskStep, minDisk));
+        h = min(select(h > zero, h, firstStep), maxStep);
+
+        // Dormand-Prince stages for y = (p, v), y' = (v, a(p))
+        V3 v1 = v, a1 = a;
+        V3 v2 = v + h * (A21 * a1);
+        V3 a2 = accelAt(p + h * (A21 * v1));
+        V3 v3 = v + h * (A31 * a1 + A32 * a2);
+        V3 a3 = accelAt(p + h * (A31 * v1 + A32 * v2));
+        V3 v4 = v + h * (A41 * a1 + A42 * a2 + A43 * a3);
+        V3 a4 = accelAt(p + h * (A41 * v1 + A42 * v2 + A43 * v3));
+        V3 v5 = v + h * (A51 * a1 + A52 * a2 + A53 * a3 + A54 * a4);
+        V3 a5 = accelAt(p + h * (A51 * v1 + A52 * v2 + A53 * v3 + A54 * v4));
+        V3 v6 = v + h * (A61 * a1 + A62 * a2 + A63 * a3 + A64 * a4 + A65 * a5);
+        V3 a6 = accelAt(p + h * (A61 * v1 + A62 * v2 + A63 * v3 + A64 * v4 + A65 * v5));
+
+        V3 pNext = p + h * (B1 * v1 + B3 * v3 + B4 * v4 + B5 * v5 + B6 * v6);
+        V3 vNext = v + h * (B1 * a1 + B3 * a3 + B4 * a4 + B5 * a5 + B6 * a6);
+        V3 aNext = accelAt(pNext);
+
+        // Local error, position relative to the distance to the nearest hole
+        V errP = length(h * (E1 * v1 + E3 * v3 + E4 * v4 + E5 * v5 + E6 * v6 + E7 * vNext)) / minR;
+        V errV = length(h * (E1 * a1 + E3 * a3 + E4 * a4 + E5 * a5 + E6 * a6 + E7 * aNext));
+        V err = max(errP, errV) * invTolerance;
+
+        // Accept when within tolerance or already at the smallest step
+        M accepted = active.andNot((h > minStep).andNot(err < one));
+
+        accumulateDisks<V>(p.x, p.y, p.z, pNext.x, pNext.y, pNext.z, accepted, blackHoles, numBlackHoles, accR, accG, accB);
+        p = select<V>(accepted, pNext, p);
+        v = select<V>(accepted, vNext, v);
+        a = select<V>(accepted, aNext, a);
+
+        // Max Distance Check
+        V ox = p.x - origin.x;
+        V oy = p.y - origin.y;
+        V oz = p.z - origin.z;
+        M tooFar = accepted & ((ox * ox + oy * oy + oz * oz) > maxDist2);
+        escaped = escaped | tooFar;
+        active = active.andNot(tooFar);
+
+        // err == 0 gives an infinite scale, which the clamp turns into MAX_SCALE
+        V scale = V::set1(SAFETY) / sqrt(sqrt(err));
+        scale = min(max(scale, V::set1(MIN_SCALE)), V::set1(MAX_SCALE));
+        h = max(minStep, h * scale);
+    }
+
+    // Lanes that ran out of steps fall back to the sky like the scalar marcher
+    escaped = escaped | active;
+
+    V len = length(v);
+    resolvePacket<V>(accR, accG, accB, v.x / len, v.y / len, v.z / len, escaped, rays.count, outRGB, sky);
+    return steps;
+}
+
+// Runs every ray through Geodesic::skipToInfluence first. Rays that miss all
+// influence spheres are shaded right away; the rest are gathered, starting
+// where they enter a sphere, into full packets for the marchers.
+template <typename V>
+uint64_t traceRays(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ, int count,
+                   const Geodesic::BlackHoleData* blackHoles, int numBlackHoles, float* outRGB,
+                   const Geodesic::MarchParams& params, const Geodesic::Sky& sky, uint64_t* skippedRays)
+{
+    constexpr int W = V::Width;
+    PacketRays<W> rays;
+    int index[W];
+    alignas(64) float rgb[W * 3];
+
+    uint64_t steps = 0;
+    uint64_t skipped = 0;
+    auto flush = [&] {
+        rays.pad();
+        if (params.integrator == Geodesic::Integrator::Schwarzschild) {
+            steps += tracePacketSchwarzschild<V>(rays, blackHoles, numBlackHoles, rgb, params, sky);
+        } else {
+            steps += tracePacket<V>(rays, blackHoles, numBlackHoles, rgb, params, sky);
+        }
+        for (int k = 0; k < rays.count; ++k) {
+            std::copy(rgb + k * 3, rgb + k * 3 + 3, outRGB + index[k] * 3);
+        }
+        rays.count = 0;
+    };
+
+    for (int i = 0; i < count; ++i) {
+        Geodesic::RayState ray{ origin, glm::vec3(dirX[i], dirY[i], dirZ[i]), glm::vec3(0.0f) };
+        float jump = params.boundingSpheres ? Geodesic::skipToInfluence(ray, blackHoles, numBlackHoles, params) : 0.0f;
+        if (jump < 0.0f || jump >= params.maxDistance) {
+            glm::vec3 color = sky.sample(ray.dir);
+            outRGB[i * 3] = color.r;
+            outRGB[i * 3 + 1] = color.g;
+            outRGB[i * 3 + 2] = color.b;
+            skipped++;
+            continue;
+        }
+
+        int k = rays.count++;
+        rays.px[k] = ray.p.x; rays.py[k] = ray.p.y; rays.pz[k] = ray.p.z;
+        rays.dx[k] = ray.dir.x; rays.dy[k] = ray.dir.y; rays.dz[k] = ray.dir.z;
+        rays.maxDistance[k] = params.maxDistance - jump;
+        index[k] = i;
+        if (rays.count == W) flush();
+    }
+    if (rays.count > 0) flush();
+
+    if (skippedRays) *skippedRays += skipped;
+    return steps;
+}
+
+} // namespace detail
+} // namespace GeodesicPacket
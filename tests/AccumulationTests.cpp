@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "Accumulation.hpp"
+#include "Camera.hpp"
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+#include <glm/glm.hpp>
+
+TEST(AccumulationTest, FirstSampleIsPixelCentre) {
+    glm::vec2 jitter = Accumulation::jitter(0);
+    EXPECT_EQ(jitter.x, 0.0f);
+    EXPECT_EQ(jitter.y, 0.0f);
+}
+
+TEST(AccumulationTest, JitterStaysInsidePixel) {
+    for (int i = 1; i < 256; ++i) {
+        glm::vec2 jitter = Accumulation::jitter(i);
+        EXPECT_GE(jitter.x, -0.5f);
+        EXPECT_LT(jitter.x, 0.5f);
+        EXPECT_GE(jitter.y, -0.5f);
+        EXPECT_LT(jitter.y, 0.5f);
+    }
+}
+
+TEST(AccumulationTest, ConvergesOnStillView) {
+    Accumulation accumulation(4);
+    Camera camera;
+    World world;
+    Geodesic::MarchParams params;
+
+    EXPECT_TRUE(accumulation.update(camera, world, 64, 32, params));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(accumulation.isConverged());
+        EXPECT_FLOAT_EQ(accumulation.getBlendWeight(), 1.0f / (i + 1));
+        accumulation.addSample();
+        EXPECT_FALSE(accumulation.update(camera, world, 64, 32, params));
+    }
+    EXPECT_TRUE(accumulation.isConverged());
+}
+
+TEST(AccumulationTest, RestartsOnChange) {
+    Accumulation accumulation;
+    Camera camera;
+    World world;
+    Geodesic::MarchParams params;
+
+    accumulation.update(camera, world, 64, 32, params);
+    accumulation.addSample();
+
+    camera.moveForward(0.1f);
+    EXPECT_TRUE(accumulation.update(camera, world, 64, 32, params));
+    EXPECT_EQ(accumulation.getSampleCount(), 0);
+    accumulation.addSample();
+
+    world.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    EXPECT_TRUE(accumulation.update(camera, world, 64, 32, params));
+    accumulation.addSample();
+
+    params.maxSteps = 50;
+    EXPECT_TRUE(accumulation.update(camera, world, 64, 32, params));
+    accumulation.addSample();
+
+    EXPECT_TRUE(accumulation.update(camera, world, 128, 32, params));
+}
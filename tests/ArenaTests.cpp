@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include "Arena.hpp"
+#include <cstdint>
+
+TEST(ArenaTest, AllocationsAreAlignedAndDisjoint) {
+    Arena arena(256);
+    char* a = arena.allocate<char>(3);
+    float* b = arena.allocate<float>(10, 64);
+    double* c = arena.allocate<double>(4);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % alignof(double), 0u);
+    EXPECT_GE(reinterpret_cast<char*>(b), a + 3);
+    EXPECT_GE(reinterpret_cast<char*>(c), reinterpret_cast<char*>(b + 10));
+}
+
+TEST(ArenaTest, LargeRequestsGetTheirOwnBlock) {
+    Arena arena(256);
+    arena.allocate<char>(16);
+    float* big = arena.allocate<float>(1000, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 64, 0u);
+    big[999] = 1.0f; // Whole range is usable
+    EXPECT_GE(arena.bytesReserved(), 1000 * sizeof(float) + 256);
+    EXPECT_GE(arena.bytesUsed(), 1000 * sizeof(float) + 16);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytesReserved(), 0u);
+}
+
+TEST(ArenaTest, MemoryStaysPutWhenMoved) {
+    Arena arena;
+    int* values = arena.allocate<int>(4);
+    values[2] = 42;
+    Arena moved = std::move(arena);
+    EXPECT_EQ(values[2], 42);
+    EXPECT_GT(moved.bytesUsed(), 0u);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "CameraPath.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+CameraPath::Keyframe key(float time, float x, float yaw, float fov = 45.0f) {
+    return { time, { glm::vec3(x, 0.0f, 0.0f), yaw, 0.0f, fov } };
+}
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("camerapath_test_" + name)).string();
+}
+
+void writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream file(path);
+    file << contents;
+}
+
+} // namespace
+
+TEST(CameraPathTest, PassesThroughKeyframes) {
+    CameraPath path;
+    path.addKeyframe(key(2.0f, 5.0f, 30.0f, 60.0f));
+    path.addKeyframe(key(0.0f, 0.0f, -90.0f));
+    path.addKeyframe(key(3.5f, -4.0f, 120.0f));
+    ASSERT_EQ(path.getKeyframes().size(), 3u);
+    EXPECT_EQ(path.getKeyframes()[1].time, 2.0f); // Kept in time order
+
+    for (const CameraPath::Keyframe& k : path.getKeyframes()) {
+        CameraPose pose = path.evaluate(k.time);
+        EXPECT_FLOAT_EQ(pose.position.x, k.pose.position.x);
+        EXPECT_FLOAT_EQ(pose.yaw, k.pose.yaw);
+        EXPECT_FLOAT_EQ(pose.fov, k.pose.fov);
+    }
+}
+
+TEST(CameraPathTest, HoldsStillOutsideTheKeys) {
+    CameraPath path;
+    path.addKeyframe(key(1.0f, 2.0f, 10.0f));
+    path.addKeyframe(key(3.0f, 8.0f, 50.0f));
+    EXPECT_EQ(path.evaluate(-5.0f).position.x, 2.0f);
+    EXPECT_EQ(path.evaluate(9.0f).yaw, 50.0f);
+    EXPECT_EQ(CameraPath().evaluate(1.0f).yaw, CameraPose().yaw);
+}
+
+TEST(CameraPathTest, EvenMotionStaysEven) {
+    // Keys on a line at a constant rate, unevenly spaced in time: no surging between them
+    CameraPath path;
+    path.addKeyframe(key(0.0f, 0.0f, 0.0f));
+    path.addKeyframe(key(1.0f, 2.0f, 10.0f));
+    path.addKeyframe(key(4.0f, 8.0f, 40.0f));
+    path.addKeyframe(key(5.0f, 10.0f, 50.0f));
+    for (float t = 0.0f; t <= 5.0f; t += 0.25f) {
+        CameraPose pose = path.evaluate(t);
+        EXPECT_NEAR(pose.position.x, 2.0f * t, 1e-4f) << t;
+        EXPECT_NEAR(pose.yaw, 10.0f * t, 1e-3f) << t;
+    }
+}
+
+TEST(CameraPathTest, CurvesSmoothlyThroughKeys) {
+    CameraPath path;
+    path.addKeyframe(key(0.0f, 0.0f, 0.0f));
+    path.addKeyframe(key(1.0f, 1.0f, 0.0f));
+    path.addKeyframe(key(2.0f, 0.0f, 0.0f));
+    // Eases over the middle key instead of reversing sharply
+    EXPECT_GT(path.evaluate(0.9f).position.x, 0.9f);
+    EXPECT_LE(path.evaluate(1.0f).position.x, 1.0f + 1e-6f);
+    EXPECT_NEAR(path.evaluate(0.9f).position.x, path.evaluate(1.1f).position.x, 1e-5f);
+}
+
+TEST(CameraPathTest, FramesCoverThePath) {
+    CameraPath path;
+    path.addKeyframe(key(0.5f, 0.0f, 0.0f));
+    path.addKeyframe(key(2.5f, 1.0f, 0.0f));
+    EXPECT_EQ(path.frameCount(30.0f), 61);
+    EXPECT_FLOAT_EQ(path.frameTime(0, 30.0f), 0.5f);
+    EXPECT_FLOAT_EQ(path.frameTime(60, 30.0f), 2.5f);
+    EXPECT_EQ(CameraPath().frameCount(30.0f), 0);
+}
+
+TEST(CameraPathTest, PoseBecomesCamera) {
+    CameraPose pose{ glm::vec3(1.0f, 2.0f, 3.0f), 0.0f, 0.0f, 60.0f };
+    Camera camera = pose.toCamera();
+    EXPECT_EQ(camera.position, pose.position);
+    EXPECT_EQ(camera.zoom, 60.0f);
+    EXPECT_NEAR(camera.front.x, 1.0f, 1e-6f); // Yaw 0 looks down +X
+}
+
+TEST(CameraPathTest, LoadsKeyFiles) {
+    std::string path = tempPath("orbit.path");
+    writeFile(path, "# TIME X Y Z YAW PITCH FOV\n"
+                    "key 0 0 0 3 -90 0 45\n"
+                    "\n"
+                    "key 2.5 1 2 3 -45 -10 50  # Second\n");
+    CameraPath loaded;
+    ASSERT_TRUE(CameraPath::load(path, loaded));
+    ASSERT_EQ(loaded.getKeyframes().size(), 2u);
+    const CameraPath::Keyframe& second = loaded.getKeyframes()[1];
+    EXPECT_EQ(second.time, 2.5f);
+    EXPECT_EQ(second.pose.position, glm::vec3(1.0f, 2.0f, 3.0f));
+    EXPECT_EQ(second.pose.pitch, -10.0f);
+    EXPECT_EQ(second.pose.fov, 50.0f);
+
+    for (const char* contents : { "key 0 0 0 3 -90 0\n", "key 0 0 0 3 -90 0 x\n", "camera 0 0 0 3 -90 0 45\n" }) {
+        writeFile(path, contents);
+        CameraPath bad;
+        EXPECT_FALSE(CameraPath::load(path, bad)) << contents;
+    }
+    CameraPath missing;
+    EXPECT_FALSE(CameraPath::load(tempPath("missing.path"), missing));
+    std::remove(path.c_str());
+}
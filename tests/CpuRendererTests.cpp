@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "CpuRenderer.hpp"
+#include "objects/BlackHole.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+TEST(CpuRendererTest, TilesCoverTheWholeImage) {
+    CpuRenderer renderer(2, 16);
+    Camera camera;
+    World world;
+
+    renderer.render(camera, world, 70, 33);
+
+    int coveredPixels = 0;
+    for (const auto& tile : renderer.getTileStats()) {
+        coveredPixels += tile.width * tile.height;
+        EXPECT_LE(tile.x + tile.width, 70);
+        EXPECT_LE(tile.y + tile.height, 33);
+    }
+    EXPECT_EQ(renderer.getTileStats().size(), 5u * 3u);
+    EXPECT_EQ(coveredPixels, 70 * 33);
+    EXPECT_EQ(renderer.getPixelBuffer().size(), 70u * 33u * 3u);
+}
+
+TEST(CpuRendererTest, TonemapQuantizesEveryPixel) {
+    CpuRenderer renderer(2, 16);
+    Camera camera;
+    World world;
+    world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+    renderer.render(camera, world, 40, 37);
+
+    const auto& pixels = renderer.getPixelBuffer();
+    std::vector<uint32_t> texels(40 * 37);
+    for (auto format : { CpuRenderer::DisplayFormat::RGBA8, CpuRenderer::DisplayFormat::RGB10A2 }) {
+        bool tenBit = format == CpuRenderer::DisplayFormat::RGB10A2;
+        int bits = tenBit ? 10 : 8;
+        uint32_t channelMask = (1u << bits) - 1;
+        renderer.tonemap(format, texels.data());
+        for (size_t i = 0; i < texels.size(); ++i) {
+            EXPECT_EQ(texels[i] >> (3 * bits), tenBit ? 3u : 255u);
+            for (int c = 0; c < 3; ++c) {
+                float expected = std::clamp(pixels[i * 3 + c], 0.0f, 1.0f) * channelMask;
+                EXPECT_NEAR(static_cast<float>((texels[i] >> (c * bits)) & channelMask), expected, 0.5f);
+            }
+        }
+    }
+}
+
+TEST(CpuRendererTest, RegionMatchesTheWholeFrame) {
+    CpuRenderer renderer(2, 16);
+    Camera camera;
+    World world;
+    world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+    renderer.render(camera, world, 70, 33);
+    std::vector<float> frame = renderer.getPixelBuffer();
+
+    CpuRenderer::Region region{ 21, 9, 30, 17 };
+    renderer.renderRegion(camera, world, 70, 33, region);
+    EXPECT_EQ(renderer.getWidth(), 30);
+    EXPECT_EQ(renderer.getHeight(), 17);
+    const auto& pixels = renderer.getPixelBuffer();
+    ASSERT_EQ(pixels.size(), 30u * 17u * 3u);
+    for (int y = 0; y < region.height; ++y) {
+        for (int x = 0; x < region.width * 3; ++x) {
+            ASSERT_EQ(pixels[y * region.width * 3 + x], frame[((y + region.y) * 70 + region.x) * 3 + x]);
+        }
+    }
+    for (const auto& tile : renderer.getTileStats()) {
+        EXPECT_GE(tile.x, region.x);
+        EXPECT_GE(tile.y, region.y);
+        EXPECT_LE(tile.x + tile.width, region.x + region.width);
+        EXPECT_LE(tile.y + tile.height, region.y + region.height);
+    }
+}
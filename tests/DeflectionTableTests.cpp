@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "DeflectionTable.hpp"
+#include "ThreadPool.hpp"
+#include <cmath>
+
+namespace {
+
+// One table for the whole suite; integrating it takes a moment
+const DeflectionTable& sharedTable() {
+    static ThreadPool pool;
+    static DeflectionTable table(1.0f, Geodesic::MarchParams(), &pool);
+    return table;
+}
+
+} // namespace
+
+TEST(DeflectionTableTest, MatchesMarchedRays) {
+    // A fan of rays around a hole without a disk, none of which falls on a table sample
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, -10.0f, -50.0f), 1.0f, 0.0f, 0.0f };
+    glm::vec3 ro(0.0f, 0.0f, 3.0f);
+
+    int shaded = 0;
+    int mismatches = 0;
+    for (int j = 0; j < 40; ++j) {
+        for (int i = 0; i < 40; ++i) {
+            glm::vec3 rd = glm::normalize(glm::vec3((i - 19.5f) * 0.004f, (j - 19.5f) * 0.004f - 0.2f, -1.0f));
+            glm::vec3 color;
+            ASSERT_TRUE(sharedTable().shade(ro, rd, bh, color));
+            shaded++;
+
+            // Interpolation may move a star across a cell boundary now and then
+            glm::vec3 reference = Geodesic::traceGeodesic(ro, rd, &bh, 1);
+            if (glm::length(color - reference) > 0.05f) mismatches++;
+        }
+    }
+    EXPECT_LT(mismatches, shaded / 50);
+}
+
+TEST(DeflectionTableTest, ShadowIsBlack) {
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, 0.0f, -50.0f), 1.0f, 0.0f, 0.0f };
+    glm::vec3 color(1.0f);
+    ASSERT_TRUE(sharedTable().shade(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), bh, color));
+    EXPECT_FLOAT_EQ(color.r, 0.0f);
+    EXPECT_FLOAT_EQ(color.g, 0.0f);
+    EXPECT_FLOAT_EQ(color.b, 0.0f);
+}
+
+TEST(DeflectionTableTest, WeakFieldDeflection) {
+    // Far from the hole an inbound ray is bent by ~2 rs / b over its whole path
+    float b = 40.0f;
+    DeflectionTable::Sample sample = sharedTable().lookup(4000.0f, b, false);
+    EXPECT_NEAR(sample.deflection, 2.0f / b, 0.1f * 2.0f / b);
+    EXPECT_FLOAT_EQ(sample.transmittance, 1.0f);
+}
+
+TEST(DeflectionTableTest, DiskRaysAreMarched) {
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, -10.0f, -50.0f), 1.0f, 3.0f, 9.0f };
+    glm::vec3 ro(0.0f, 0.0f, 3.0f);
+    glm::vec3 color;
+    EXPECT_FALSE(sharedTable().shade(ro, glm::normalize(bh.pos - ro), bh, color));
+    EXPECT_TRUE(sharedTable().shade(ro, glm::vec3(0.0f, 0.0f, -1.0f), bh, color));
+    // Heading away from the hole never reaches its disk
+    EXPECT_TRUE(sharedTable().shade(ro, glm::normalize(ro - bh.pos), bh, color));
+}
+
+TEST(DeflectionTableTest, CacheKeepsOneTablePerHoleSize) {
+    Geodesic::MarchParams params;
+    params.maxSteps = 20; // Only the bookkeeping is under test
+    DeflectionCache cache(2);
+
+    auto small = cache.get(1.0f, params);
+    EXPECT_EQ(cache.get(1.0f, params), small);
+    auto large = cache.get(2.0f, params);
+    EXPECT_NE(large, small);
+    EXPECT_EQ(cache.size(), 2u);
+
+    // A third size evicts the least recently used one
+    cache.get(1.0f, params);
+    cache.get(3.0f, params);
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.get(1.0f, params), small);
+    EXPECT_NE(cache.get(2.0f, params), large);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "Accumulation.hpp"
+#include "Distributed.hpp"
+#include "SceneFile.hpp"
+#include "objects/BlackHole.hpp"
+#include <chrono>
+#include <limits>
+#include <map>
+#include <thread>
+
+namespace {
+
+Distributed::Job makeJob(const World& world) {
+    Distributed::Job job;
+    job.width = 48;
+    job.height = 30;
+    job.samples = 2;
+    job.unitSize = 16;
+    job.bakedSky = false; // Keeps the test away from the sky cache on disk
+    job.skySize = 64;
+    job.frames.push_back({ glm::vec3(0.0f, 0.0f, 3.0f), -90.0f, 0.0f, 45.0f });
+    job.frames.push_back({ glm::vec3(0.0f, 1.0f, 3.0f), -80.0f, -5.0f, 45.0f });
+    job.scene = SceneFile::encodeBinary(world);
+    return job;
+}
+
+World makeScene() {
+    World world;
+    world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+    return world;
+}
+
+// What the headless renderer would make of the frame in one process
+std::vector<float> renderLocally(const Distributed::Job& job, const World& world, int frame) {
+    CpuRenderer renderer(2);
+    renderer.setMarchParams(job.marchParams);
+    renderer.setSky(job.skyParams, nullptr);
+    Camera camera = job.frames[frame].toCamera();
+    for (int sample = 0; sample < job.samples; ++sample) {
+        renderer.render(camera, world, job.width, job.height, Accumulation::jitter(sample), 1.0f / (sample + 1));
+    }
+    return renderer.getPixelBuffer();
+}
+
+// Runs a worker against the coordinator on its own thread
+struct WorkerThread {
+    CpuRenderer renderer{ 2 };
+    Distributed::Worker worker{ renderer, "" };
+    bool finished = false;
+    std::thread thread;
+
+    void start(uint16_t port) {
+        thread = std::thread([this, port] { finished = worker.run("127.0.0.1", port); });
+    }
+};
+
+} // namespace
+
+TEST(DistributedTest, JobRoundTrips) {
+    Distributed::Job job = makeJob(makeScene());
+    job.marchParams.integrator = Geodesic::Integrator::Newtonian;
+    job.marchParams.boundingSpheres = false;
+    job.deflectionLut = true;
+    job.skyParams.starDensity = 0.9f;
+
+    Distributed::Job decoded;
+    ASSERT_TRUE(Distributed::Job::decode(job.encode(), decoded));
+    EXPECT_EQ(decoded.width, job.width);
+    EXPECT_EQ(decoded.height, job.height);
+    EXPECT_EQ(decoded.samples, job.samples);
+    EXPECT_EQ(decoded.unitSize, job.unitSize);
+    EXPECT_EQ(decoded.marchParams, job.marchParams);
+    EXPECT_TRUE(decoded.deflectionLut);
+    EXPECT_EQ(decoded.skyParams, job.skyParams);
+    EXPECT_FALSE(decoded.bakedSky);
+    ASSERT_EQ(decoded.frames.size(), 2u);
+    EXPECT_EQ(decoded.frames[1].position, job.frames[1].position);
+    EXPECT_EQ(decoded.frames[1].yaw, job.frames[1].yaw);
+    EXPECT_EQ(decoded.scene, job.scene);
+
+    // Anything cut short is rejected
+    std::vector<unsigned char> truncated = job.encode();
+    truncated.pop_back();
+    EXPECT_FALSE(Distributed::Job::decode(truncated, decoded));
+}
+
+TEST(DistributedTest, AssemblesFramesFromWorkers) {
+    World world = makeScene();
+    Distributed::Job job = makeJob(world);
+    std::map<int, std::vector<float>> frames;
+    Distributed::Coordinator coordinator(job, [&](int frame, const std::vector<float>& pixels) {
+        frames[frame] = pixels;
+        return true;
+    });
+    // A worker thread stalled by a busy machine would otherwise get its unit duplicated
+    coordinator.setSlowUnitThreshold(Distributed::SLOW_UNIT_FACTOR, std::numeric_limits<double>::infinity());
+    ASSERT_TRUE(coordinator.listen(0));
+    EXPECT_EQ(coordinator.getUnitCount(), 2 * 3 * 2);
+
+    WorkerThread workers[2];
+    for (WorkerThread& worker : workers) worker.start(coordinator.getPort());
+    EXPECT_TRUE(coordinator.run());
+    for (WorkerThread& worker : workers) {
+        worker.thread.join();
+        EXPECT_TRUE(worker.finished);
+    }
+    EXPECT_EQ(workers[0].worker.getUnitsRendered() + workers[1].worker.getUnitsRendered(), 12);
+
+    // Every unit traces exactly the rays of the whole frame, so the result is bit for bit the same
+    ASSERT_EQ(frames.size(), 2u);
+    for (int frame = 0; frame < 2; ++frame) {
+        EXPECT_EQ(frames[frame], renderLocally(job, world, frame)) << "frame " << frame;
+    }
+    EXPECT_EQ(coordinator.getStats().workersConnected, 2);
+    EXPECT_EQ(coordinator.getStats().unitsRequeued, 0u);
+    EXPECT_EQ(coordinator.getStats().unitsDuplicated, 0u);
+}
+
+TEST(DistributedTest, RequeuesUnitsOfLostWorkers) {
+    World world = makeScene();
+    Distributed::Job job = makeJob(world);
+    std::map<int, std::vector<float>> frames;
+    Distributed::Coordinator coordinator(job, [&](int frame, const std::vector<float>& pixels) {
+        frames[frame] = pixels;
+        return true;
+    });
+    ASSERT_TRUE(coordinator.listen(0));
+    std::thread serving([&] { EXPECT_TRUE(coordinator.run()); });
+
+    // Returns one unit and disappears with the next
+    WorkerThread dropped;
+    dropped.worker.setUnitLimit(1);
+    dropped.start(coordinator.getPort());
+    dropped.thread.join();
+    EXPECT_EQ(dropped.worker.getUnitsRendered(), 1);
+
+    WorkerThread healthy;
+    healthy.start(coordinator.getPort());
+    healthy.thread.join();
+    serving.join();
+    EXPECT_TRUE(healthy.finished);
+    EXPECT_EQ(healthy.worker.getUnitsRendered(), 11);
+
+    EXPECT_EQ(coordinator.getStats().workersLost, 1);
+    EXPECT_EQ(coordinator.getStats().unitsRequeued, 1u);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0], renderLocally(job, world, 0));
+}
+
+TEST(DistributedTest, DuplicatesUnitsOfSlowWorkers) {
+    World world = makeScene();
+    Distributed::Job job = makeJob(world);
+    std::map<int, std::vector<float>> frames;
+    Distributed::Coordinator coordinator(job, [&](int frame, const std::vector<float>& pixels) {
+        frames[frame] = pixels;
+        return true;
+    });
+    ASSERT_TRUE(coordinator.listen(0));
+    std::thread serving([&] { EXPECT_TRUE(coordinator.run()); });
+
+    // Takes a unit first and then sits on it
+    constexpr auto delay = std::chrono::milliseconds(1500);
+    WorkerThread slow;
+    slow.worker.setUnitDelay(delay);
+    slow.start(coordinator.getPort());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    WorkerThread fast;
+    fast.start(coordinator.getPort());
+    serving.join();
+    fast.thread.join();
+    slow.thread.join();
+
+    EXPECT_TRUE(fast.finished);
+    EXPECT_EQ(fast.worker.getUnitsRendered(), 12);
+    // Whichever copy of the slow unit lost, it was thrown away rather than used twice
+    const Distributed::Coordinator::Stats& stats = coordinator.getStats();
+    EXPECT_GE(stats.unitsDuplicated, 1u);
+    EXPECT_EQ(stats.unitsDiscarded, stats.unitsDuplicated);
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0], renderLocally(job, world, 0));
+    EXPECT_EQ(frames[1], renderLocally(job, world, 1));
+}
+
+TEST(DistributedTest, KeepsToTheFrameWindow) {
+    World world = makeScene();
+    Distributed::Job job = makeJob(world);
+    job.frames.push_back(job.frames[0]);
+    job.frames.push_back(job.frames[1]);
+    std::vector<int> order;
+    Distributed::Coordinator coordinator(job, [&](int frame, const std::vector<float>&) {
+        order.push_back(frame);
+        return true;
+    });
+    // With a window of one frame nothing of the next frame starts until the sink has the last
+    coordinator.setFrameWindow(1);
+    ASSERT_TRUE(coordinator.listen(0));
+
+    WorkerThread workers[2];
+    for (WorkerThread& worker : workers) worker.start(coordinator.getPort());
+    EXPECT_TRUE(coordinator.run());
+    for (WorkerThread& worker : workers) {
+        worker.thread.join();
+        EXPECT_TRUE(worker.finished);
+    }
+    EXPECT_EQ(order, (std::vector<int>{ 0, 1, 2, 3 }));
+}
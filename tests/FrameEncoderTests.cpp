@@ -0,0 +1,343 @@
+#include <gtest/gtest.h>
+#include "Deflate.hpp"
+#include "FrameEncoder.hpp"
+#include "ImageWriter.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <random>
+#include <string>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("frameencoder_test_" + name)).string();
+}
+
+std::vector<unsigned char> readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Enough of inflate for the stored and fixed-code blocks Deflate writes
+class Inflater {
+public:
+    explicit Inflater(const std::vector<unsigned char>& data) : data(data) {}
+
+    bool run(std::vector<unsigned char>& out) {
+        static const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                              3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                               513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        if (data.size() < 6 || data[0] != 0x78 || (data[0] * 256 + data[1]) % 31 != 0) return false;
+        pos = 2;
+        bool last = false;
+        while (!last) {
+            last = bits(1);
+            int type = bits(2);
+            if (type == 0) {
+                if (used > 0) { // Skip to the byte boundary
+                    used = 0;
+                    ++pos;
+                }
+                int length = data[pos] | (data[pos + 1] << 8);
+                pos += 4;
+                out.insert(out.end(), data.begin() + pos, data.begin() + pos + length);
+                pos += length;
+            } else if (type == 1) {
+                while (true) {
+                    int symbol = literalLength();
+                    if (symbol < 256) {
+                        out.push_back(static_cast<unsigned char>(symbol));
+                        continue;
+                    }
+                    if (symbol == 256) break;
+                    int length = LENGTH_BASE[symbol - 257] + bits(LENGTH_EXTRA[symbol - 257]);
+                    int code = 0;
+                    for (int i = 0; i < 5; ++i) code = (code << 1) | bits(1);
+                    size_t distance = DISTANCE_BASE[code] + bits(DISTANCE_EXTRA[code]);
+                    if (distance > out.size()) return false;
+                    for (int i = 0; i < length; ++i) out.push_back(out[out.size() - distance]);
+                }
+            } else {
+                return false;
+            }
+        }
+        if (used > 0) ++pos;
+        uint32_t check = 0;
+        for (int i = 0; i < 4; ++i) check = (check << 8) | data[pos + i];
+        return pos + 4 == data.size() && check == Deflate::adler32(out.data(), out.size());
+    }
+
+private:
+    const std::vector<unsigned char>& data;
+    size_t pos = 0;
+    int used = 0; // Bits taken from data[pos]
+
+    int bits(int count) {
+        int value = 0;
+        for (int i = 0; i < count; ++i) {
+            value |= ((data[pos] >> used) & 1) << i;
+            if (++used == 8) {
+                used = 0;
+                ++pos;
+            }
+        }
+        return value;
+    }
+
+    int literalLength() {
+        int code = 0;
+        for (int length = 1; length <= 9; ++length) {
+            code = (code << 1) | bits(1);
+            if (length == 7 && code <= 0x17) return 256 + code;
+            if (length == 8 && code >= 0x30 && code <= 0xbf) return code - 0x30;
+            if (length == 8 && code >= 0xc0 && code <= 0xc7) return 280 + code - 0xc0;
+            if (length == 9) return 144 + code - 0x190;
+        }
+        return -1;
+    }
+};
+
+std::vector<unsigned char> inflate(const std::vector<unsigned char>& compressed) {
+    std::vector<unsigned char> out;
+    EXPECT_TRUE(Inflater(compressed).run(out));
+    return out;
+}
+
+uint32_t bigEndian32(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// A small frame whose pixels tell apart rows, columns and channels
+std::vector<float> testFrame(int width, int height, float offset = 0.0f) {
+    std::vector<float> pixels(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float* p = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+            p[0] = offset + static_cast<float>(x) / width;
+            p[1] = static_cast<float>(y) / height;
+            p[2] = 0.5f;
+        }
+    }
+    return pixels;
+}
+
+std::vector<float> flatFrame(int width, int height, float value) {
+    return std::vector<float>(static_cast<size_t>(width) * height * 3, value);
+}
+
+} // namespace
+
+TEST(DeflateTest, RoundTripsAndShrinksRepetitiveData) {
+    std::vector<unsigned char> data;
+    for (int i = 0; i < 100000; ++i) data.push_back(static_cast<unsigned char>((i % 37) * 7));
+    std::vector<unsigned char> compressed;
+    Deflate::compress(data.data(), data.size(), compressed);
+    EXPECT_LT(compressed.size(), data.size() / 20);
+    EXPECT_EQ(inflate(compressed), data);
+}
+
+TEST(DeflateTest, StoresIncompressibleData) {
+    std::mt19937 random(7);
+    std::vector<unsigned char> data(200000);
+    for (unsigned char& byte : data) byte = static_cast<unsigned char>(random());
+    std::vector<unsigned char> compressed;
+    Deflate::compress(data.data(), data.size(), compressed);
+    // Header, four stored blocks of 5 bytes overhead each and the checksum
+    EXPECT_EQ(compressed.size(), data.size() + 2 + 4 * 5 + 4);
+    EXPECT_EQ(inflate(compressed), data);
+
+    compressed.clear();
+    Deflate::compress(nullptr, 0, compressed);
+    EXPECT_TRUE(inflate(compressed).empty());
+}
+
+TEST(ImageWriterTest, PngHoldsTheQuantizedPixels) {
+    const int width = 21, height = 13;
+    std::vector<float> pixels = testFrame(width, height);
+    for (int bitDepth : { 8, 16 }) {
+        std::vector<unsigned char> png;
+        ImageWriter::encode(ImageWriter::Format::PNG, pixels, width, height, bitDepth, png);
+        ASSERT_GT(png.size(), 8u + 25u + 12u);
+        EXPECT_EQ(png[1], 'P');
+        EXPECT_EQ(bigEndian32(&png[16]), static_cast<uint32_t>(width));
+        EXPECT_EQ(bigEndian32(&png[20]), static_cast<uint32_t>(height));
+        EXPECT_EQ(png[24], bitDepth);
+
+        uint32_t idatSize = bigEndian32(&png[33]);
+        ASSERT_EQ(std::string(png.begin() + 37, png.begin() + 41), "IDAT");
+        std::vector<unsigned char> filtered = inflate(std::vector<unsigned char>(png.begin() + 41, png.begin() + 41 + idatSize));
+
+        // Undo the filters and compare every sample, top row first
+        int pixelBytes = 3 * bitDepth / 8;
+        size_t rowBytes = static_cast<size_t>(width) * pixelBytes;
+        ASSERT_EQ(filtered.size(), (rowBytes + 1) * height);
+        std::vector<unsigned char> previous(rowBytes, 0), row(rowBytes);
+        float maxValue = bitDepth == 16 ? 65535.0f : 255.0f;
+        for (int y = 0; y < height; ++y) {
+            int filter = filtered[y * (rowBytes + 1)];
+            for (size_t i = 0; i < rowBytes; ++i) {
+                int left = i >= static_cast<size_t>(pixelBytes) ? row[i - pixelBytes] : 0;
+                int up = previous[i];
+                int upLeft = i >= static_cast<size_t>(pixelBytes) ? previous[i - pixelBytes] : 0;
+                int p = left + up - upLeft;
+                int paeth = (std::abs(p - left) <= std::abs(p - up) && std::abs(p - left) <= std::abs(p - upLeft))
+                    ? left : (std::abs(p - up) <= std::abs(p - upLeft) ? up : upLeft);
+                int predicted[5] = { 0, left, up, (left + up) / 2, paeth };
+                row[i] = static_cast<unsigned char>(filtered[y * (rowBytes + 1) + 1 + i] + predicted[filter]);
+            }
+            for (int i = 0; i < width * 3; ++i) {
+                int value = bitDepth == 16 ? (row[i * 2] << 8) | row[i * 2 + 1] : row[i];
+                float expected = pixels[static_cast<size_t>(height - 1 - y) * width * 3 + i] * maxValue + 0.5f;
+                ASSERT_EQ(value, static_cast<int>(expected)) << "row " << y << ", sample " << i;
+            }
+            previous = row;
+        }
+    }
+}
+
+TEST(ImageWriterTest, ExrKeepsHdrValuesAtHalfPrecision) {
+    const int width = 5, height = 20; // Two chunks, the second one short
+    std::vector<float> pixels = testFrame(width, height, 100.0f);
+    std::vector<unsigned char> exr;
+    ImageWriter::encode(ImageWriter::Format::EXR, pixels, width, height, 8, exr);
+    ASSERT_GT(exr.size(), 8u);
+    EXPECT_EQ(exr[0], 0x76);
+    EXPECT_EQ(exr[1], 0x2f);
+    EXPECT_EQ(exr[2], 0x31);
+    EXPECT_EQ(exr[3], 0x01);
+
+    // Header ends with an empty attribute name, before the two chunk offsets
+    std::string text(exr.begin(), exr.end());
+    size_t tableAt = text.find("screenWindowWidth");
+    ASSERT_NE(tableAt, std::string::npos);
+    tableAt += sizeof("screenWindowWidth") + sizeof("float") + 4 + 4 + 1;
+    uint64_t offsets[2];
+    std::memcpy(offsets, &exr[tableAt], sizeof(offsets));
+    EXPECT_EQ(offsets[0], tableAt + sizeof(offsets));
+
+    int32_t firstRow, size;
+    std::memcpy(&firstRow, &exr[offsets[1]], 4);
+    std::memcpy(&size, &exr[offsets[1] + 4], 4);
+    EXPECT_EQ(firstRow, 16);
+    EXPECT_EQ(offsets[1] + 8 + size, exr.size());
+
+    // Undo the first chunk's compression: inflate, integrate the deltas and interleave the halves' bytes again
+    std::memcpy(&size, &exr[offsets[0] + 4], 4);
+    std::vector<unsigned char> chunk(exr.begin() + offsets[0] + 8, exr.begin() + offsets[0] + 8 + size);
+    size_t rawSize = 16 * width * 3 * sizeof(uint16_t);
+    std::vector<unsigned char> raw(rawSize);
+    if (chunk.size() < rawSize) {
+        std::vector<unsigned char> predicted = inflate(chunk);
+        ASSERT_EQ(predicted.size(), rawSize);
+        for (size_t i = 1; i < rawSize; ++i) predicted[i] = static_cast<unsigned char>(predicted[i - 1] + predicted[i] - 128);
+        for (size_t i = 0; i < rawSize; ++i) raw[i] = predicted[(i & 1) ? rawSize / 2 + i / 2 : i / 2];
+    } else {
+        raw = chunk;
+    }
+
+    // Rows hold B, G and R in turn, top row first
+    for (int row = 0; row < 16; ++row) {
+        for (int channel = 0; channel < 3; ++channel) {
+            for (int x = 0; x < width; ++x) {
+                uint16_t half;
+                std::memcpy(&half, &raw[((row * 3 + channel) * width + x) * sizeof(half)], sizeof(half));
+                float expected = pixels[(static_cast<size_t>(height - 1 - row) * width + x) * 3 + (2 - channel)];
+                ASSERT_NEAR(glm::unpackHalf1x16(half), expected, std::abs(expected) * 1e-3f);
+            }
+        }
+    }
+}
+
+TEST(ImageWriterTest, YuvOfGreyHasNeutralChroma) {
+    const int width = 5, height = 3; // Odd sizes round the chroma planes up
+    std::vector<unsigned char> yuv;
+    ImageWriter::encode(ImageWriter::Format::YUV, flatFrame(width, height, 0.5f), width, height, 8, yuv);
+    ASSERT_EQ(yuv.size(), 15u + 2 * 3 * 2);
+    for (int i = 0; i < 15; ++i) EXPECT_EQ(yuv[i], 126); // 16 + 219 * 0.5, rounded
+    for (size_t i = 15; i < yuv.size(); ++i) EXPECT_EQ(yuv[i], 128);
+
+    // Video range: black and white stop at 16 and 235, 16-bit samples are shifted up a byte
+    ImageWriter::encode(ImageWriter::Format::YUV, flatFrame(width, height, 2.0f), width, height, 16, yuv);
+    ASSERT_EQ(yuv.size(), 2 * (15u + 2 * 3 * 2));
+    EXPECT_EQ(yuv[0] | (yuv[1] << 8), 235 * 256);
+    EXPECT_EQ(yuv[30] | (yuv[31] << 8), 128 * 256);
+}
+
+TEST(FrameEncoderTest, WritesFilesOnItsThreads) {
+    const int width = 8, height = 6;
+    FrameEncoder::Settings settings;
+    settings.output = tempPath("%d.ppm");
+    settings.threads = 3;
+    FrameEncoder encoder(width, height, settings);
+    ASSERT_TRUE(encoder.open());
+    EXPECT_FALSE(encoder.isStream());
+    for (int frame = 0; frame < 10; ++frame) {
+        ASSERT_TRUE(encoder.submit(frame, testFrame(width, height, frame * 0.01f)));
+    }
+    EXPECT_TRUE(encoder.finish());
+    EXPECT_EQ(encoder.getStats().framesWritten, 10);
+
+    for (int frame = 0; frame < 10; ++frame) {
+        std::string path = FrameEncoder::framePath(settings.output, frame);
+        std::vector<unsigned char> expected;
+        ImageWriter::encode(ImageWriter::Format::PPM, testFrame(width, height, frame * 0.01f), width, height, 8, expected);
+        EXPECT_EQ(readFile(path), expected) << path;
+        std::remove(path.c_str());
+    }
+}
+
+TEST(FrameEncoderTest, WritesStreamsInFrameOrder) {
+    const int width = 4, height = 2;
+    FrameEncoder::Settings settings;
+    settings.output = tempPath("stream.rgb");
+    settings.queueDepth = 3;
+    FrameEncoder encoder(width, height, settings);
+    ASSERT_TRUE(encoder.open());
+    EXPECT_TRUE(encoder.isStream());
+    // Out of order, as distributed frames can finish
+    for (int frame : { 1, 0, 3, 2, 4 }) {
+        ASSERT_TRUE(encoder.submit(frame, flatFrame(width, height, frame / 255.0f)));
+    }
+    EXPECT_TRUE(encoder.finish());
+
+    std::vector<unsigned char> stream = readFile(settings.output);
+    ASSERT_EQ(stream.size(), 5u * width * height * 3);
+    for (size_t i = 0; i < stream.size(); ++i) {
+        ASSERT_EQ(stream[i], i / (width * height * 3)) << "byte " << i;
+    }
+    std::remove(settings.output.c_str());
+}
+
+TEST(FrameEncoderTest, SubmitWaitsForAFreeSlot) {
+    const int width = 4, height = 2;
+    FrameEncoder::Settings settings;
+    settings.output = tempPath("wait.rgb");
+    settings.queueDepth = 2;
+    FrameEncoder encoder(width, height, settings);
+    ASSERT_TRUE(encoder.open());
+
+    // Both slots end up holding frames the stream can't write before frame 0,
+    // so the queue stays full however long the caller keeps submitting
+    ASSERT_TRUE(encoder.submit(1, flatFrame(width, height, 0.0f)));
+    ASSERT_TRUE(encoder.submit(2, flatFrame(width, height, 0.0f)));
+    auto third = std::async(std::launch::async, [&] { return encoder.submit(3, flatFrame(width, height, 0.0f)); });
+    EXPECT_EQ(third.wait_for(std::chrono::milliseconds(200)), std::future_status::timeout);
+
+    // Finishing gives up on the waiting frame and reports the missing one
+    EXPECT_FALSE(encoder.finish());
+    EXPECT_FALSE(third.get());
+    EXPECT_EQ(encoder.getStats().framesWritten, 0);
+    std::remove(settings.output.c_str());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "FramePipeline.hpp"
+#include "objects/BlackHole.hpp"
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+
+std::shared_ptr<const World> makeScene() {
+    World world;
+    world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+    return std::make_shared<const World>(world.snapshot());
+}
+
+// Polls until the render thread has finished a frame, or gives up after a few seconds
+const FramePipeline::Frame* waitForFrame(FramePipeline& pipeline) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (const FramePipeline::Frame* frame = pipeline.acquire()) return frame;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(FramePipelineTest, RendersSubmittedView) {
+    CpuRenderer renderer(2);
+    Accumulation accumulation;
+    FramePipeline pipeline(renderer, accumulation);
+
+    FramePipeline::Request request{ Camera(), makeScene(), 40, 24, {} };
+    pipeline.submit(request);
+    const FramePipeline::Frame* frame = waitForFrame(pipeline);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->stats.width, 40);
+    EXPECT_EQ(frame->stats.height, 24);
+    EXPECT_EQ(frame->texels.size(), 40u * 24u);
+    EXPECT_EQ(frame->format, CpuRenderer::DisplayFormat::RGBA8);
+
+    // A new size in the next request reaches the frames that follow
+    request.width = 20;
+    pipeline.submit(request);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (frame->stats.width != 20 && std::chrono::steady_clock::now() < deadline) {
+        if (const FramePipeline::Frame* next = waitForFrame(pipeline)) frame = next;
+    }
+    EXPECT_EQ(frame->stats.width, 20);
+    EXPECT_EQ(frame->texels.size(), 20u * 24u);
+}
+
+TEST(FramePipelineTest, StopsOnceConverged) {
+    CpuRenderer renderer(2);
+    Accumulation accumulation;
+    FramePipeline pipeline(renderer, accumulation, 1);
+
+    FramePipeline::Request request{ Camera(), makeScene(), 16, 16, {} };
+    request.settings.progressive = true;
+    request.settings.maxSamples = 3;
+    pipeline.submit(request);
+
+    // Depth 1 hands over every sample, the last one being the converged image
+    for (int sample = 1; sample <= 3; ++sample) {
+        const FramePipeline::Frame* frame = waitForFrame(pipeline);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->stats.sampleCount, sample);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(pipeline.acquire(), nullptr);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "GeodesicPacket.hpp"
+#include <cmath>
+#include <vector>
+
+using GeodesicPacket::Isa;
+
+namespace {
+
+// A fan of rays around the default black hole: some captured, some crossing the disk, most escaping
+struct RayFan {
+    glm::vec3 origin = glm::vec3(0.0f, 0.0f, 3.0f);
+    std::vector<float> x, y, z;
+
+    explicit RayFan(int count) {
+        for (int k = 0; k < count; ++k) {
+            float u = (k % 37) / 36.0f - 0.5f;
+            float v = (k / 37) / 36.0f - 0.5f;
+            glm::vec3 d = glm::normalize(glm::vec3(u * 0.6f, v * 0.6f - 0.2f, -1.0f));
+            x.push_back(d.x);
+            y.push_back(d.y);
+            z.push_back(d.z);
+        }
+    }
+};
+
+const Geodesic::BlackHoleData kBlackHole{ glm::vec3(0.0f, -10.0f, -50.0f), 1.0f, 3.0f, 9.0f };
+
+} // namespace
+
+TEST(GeodesicPacketTest, DetectedIsaIsSupported) {
+    Isa isa = GeodesicPacket::detectIsa();
+    EXPECT_TRUE(GeodesicPacket::isSupported(isa));
+    EXPECT_TRUE(GeodesicPacket::isSupported(Isa::Scalar));
+    EXPECT_GE(GeodesicPacket::laneCount(isa), 1);
+}
+
+TEST(GeodesicPacketTest, ParsesIsaNames) {
+    Isa isa = Isa::Scalar;
+    EXPECT_TRUE(GeodesicPacket::parseIsa("avx2", isa));
+    EXPECT_EQ(isa, Isa::AVX2);
+    EXPECT_FALSE(GeodesicPacket::parseIsa("neon", isa));
+}
+
+TEST(GeodesicPacketTest, SimdMatchesScalar) {
+    // Odd count so every ISA also runs a partially filled packet
+    RayFan fan(37 * 37);
+    int count = static_cast<int>(fan.x.size());
+
+    for (auto integrator : { Geodesic::Integrator::Newtonian, Geodesic::Integrator::Schwarzschild }) {
+        Geodesic::MarchParams params;
+        params.integrator = integrator;
+
+        std::vector<float> reference(count * 3);
+        uint64_t referenceSkipped = 0;
+        GeodesicPacket::traceRays(Isa::Scalar, fan.origin, fan.x.data(), fan.y.data(), fan.z.data(), count,
+                                  &kBlackHole, 1, reference.data(), params, Geodesic::Sky(),
+                                  &referenceSkipped);
+        // The fan is wider than the hole's influence sphere
+        EXPECT_GT(referenceSkipped, 0u);
+        EXPECT_LT(referenceSkipped, static_cast<uint64_t>(count));
+
+        for (Isa isa : { Isa::SSE41, Isa::AVX2, Isa::AVX512 }) {
+            if (!GeodesicPacket::isSupported(isa)) continue;
+
+            std::vector<float> result(count * 3);
+            uint64_t skipped = 0;
+            GeodesicPacket::traceRays(isa, fan.origin, fan.x.data(), fan.y.data(), fan.z.data(), count,
+                                      &kBlackHole, 1, result.data(), params, Geodesic::Sky(), &skipped);
+            EXPECT_EQ(skipped, referenceSkipped) << GeodesicPacket::isaName(isa);
+
+            // Rounding differences may flip a star hash or a disk sample on a handful of rays
+            int mismatches = 0;
+            for (int k = 0; k < count * 3; ++k) {
+                if (std::abs(result[k] - reference[k]) > 1e-2f) mismatches++;
+            }
+            EXPECT_LT(mismatches, count * 3 / 100)
+                << GeodesicPacket::isaName(isa) << (integrator == Geodesic::Integrator::Newtonian ? " Newtonian" : " RK45");
+        }
+    }
+}
+
+TEST(GeodesicPacketTest, SkippedCountMatchesAcrossIsas) {
+    // In an empty scene every ray escapes without a step, but only the
+    // bounding spheres skip rays
+    RayFan fan(37 * 5);
+    int count = static_cast<int>(fan.x.size());
+
+    for (bool boundingSpheres : { false, true }) {
+        Geodesic::MarchParams params;
+        params.integrator = Geodesic::Integrator::Schwarzschild;
+        params.boundingSpheres = boundingSpheres;
+        uint64_t expected = boundingSpheres ? static_cast<uint64_t>(count) : 0u;
+
+        for (Isa isa : { Isa::Scalar, Isa::SSE41, Isa::AVX2, Isa::AVX512 }) {
+            if (!GeodesicPacket::isSupported(isa)) continue;
+
+            std::vector<float> result(count * 3);
+            uint64_t skipped = 0;
+            GeodesicPacket::traceRays(isa, fan.origin, fan.x.data(), fan.y.data(), fan.z.data(), count,
+                                      nullptr, 0, result.data(), params, Geodesic::Sky(), &skipped);
+            EXPECT_EQ(skipped, expected) << GeodesicPacket::isaName(isa)
+                                         << (boundingSpheres ? " with" : " without") << " bounding spheres";
+        }
+    }
+}
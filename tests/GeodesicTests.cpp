@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "Geodesic.hpp"
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+#include <glm/glm.hpp>
+#include <cmath>
+
+TEST(GeodesicTest, HashIsInUnitRange) {
+    for (int i = 0; i < 100; ++i) {
+        float h = Geodesic::hash(glm::vec3(i * 1.7f, i * -0.3f, i * 11.0f));
+        EXPECT_GE(h, 0.0f);
+        EXPECT_LT(h, 1.0f);
+    }
+}
+
+TEST(GeodesicTest, EmptySceneReturnsStarfield) {
+    glm::vec3 dir = glm::normalize(glm::vec3(0.3f, 0.2f, -1.0f));
+    for (auto integrator : { Geodesic::Integrator::Newtonian, Geodesic::Integrator::Schwarzschild }) {
+        for (bool boundingSpheres : { true, false }) {
+            Geodesic::MarchParams params;
+            params.integrator = integrator;
+            params.boundingSpheres = boundingSpheres;
+            glm::vec3 color = Geodesic::traceGeodesic(glm::vec3(0.0f), dir, nullptr, 0, nullptr, params);
+
+            // The RK45 path renormalizes its final direction
+            bool marched = !boundingSpheres && integrator == Geodesic::Integrator::Schwarzschild;
+            glm::vec3 sky = Geodesic::getStarfield(marched ? glm::normalize(dir) : dir);
+            EXPECT_FLOAT_EQ(color.r, sky.r);
+            EXPECT_FLOAT_EQ(color.g, sky.g);
+            EXPECT_FLOAT_EQ(color.b, sky.b);
+        }
+    }
+}
+
+TEST(GeodesicTest, RayIntoHorizonIsBlack) {
+    // Fall straight down the pole so the ray never crosses the disk
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, -10.0f, 0.0f), 1.0f, 3.0f, 9.0f };
+    glm::vec3 color = Geodesic::traceGeodesic(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), &bh, 1);
+    EXPECT_FLOAT_EQ(color.r, 0.0f);
+    EXPECT_FLOAT_EQ(color.g, 0.0f);
+    EXPECT_FLOAT_EQ(color.b, 0.0f);
+}
+
+TEST(GeodesicTest, DiskCrossingAddsGlow) {
+    // Cross the disk plane between the inner and outer radius
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, -10.0f, 0.0f), 1.0f, 3.0f, 9.0f };
+    glm::vec3 color = Geodesic::traceGeodesic(glm::vec3(6.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), &bh, 1);
+    EXPECT_GT(color.r, 0.0f);
+}
+
+TEST(GeodesicTest, DiskGlowIsIndependentOfStepLength) {
+    // A hole too light to bend the ray, so it falls straight through the slab at r = 6:
+    // the density integrates to 2 * DISK_HALF_THICKNESS whether the slab takes many steps or a fraction of one
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f), 1e-6f, 3.0f, 9.0f };
+    glm::vec3 expected = glm::mix(glm::vec3(1.0f, 0.8f, 0.5f), glm::vec3(0.8f, 0.2f, 0.1f), 0.5f)
+                       * (2.0f * Geodesic::DISK_HALF_THICKNESS);
+    for (auto integrator : { Geodesic::Integrator::Newtonian, Geodesic::Integrator::Schwarzschild }) {
+        for (float stepFactor : { 0.001f, 0.5f }) {
+            Geodesic::MarchParams params;
+            params.integrator = integrator;
+            params.stepFactor = stepFactor;
+            params.maxSteps = 2000;
+            params.boundingSpheres = false;
+            Geodesic::RayState ray{ glm::vec3(6.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f) };
+            params.maxDistance = 2.0f;
+            Geodesic::march(ray, &bh, 1, params);
+            EXPECT_NEAR(ray.accumColor.r, expected.r, 1e-4f);
+            EXPECT_NEAR(ray.accumColor.g, expected.g, 1e-4f);
+            EXPECT_NEAR(ray.accumColor.b, expected.b, 1e-4f);
+        }
+    }
+}
+
+TEST(GeodesicTest, GatherBlackHolesSkipsOtherObjects) {
+    World world;
+    world.add(Object(glm::vec3(1.0f)));
+    world.add(BlackHole(glm::vec3(0.0f, -10.0f, -50.0f), 0.5f));
+
+    auto blackHoles = Geodesic::gatherBlackHoles(world);
+    ASSERT_EQ(blackHoles.size(), 1u);
+    EXPECT_FLOAT_EQ(blackHoles[0].rs, 1.0f);
+    EXPECT_FLOAT_EQ(blackHoles[0].diskInner, 3.0f);
+    EXPECT_FLOAT_EQ(blackHoles[0].diskOuter, 9.0f);
+}
+
+namespace {
+
+// Bare hole at the origin: no disk, so only the bending is measured
+const Geodesic::BlackHoleData kBareHole{ glm::vec3(0.0f), 1.0f, 0.0f, 0.0f };
+
+// Fires a ray along -z past the hole at impact parameter b and returns the final state
+Geodesic::StepResult marchPast(float b, Geodesic::RayState& ray) {
+    ray = { glm::vec3(b, 0.0f, 4000.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f) };
+    Geodesic::MarchParams params;
+    params.maxSteps = 2000;
+    return Geodesic::march(ray, &kBareHole, 1, params);
+}
+
+} // namespace
+
+TEST(GeodesicTest, SchwarzschildWeakFieldDeflection) {
+    // Light passing at b >> rs is bent by 2 rs / b
+    for (float b : { 20.0f, 50.0f }) {
+        Geodesic::RayState ray;
+        ASSERT_EQ(marchPast(b, ray), Geodesic::StepResult::Escaped);
+        float deflection = std::atan2(-ray.dir.x, -ray.dir.z);
+        EXPECT_NEAR(deflection, 2.0f / b, 0.1f * 2.0f / b) << "b = " << b;
+    }
+}
+
+TEST(GeodesicTest, SchwarzschildCaptureThreshold) {
+    // Photons are captured below the critical impact parameter 3 * sqrt(3) / 2 * rs
+    Geodesic::RayState ray;
+    EXPECT_EQ(marchPast(2.4f, ray), Geodesic::StepResult::Captured);
+    EXPECT_EQ(marchPast(2.8f, ray), Geodesic::StepResult::Escaped);
+}
+
+TEST(GeodesicTest, RayMissingInfluenceSpheresIsSkipped) {
+    Geodesic::BlackHoleData bh{ glm::vec3(0.0f, -10.0f, -50.0f), 1.0f, 3.0f, 9.0f };
+    glm::vec3 ro(0.0f, 0.0f, 3.0f);
+    glm::vec3 rd = glm::normalize(glm::vec3(1.0f, 0.5f, -0.2f));
+
+    for (auto integrator : { Geodesic::Integrator::Newtonian, Geodesic::Integrator::Schwarzschild }) {
+        Geodesic::MarchParams params;
+        params.integrator = integrator;
+
+        Geodesic::RayState skipped{ ro, rd, glm::vec3(0.0f) };
+        EXPECT_LT(Geodesic::skipToInfluence(skipped, &bh, 1, params), 0.0f);
+        int steps = -1;
+        Geodesic::traceGeodesic(ro, rd, &bh, 1, &steps, params);
+        EXPECT_EQ(steps, 0);
+
+        // The analytic bend agrees with marching the whole way, up to the Newtonian marcher's own step error
+        Geodesic::RayState marched{ ro, rd, glm::vec3(0.0f) };
+        ASSERT_EQ(Geodesic::march(marched, &bh, 1, params), Geodesic::StepResult::Escaped);
+        float bend = glm::length(marched.dir - rd);
+        EXPECT_GT(bend, 0.01f);
+        EXPECT_LT(glm::length(skipped.dir - marched.dir), 0.1f * bend);
+    }
+}
+
+TEST(GeodesicTest, SkipJumpsToInfluenceSphere) {
+    for (float b : { 5.0f, 15.0f }) {
+        Geodesic::RayState ray{ glm::vec3(b, 0.0f, 4000.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f) };
+        float distance = Geodesic::skipToInfluence(ray, &kBareHole, 1);
+        ASSERT_GT(distance, 0.0f);
+        EXPECT_NEAR(glm::length(ray.p), Geodesic::influenceRadius(kBareHole), 0.1f);
+
+        // Marching on from the sphere ends up where marching the whole way does
+        Geodesic::RayState full;
+        ASSERT_EQ(marchPast(b, full), Geodesic::StepResult::Escaped);
+        Geodesic::MarchParams params;
+        params.maxSteps = 2000;
+        ASSERT_EQ(Geodesic::march(ray, &kBareHole, 1, params), Geodesic::StepResult::Escaped);
+        float deflection = std::atan2(-ray.dir.x, -ray.dir.z);
+        float reference = std::atan2(-full.dir.x, -full.dir.z);
+        EXPECT_NEAR(deflection, reference, 0.02f * reference);
+    }
+
+    // Starting inside a sphere there is nothing to skip
+    Geodesic::RayState inside{ glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f) };
+    EXPECT_FLOAT_EQ(Geodesic::skipToInfluence(inside, &kBareHole, 1), 0.0f);
+    EXPECT_EQ(inside.p, glm::vec3(0.0f, 0.0f, 10.0f));
+}
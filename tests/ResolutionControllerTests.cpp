@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "ResolutionController.hpp"
+
+namespace {
+
+// Render time of a frame whose full-resolution cost is fullMs
+float simulatedMs(float fullMs, float scale) {
+    return fullMs * scale * scale;
+}
+
+float runFrames(ResolutionController& controller, float fullMs, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        controller.update(simulatedMs(fullMs, controller.getScale()));
+    }
+    return controller.getScale();
+}
+
+} // namespace
+
+TEST(ResolutionControllerTest, StaysAtFullResolutionWithinBudget) {
+    ResolutionController controller;
+    controller.setTargetFrameMs(16.0f);
+    EXPECT_FLOAT_EQ(runFrames(controller, 8.0f, 200), 1.0f);
+    EXPECT_EQ(controller.getLastDecision(), ResolutionController::Decision::Hold);
+}
+
+TEST(ResolutionControllerTest, ScalesDownUnderLoad) {
+    ResolutionController controller;
+    controller.setTargetFrameMs(16.0f);
+    float scale = runFrames(controller, 64.0f, 200);
+
+    EXPECT_LT(scale, 1.0f);
+    EXPECT_LE(simulatedMs(64.0f, scale), 16.0f);
+    // Not needlessly blurry: one step up would blow the budget
+    EXPECT_GT(simulatedMs(64.0f, scale + 2 * ResolutionController::SCALE_STEP), 16.0f);
+}
+
+TEST(ResolutionControllerTest, RecoversWhenLoadDrops) {
+    ResolutionController controller;
+    controller.setTargetFrameMs(16.0f);
+    runFrames(controller, 64.0f, 200);
+    ASSERT_LT(controller.getScale(), 1.0f);
+
+    EXPECT_FLOAT_EQ(runFrames(controller, 4.0f, 1000), 1.0f);
+    EXPECT_EQ(controller.getLastDecision(), ResolutionController::Decision::ScaleUp);
+}
+
+TEST(ResolutionControllerTest, RespectsMinimumScale) {
+    ResolutionController controller;
+    controller.setTargetFrameMs(16.0f);
+    controller.setScaleRange(0.5f, 1.0f);
+    EXPECT_FLOAT_EQ(runFrames(controller, 1000.0f, 200), 0.5f);
+
+    glm::ivec2 size = controller.apply(1920, 1080);
+    EXPECT_EQ(size.x, 960);
+    EXPECT_EQ(size.y, 540);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "SceneFile.hpp"
+#include "World.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("scenefile_test_" + name)).string();
+}
+
+void writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+}
+
+void expectSameScene(const World& a, const World& b) {
+    ASSERT_EQ(a.getBlackHoles().size(), b.getBlackHoles().size());
+    ASSERT_EQ(a.getObjects().size(), b.getObjects().size());
+    for (size_t i = 0; i < a.getBlackHoles().size(); ++i) {
+        EXPECT_EQ(a.getBlackHoles().positions()[i], b.getBlackHoles().positions()[i]);
+        EXPECT_EQ(a.getBlackHoles().masses()[i], b.getBlackHoles().masses()[i]);
+        EXPECT_EQ(a.getBlackHoles().schwarzschildRadii()[i], b.getBlackHoles().schwarzschildRadii()[i]);
+        EXPECT_EQ(a.getBlackHoles().diskInner()[i], b.getBlackHoles().diskInner()[i]);
+        EXPECT_EQ(a.getBlackHoles().diskOuter()[i], b.getBlackHoles().diskOuter()[i]);
+    }
+    for (size_t i = 0; i < a.getObjects().size(); ++i) {
+        EXPECT_EQ(a.getObjects().positions()[i], b.getObjects().positions()[i]);
+    }
+}
+
+} // namespace
+
+TEST(SceneFileTest, ParsesTextScenes) {
+    std::string path = tempPath("parse.scene");
+    writeFile(path, "# Comment\n"
+                    "blackhole 0 -10 -50 0.5\n"
+                    "\n"
+                    "blackhole 1 2 3 0.8 4 16  # Explicit disk\n"
+                    "object 7 8 9\n");
+
+    World world;
+    ASSERT_TRUE(SceneFile::load(path, world));
+    const BlackHolePool& blackHoles = world.getBlackHoles();
+    ASSERT_EQ(blackHoles.size(), 2u);
+    EXPECT_EQ(blackHoles.positions()[0], glm::vec3(0.0f, -10.0f, -50.0f));
+    EXPECT_FLOAT_EQ(blackHoles.schwarzschildRadii()[0], 1.0f);
+    EXPECT_FLOAT_EQ(blackHoles.diskOuter()[0], 9.0f); // Default disk
+    EXPECT_FLOAT_EQ(blackHoles.diskInner()[1], 4.0f);
+    EXPECT_FLOAT_EQ(blackHoles.diskOuter()[1], 16.0f);
+    ASSERT_EQ(world.getObjects().size(), 1u);
+    EXPECT_EQ(world.getObjects().positions()[0], glm::vec3(7.0f, 8.0f, 9.0f));
+    std::remove(path.c_str());
+}
+
+TEST(SceneFileTest, RejectsMalformedText) {
+    std::string path = tempPath("bad.scene");
+    for (const char* contents : { "blackhole 0 0 0\n", "blackhole 0 0 0 1 2\n", "object 1 2 x\n", "star 1 2 3\n" }) {
+        writeFile(path, contents);
+        World world;
+        EXPECT_FALSE(SceneFile::loadText(path, world)) << contents;
+    }
+    World world;
+    EXPECT_FALSE(SceneFile::load(tempPath("missing.scene"), world));
+    std::remove(path.c_str());
+}
+
+TEST(SceneFileTest, ReadsTextLines) {
+    std::istringstream in("# header\n\nkey 1 2.5 # trailing\n  object x 3\n");
+    SceneFile::TextLine line;
+
+    ASSERT_TRUE(SceneFile::readTextLine(in, line));
+    EXPECT_EQ(line.number, 3);
+    EXPECT_EQ(line.keyword, "key");
+    EXPECT_EQ(line.values, (std::vector<float>{ 1.0f, 2.5f }));
+    EXPECT_TRUE(line.numeric);
+
+    ASSERT_TRUE(SceneFile::readTextLine(in, line));
+    EXPECT_EQ(line.number, 4);
+    EXPECT_EQ(line.keyword, "object");
+    EXPECT_EQ(line.values.size(), 2u);
+    EXPECT_FALSE(line.numeric);
+
+    EXPECT_FALSE(SceneFile::readTextLine(in, line));
+}
+
+TEST(SceneFileTest, TextAndBinaryRoundTrip) {
+    World world;
+    world.add(BlackHole(glm::vec3(0.1f, -10.0f, -50.0f), 0.5f));
+    world.add(BlackHole(glm::vec3(14.0f, -6.0f, -75.3f), 0.8f, 4.0f, 16.0f));
+    for (int i = 0; i < 1000; ++i) {
+        world.add(Object(glm::vec3(i * 0.37f, -i * 1.1f, 1.0f / (i + 1))));
+    }
+
+    std::string text = tempPath("roundtrip.scene");
+    std::string binary = tempPath("roundtrip.bscene");
+    ASSERT_TRUE(SceneFile::saveText(text, world));
+    ASSERT_TRUE(SceneFile::saveBinary(binary, world));
+    EXPECT_FALSE(SceneFile::isBinary(text));
+    EXPECT_TRUE(SceneFile::isBinary(binary));
+
+    World fromText;
+    ASSERT_TRUE(SceneFile::load(text, fromText));
+    expectSameScene(world, fromText);
+
+    World fromBinary;
+    ASSERT_TRUE(SceneFile::load(binary, fromBinary));
+    expectSameScene(world, fromBinary);
+
+    // Loading appends, and loaded objects get working handles
+    ASSERT_TRUE(SceneFile::loadBinary(binary, fromBinary));
+    EXPECT_EQ(fromBinary.getObjects().size(), 2000u);
+    ObjectHandle handle = fromBinary.getObjects().handleAt(1500);
+    EXPECT_TRUE(fromBinary.remove(handle));
+    EXPECT_EQ(fromBinary.getObjects().size(), 1999u);
+
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+}
+
+TEST(SceneFileTest, RejectsTruncatedBinary) {
+    World world;
+    world.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    for (int i = 0; i < 100; ++i) world.add(Object(glm::vec3((float)i)));
+    std::string path = tempPath("truncated.bscene");
+    ASSERT_TRUE(SceneFile::saveBinary(path, world));
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 16);
+    World loaded;
+    EXPECT_FALSE(SceneFile::loadBinary(path, loaded));
+    EXPECT_EQ(loaded.size(), 0u);
+
+    std::filesystem::resize_file(path, 20);
+    EXPECT_FALSE(SceneFile::loadBinary(path, loaded));
+    std::remove(path.c_str());
+}
+
+TEST(SceneFileTest, EmptySceneRoundTrips) {
+    World world;
+    std::string path = tempPath("empty.bscene");
+    ASSERT_TRUE(SceneFile::saveBinary(path, world));
+    World loaded;
+    EXPECT_TRUE(SceneFile::load(path, loaded));
+    EXPECT_EQ(loaded.size(), 0u);
+    std::remove(path.c_str());
+}
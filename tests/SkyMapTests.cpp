@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "SkyMap.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <string>
+
+namespace {
+
+std::string tempDirectory(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("skymap_test_" + name);
+    std::filesystem::remove_all(path);
+    return path.string();
+}
+
+glm::vec3 direction(int i) {
+    // Spread over the sphere, including the face edges and corners
+    float z = 1.0f - 2.0f * (i + 0.5f) / 200.0f;
+    float phi = 2.39996323f * i;
+    float r = std::sqrt(1.0f - z * z);
+    return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+bool sameTexels(const SkyMap& a, const SkyMap& b) {
+    if (a.getFaceSize() != b.getFaceSize() || a.getLevelCount() != b.getLevelCount()) return false;
+    for (int level = 0; level < a.getLevelCount(); ++level) {
+        size_t count = static_cast<size_t>(SkyMap::FACES) * a.getLevelSize(level) * a.getLevelSize(level) * 3;
+        if (!std::equal(a.getLevel(level), a.getLevel(level) + count, b.getLevel(level))) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(SkyMapTest, MatchesProceduralNebula) {
+    // Without stars the sky is smooth enough for the map to reproduce it
+    Geodesic::SkyParams params;
+    params.starDensity = 1.0f;
+    ThreadPool pool(2);
+    SkyMap map(params, 256, &pool);
+    EXPECT_EQ(map.getFaceSize(), 256);
+    EXPECT_EQ(map.getLevelCount(), 9);
+
+    for (int i = 0; i < 200; ++i) {
+        glm::vec3 dir = direction(i);
+        glm::vec3 expected = Geodesic::getStarfield(dir, params);
+        glm::vec3 actual = map.sample(dir);
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_NEAR(actual[c], expected[c], 0.02f) << "direction " << i;
+        }
+    }
+}
+
+TEST(SkyMapTest, RoundsFaceSizeAndSamplesTexelCentres) {
+    SkyMap map(Geodesic::SkyParams(), 12);
+    ASSERT_EQ(map.getFaceSize(), 16);
+    ASSERT_EQ(map.getLevelCount(), 5);
+
+    // Face +Z: s runs along +x and t along -y, texel (x, y) is centred at
+    // s = (x + 0.5) / n, t = (y + 0.5) / n
+    const int n = map.getFaceSize();
+    const float* face = map.getLevel(0) + static_cast<size_t>(4) * n * n * 3;
+    for (int y = 0; y < n; y += 5) {
+        for (int x = 0; x < n; x += 3) {
+            float sc = 2.0f * (x + 0.5f) / n - 1.0f;
+            float tc = 2.0f * (y + 0.5f) / n - 1.0f;
+            glm::vec3 color = map.sample(glm::normalize(glm::vec3(sc, -tc, 1.0f)));
+            const float* texel = face + (static_cast<size_t>(y) * n + x) * 3;
+            EXPECT_NEAR(color.r, texel[0], 1e-5f);
+            EXPECT_NEAR(color.g, texel[1], 1e-5f);
+            EXPECT_NEAR(color.b, texel[2], 1e-5f);
+        }
+    }
+}
+
+TEST(SkyMapTest, LastLevelIsFaceAverage) {
+    SkyMap map(Geodesic::SkyParams(), 16);
+    const int n = map.getFaceSize();
+    const int last = map.getLevelCount() - 1;
+    ASSERT_EQ(map.getLevelSize(last), 1);
+
+    for (int face = 0; face < SkyMap::FACES; ++face) {
+        glm::vec3 mean(0.0f);
+        const float* texels = map.getLevel(0) + static_cast<size_t>(face) * n * n * 3;
+        for (int i = 0; i < n * n; ++i) {
+            mean += glm::vec3(texels[i * 3], texels[i * 3 + 1], texels[i * 3 + 2]);
+        }
+        mean /= static_cast<float>(n * n);
+        const float* average = map.getLevel(last) + face * 3;
+        for (int c = 0; c < 3; ++c) {
+            // Every level is rounded to half precision
+            EXPECT_NEAR(average[c], mean[c], 1e-3f + mean[c] * 5e-3f);
+        }
+    }
+
+    // Past the last level the lookup stays on it
+    glm::vec3 dir(0.0f, 0.0f, 1.0f);
+    EXPECT_EQ(map.sample(dir, static_cast<float>(last)), map.sample(dir, 100.0f));
+}
+
+TEST(SkyMapTest, CacheReusesBakedMaps) {
+    std::string directory = tempDirectory("cache");
+    Geodesic::SkyParams params;
+    params.nebulaIntensity = 0.5f;
+
+    SkyCache cache(directory);
+    auto first = cache.get(params, 32);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(cache.get(params, 32), first);
+    ASSERT_TRUE(std::filesystem::exists(cache.pathFor(params, 32)));
+
+    // A new cache finds the saved map instead of baking it again
+    SkyCache reloaded(directory);
+    auto loaded = reloaded.get(params, 32);
+    ASSERT_NE(loaded, first);
+    EXPECT_TRUE(sameTexels(*first, *loaded));
+
+    // Other settings get their own map
+    Geodesic::SkyParams other = params;
+    other.starDensity = 0.99f;
+    EXPECT_NE(cache.pathFor(other, 32), cache.pathFor(params, 32));
+    auto changed = cache.get(other, 32);
+    EXPECT_EQ(changed->getParams(), other);
+    EXPECT_FALSE(sameTexels(*first, *changed));
+
+    // and a file is only accepted for the settings it was baked with
+    EXPECT_EQ(SkyMap::load(cache.pathFor(params, 32), other, 32), nullptr);
+    EXPECT_EQ(SkyMap::load(cache.pathFor(params, 32), params, 64), nullptr);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(SkyMapTest, TruncatedCacheFileIsRebaked) {
+    std::string directory = tempDirectory("truncated");
+    Geodesic::SkyParams params;
+    SkyCache cache(directory);
+    auto baked = cache.get(params, 16);
+    std::string path = cache.pathFor(params, 16);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+    EXPECT_EQ(SkyMap::load(path, params, 16), nullptr);
+
+    SkyCache fresh(directory);
+    auto rebaked = fresh.get(params, 16);
+    ASSERT_NE(rebaked, nullptr);
+    EXPECT_TRUE(sameTexels(*baked, *rebaked));
+    EXPECT_NE(SkyMap::load(path, params, 16), nullptr);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(SkyMapTest, EscapedRaysSampleTheMap) {
+    SkyMap map(Geodesic::SkyParams(), 32);
+    Geodesic::Sky sky{ &map, 1.5f, Geodesic::SkyParams() };
+    for (int i = 0; i < 20; ++i) {
+        glm::vec3 dir = direction(i * 10);
+        glm::vec3 color = Geodesic::traceGeodesic(glm::vec3(0.0f), dir, nullptr, 0, nullptr,
+                                                  Geodesic::MarchParams(), sky);
+        EXPECT_EQ(color, map.sample(dir, 1.5f));
+    }
+
+    // Without a map the procedural sky is used
+    Geodesic::Sky procedural;
+    glm::vec3 dir = direction(3);
+    EXPECT_EQ(procedural.sample(dir), Geodesic::getStarfield(dir));
+}
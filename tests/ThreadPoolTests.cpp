@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <vector>
+
+TEST(ThreadPoolTest, RunsEveryIndexExactlyOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1001);
+
+    pool.parallelFor(static_cast<int>(hits.size()), [&](int index, int worker) {
+        EXPECT_GE(worker, 0);
+        EXPECT_LT(worker, 4);
+        hits[index]++;
+    });
+
+    for (const auto& hit : hits) {
+        EXPECT_EQ(hit.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, ReusesWorkersAcrossJobs) {
+    ThreadPool pool(3);
+    std::atomic<int> total{ 0 };
+
+    for (int job = 0; job < 50; ++job) {
+        pool.parallelFor(10, [&](int, int) { total++; });
+    }
+    EXPECT_EQ(total.load(), 500);
+}
+
+TEST(ThreadPoolTest, EmptyJobReturnsImmediately) {
+    ThreadPool pool(2);
+    bool called = false;
+    pool.parallelFor(0, [&](int, int) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+TEST(ThreadPoolTest, IdleWorkersStealFromBusyOnes) {
+    ThreadPool pool(2);
+    std::atomic<int> workerOneItems{ 0 };
+
+    // Worker 0 owns the even indices and stalls on index 0; worker 1 should
+    // take over the remaining even indices from the back of worker 0's queue
+    pool.parallelFor(20, [&](int index, int worker) {
+        if (index == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (worker == 1) workerOneItems++;
+    });
+    EXPECT_GT(workerOneItems.load(), 10);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <thread>
+
+TEST(TripleBufferTest, ConsumerSeesNewestValue) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.write() = 1;
+    buffer.publish();
+    buffer.write() = 2;
+    buffer.publish();
+    EXPECT_TRUE(buffer.hasPending());
+
+    // The unread 1 was replaced
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.read(), 2);
+    EXPECT_FALSE(buffer.hasPending());
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.read(), 2);
+}
+
+TEST(TripleBufferTest, ValuesArriveWholeAndInOrder) {
+    // Each value is written in two halves; a torn read would see them differ
+    struct Pair {
+        int first = 0;
+        int second = 0;
+    };
+    TripleBuffer<Pair> buffer;
+    constexpr int COUNT = 100000;
+
+    std::thread producer([&] {
+        for (int i = 1; i <= COUNT; ++i) {
+            buffer.write().first = i;
+            buffer.write().second = i;
+            buffer.publish();
+        }
+    });
+
+    int last = 0;
+    while (last < COUNT) {
+        if (!buffer.update()) continue;
+        const Pair& value = buffer.read();
+        ASSERT_EQ(value.first, value.second);
+        ASSERT_GT(value.first, last);
+        last = value.first;
+    }
+    producer.join();
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "World.hpp"
+#include "objects/BlackHole.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+
+TEST(WorldTest, RevisionChangesOnEdit) {
+    World world;
+    uint64_t initial = world.getRevision();
+
+    BlackHoleHandle handle = world.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    uint64_t afterAdd = world.getRevision();
+    EXPECT_NE(afterAdd, initial);
+
+    world.markChanged();
+    uint64_t afterMark = world.getRevision();
+    EXPECT_NE(afterMark, afterAdd);
+
+    world.update(handle, BlackHole(glm::vec3(1.0f), 1.0f));
+    uint64_t afterUpdate = world.getRevision();
+    EXPECT_NE(afterUpdate, afterMark);
+
+    world.remove(handle);
+    uint64_t afterRemove = world.getRevision();
+    EXPECT_NE(afterRemove, afterUpdate);
+
+    world.clear();
+    EXPECT_NE(world.getRevision(), afterRemove);
+}
+
+TEST(WorldTest, RevisionStableWithoutEdits) {
+    World world;
+    BlackHoleHandle handle = world.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    uint64_t revision = world.getRevision();
+
+    EXPECT_TRUE(world.getBlackHoles().contains(handle));
+    EXPECT_EQ(world.getBlackHoles().size(), 1u);
+    // Failed edits are not changes
+    EXPECT_FALSE(world.remove(BlackHoleHandle()));
+    EXPECT_FALSE(world.update(BlackHoleHandle(), BlackHole(glm::vec3(0.0f), 1.0f)));
+    EXPECT_EQ(world.getRevision(), revision);
+}
+
+TEST(WorldTest, PoolsAreContiguousColumns) {
+    World world;
+    for (int i = 0; i < 100; ++i) {
+        world.add(BlackHole(glm::vec3((float)i, 0.0f, 0.0f), 0.5f + i));
+        world.add(Object(glm::vec3(0.0f, (float)i, 0.0f)));
+    }
+
+    const BlackHolePool& blackHoles = world.getBlackHoles();
+    ASSERT_EQ(blackHoles.size(), 100u);
+    EXPECT_EQ(world.getObjects().size(), 100u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(blackHoles.schwarzschildRadii()) % 64, 0u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(blackHoles.positions()[i].x, (float)i);
+        EXPECT_FLOAT_EQ(blackHoles.schwarzschildRadii()[i], 2.0f * (0.5f + i));
+        EXPECT_FLOAT_EQ(blackHoles.diskOuter()[i], 9.0f * blackHoles.schwarzschildRadii()[i]);
+        EXPECT_EQ(world.getObjects().positions()[i].y, (float)i);
+    }
+}
+
+TEST(WorldTest, HandlesSurviveRemoval) {
+    World world;
+    std::vector<BlackHoleHandle> handles;
+    for (int i = 0; i < 5; ++i) {
+        handles.push_back(world.add(BlackHole(glm::vec3((float)i), 1.0f)));
+    }
+
+    // The last hole moves into the gap, but every handle still finds its own
+    ASSERT_TRUE(world.remove(handles[1]));
+    const BlackHolePool& pool = world.getBlackHoles();
+    EXPECT_EQ(pool.size(), 4u);
+    EXPECT_FALSE(pool.contains(handles[1]));
+    EXPECT_FALSE(world.remove(handles[1]));
+    for (int i : { 0, 2, 3, 4 }) {
+        ASSERT_TRUE(pool.contains(handles[i]));
+        size_t index = pool.indexOf(handles[i]);
+        EXPECT_EQ(pool.positions()[index], glm::vec3((float)i));
+        EXPECT_EQ(pool.handleAt(index), handles[i]);
+    }
+
+    // A reused slot does not revive the old handle
+    BlackHoleHandle fresh = world.add(BlackHole(glm::vec3(9.0f), 2.0f));
+    EXPECT_EQ(fresh.slot, handles[1].slot);
+    EXPECT_FALSE(pool.contains(handles[1]));
+    EXPECT_EQ(pool.get(pool.indexOf(fresh)).mass, 2.0f);
+
+    ASSERT_TRUE(world.update(handles[4], BlackHole(glm::vec3(-1.0f), 3.0f, 10.0f, 20.0f)));
+    BlackHole updated = pool.get(pool.indexOf(handles[4]));
+    EXPECT_EQ(updated.position, glm::vec3(-1.0f));
+    EXPECT_FLOAT_EQ(updated.rs, 6.0f);
+    EXPECT_FLOAT_EQ(updated.diskInner, 10.0f);
+
+    world.clear();
+    EXPECT_TRUE(world.getBlackHoles().empty());
+    EXPECT_FALSE(world.getBlackHoles().contains(fresh));
+}
+
+TEST(WorldTest, SnapshotCopiesEveryColumn) {
+    World world;
+    world.add(BlackHole(glm::vec3(1.0f, 2.0f, 3.0f), 0.5f, 4.0f, 12.0f));
+    BlackHoleHandle removed = world.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    world.add(BlackHole(glm::vec3(-1.0f), 2.0f));
+    world.add(Object(glm::vec3(5.0f)));
+    world.remove(removed);
+
+    World copy = world.snapshot();
+    const BlackHolePool& original = world.getBlackHoles();
+    const BlackHolePool& copied = copy.getBlackHoles();
+    ASSERT_EQ(copied.size(), original.size());
+    ASSERT_EQ(copy.getObjects().size(), 1u);
+    for (size_t i = 0; i < original.size(); ++i) {
+        EXPECT_EQ(copied.positions()[i], original.positions()[i]);
+        EXPECT_EQ(copied.masses()[i], original.masses()[i]);
+        EXPECT_EQ(copied.schwarzschildRadii()[i], original.schwarzschildRadii()[i]);
+        EXPECT_EQ(copied.diskInner()[i], original.diskInner()[i]);
+        EXPECT_EQ(copied.diskOuter()[i], original.diskOuter()[i]);
+    }
+    EXPECT_EQ(copy.getObjects().positions()[0], glm::vec3(5.0f));
+}
+
+TEST(WorldTest, RevisionsIdentifyScenesAcrossWorlds) {
+    World first;
+    World second;
+    EXPECT_NE(first.getRevision(), second.getRevision());
+
+    // The same edits on two worlds still leave them told apart
+    first.add(BlackHole(glm::vec3(0.0f), 1.0f));
+    second.add(BlackHole(glm::vec3(1.0f), 1.0f));
+    EXPECT_NE(first.getRevision(), second.getRevision());
+
+    // A snapshot is the same scene
+    EXPECT_EQ(first.snapshot().getRevision(), first.getRevision());
+}